@@ -1,5 +1,8 @@
 #include <Victory.h>
 
+#include <cstdio>
+#include <string>
+
 class ExampleLayer : public Victory::Layer
 {
 public:
@@ -31,6 +34,68 @@ Victory::Application* Victory::CreateApplication(Victory::ApplicationCommandLine
 {
 	Victory::ApplicationSpecification spec;
 	spec.Name = "Victory Application";
+	spec.CommandLineArgs = args;
+
+	// --headless [--size 1920x1080] [--frames 100] [--output frame.ppm]
+	// --trace 60 [--trace-output trace.json]
+	// --pacing low-latency|throughput [--frames-in-flight 3] [--swapchain-images 3]
+	// --no-occlusion
+	// --lods 4 [--lod-error 1.0]
+	for (int i{ 1 }; i < args.Count; ++i)
+	{
+		const std::string arg{ args.Args[i] };
+		const bool hasValue{ i + 1 < args.Count };
+		if (arg == "--headless")
+		{
+			spec.RendererSpec.Headless = true;
+		}
+		else if (arg == "--size" && hasValue)
+		{
+			std::sscanf(args.Args[++i], "%ux%u", &spec.RendererSpec.Width, &spec.RendererSpec.Height);
+		}
+		else if (arg == "--frames" && hasValue)
+		{
+			spec.RendererSpec.FrameCount = static_cast<uint32_t>(std::stoul(args.Args[++i]));
+		}
+		else if (arg == "--output" && hasValue)
+		{
+			spec.RendererSpec.OutputPath = args.Args[++i];
+		}
+		else if (arg == "--pacing" && hasValue)
+		{
+			const std::string pacing{ args.Args[++i] };
+			spec.RendererSpec.Pacing = pacing == "low-latency" ? FramePacing::eLowLatency :
+				pacing == "throughput" ? FramePacing::eThroughput : FramePacing::eBalanced;
+		}
+		else if (arg == "--frames-in-flight" && hasValue)
+		{
+			spec.RendererSpec.FramesInFlight = static_cast<uint32_t>(std::stoul(args.Args[++i]));
+		}
+		else if (arg == "--swapchain-images" && hasValue)
+		{
+			spec.RendererSpec.SwapchainImageCount = static_cast<uint32_t>(std::stoul(args.Args[++i]));
+		}
+		else if (arg == "--no-occlusion")
+		{
+			spec.RendererSpec.OcclusionCulling = false;
+		}
+		else if (arg == "--lods" && hasValue)
+		{
+			spec.RendererSpec.MeshLodCount = static_cast<uint32_t>(std::stoul(args.Args[++i]));
+		}
+		else if (arg == "--lod-error" && hasValue)
+		{
+			spec.RendererSpec.LodErrorPixels = std::stof(args.Args[++i]);
+		}
+		else if (arg == "--trace" && hasValue)
+		{
+			spec.TraceFrameCount = static_cast<uint32_t>(std::stoul(args.Args[++i]));
+		}
+		else if (arg == "--trace-output" && hasValue)
+		{
+			spec.TracePath = args.Args[++i];
+		}
+	}
 
 	Victory::Application* app = new Victory::Application(spec);
 	app->PushLayer<ExampleLayer>();
@@ -1,20 +1,29 @@
 #version 450
 
-layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
+layout(set = 0, binding = 0) uniform UniformBufferObject {
     mat4 view;
     mat4 proj;
 } ubo;
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec2 inTexCoord;
+// Positions are unorm16 within the mesh bounds, offset and scale map them back
+struct InstanceData {
+    mat4 model;
+    vec4 positionOffset;
+    vec4 positionScale;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer InstanceBuffer {
+    InstanceData instances[];
+};
+
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec2 inTexCoord;
 
-layout(location = 0) out vec3 fragColor;
-layout(location = 1) out vec2 fragTexCoord;
+layout(location = 0) out vec2 fragTexCoord;
 
 void main() {
-	gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
-	fragColor = inColor;
+    InstanceData instance = instances[gl_InstanceIndex];
+    vec3 position = instance.positionOffset.xyz + inPosition.xyz * instance.positionScale.xyz;
+	gl_Position = ubo.proj * ubo.view * instance.model * vec4(position, 1.0);
     fragTexCoord = inTexCoord;
 }
\ No newline at end of file
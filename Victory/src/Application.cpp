@@ -4,6 +4,8 @@
 #include <stdexcept>
 
 #include "renderer/Renderer.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
 
 namespace Victory {
 
@@ -17,26 +19,40 @@ Application::Application(const ApplicationSpecification &applicationSpecificatio
         throw std::runtime_error("Application already exists");
     }
     
+    Profiler::Init();
+    ThreadPool::Init();
     s_Renderer = Renderer::CreateRenderer();
     s_Instance = this;
 }
 
 Application::~Application() {
     Renderer::CleanupRenderer();
+    ThreadPool::Cleanup();
+    Profiler::Cleanup();
 }
  
 void Application::Run() {
-    s_Renderer->Initialize(m_ApplicationSpec.Name);
+    Profiler* profiler{ Profiler::Init() };
+    profiler->RequestCapture(m_ApplicationSpec.TraceFrameCount, m_ApplicationSpec.TracePath);
+
+    s_Renderer->Initialize(m_ApplicationSpec.Name, m_ApplicationSpec.RendererSpec);
     while (s_Renderer->IsRunning())
     {
-        s_Renderer->PollEvents();
-        if (!s_Renderer->Resize()) {
-            s_Renderer->BeginFrame();
-            s_Renderer->RecordCommandBuffer();
-            s_Renderer->EndFrame();
+        profiler->BeginFrame();
+        {
+            VICTORY_PROFILE_ZONE("Frame");
+
+            s_Renderer->PollEvents();
+            if (!s_Renderer->Resize()) {
+                s_Renderer->BeginFrame();
+                s_Renderer->RecordCommandBuffer();
+                s_Renderer->EndFrame();
+            }
         }
+        profiler->EndFrame();
         // break;
     }
+    profiler->Flush();
     s_Renderer->Destroy();
 }
     
@@ -4,8 +4,7 @@
 #include <memory>
 
 #include "Layer.h"
-
-class Renderer;
+#include "renderer/Renderer.h"
 
 namespace Victory {
 
@@ -14,7 +13,7 @@ struct ApplicationCommandLineArgs {
 	char** Args{ nullptr };
 
 	const char* operator[](int index) const {
-        if(index < Count) {
+        if(index >= Count) {
             return nullptr;
         }
 		return Args[index];
@@ -24,6 +23,10 @@ struct ApplicationCommandLineArgs {
 struct ApplicationSpecification {
 	const char* Name = "Victory Application";
 	ApplicationCommandLineArgs CommandLineArgs;
+	RendererSpecification RendererSpec;
+	// CPU zones of the first TraceFrameCount frames, loading included, go to TracePath
+	uint32_t TraceFrameCount{ 0 };
+	const char* TracePath{ "trace.json" };
 };
 
 class Application
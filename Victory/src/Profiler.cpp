@@ -0,0 +1,194 @@
+#include "Profiler.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace Victory {
+
+// Events past this are dropped until the next capture
+const static uint32_t s_EventsPerThread{ 1 << 16 };
+
+std::atomic<Profiler*> Profiler::s_Instance{ nullptr };
+std::atomic<bool> Profiler::s_Capturing{ false };
+std::atomic<uint32_t> Profiler::s_CaptureGeneration{ 0 };
+thread_local Profiler::ThreadEvents* Profiler::s_ThreadEvents{ nullptr };
+
+Profiler* Profiler::Init()
+{
+    Profiler* instance{ s_Instance.load(std::memory_order_acquire) };
+    if (instance)
+    {
+        return instance;
+    }
+
+    std::cout << "Init Profiler" << std::endl;
+    instance = new Profiler();
+    s_Instance.store(instance, std::memory_order_release);
+
+    return instance;
+}
+
+void Profiler::Cleanup()
+{
+    std::cout << "Cleanup Profiler" << std::endl;
+
+    s_Capturing.store(false, std::memory_order_relaxed);
+    delete s_Instance.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+Profiler::Profiler()
+    : m_Epoch{ std::chrono::steady_clock::now() } {}
+
+void Profiler::RequestCapture(uint32_t frameCount_, const std::string& path_)
+{
+    if (IsCapturing() || frameCount_ == 0)
+    {
+        return;
+    }
+
+    m_CapturePath = path_;
+    m_CaptureFrameCount = frameCount_;
+    m_CapturePending = true;
+
+    if (!m_InFrame)
+    {
+        StartCapture();
+    }
+}
+
+void Profiler::BeginFrame()
+{
+    m_InFrame = true;
+    if (m_CapturePending)
+    {
+        StartCapture();
+    }
+}
+
+void Profiler::EndFrame()
+{
+    m_InFrame = false;
+    if (!IsCapturing())
+    {
+        return;
+    }
+
+    if (++m_CapturedFrames == m_CaptureFrameCount)
+    {
+        WriteCapture();
+    }
+}
+
+void Profiler::Flush()
+{
+    if (IsCapturing())
+    {
+        WriteCapture();
+    }
+}
+
+void Profiler::Record(const char* name_, uint64_t beginNs_, uint64_t endNs_, uint32_t generation_)
+{
+    if (!IsCapturing() || generation_ != GetCaptureGeneration())
+    {
+        return;
+    }
+
+    ThreadEvents* thread{ s_ThreadEvents };
+    if (!thread)
+    {
+        thread = RegisterThread();
+    }
+
+    // First zone of this thread in the capture, events of an earlier one are dropped
+    if (thread->generation.load(std::memory_order_relaxed) != generation_)
+    {
+        thread->count.store(0, std::memory_order_relaxed);
+        thread->generation.store(generation_, std::memory_order_release);
+    }
+
+    // Only this thread writes count, the exporter reads it after the capture stopped
+    const uint32_t index{ thread->count.load(std::memory_order_relaxed) };
+    if (index == s_EventsPerThread)
+    {
+        return;
+    }
+
+    thread->events[index] = ProfileEvent{ name_, beginNs_, endNs_ };
+    thread->count.store(index + 1, std::memory_order_release);
+}
+
+uint64_t Profiler::Now() const
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - m_Epoch).count());
+}
+
+Profiler::ThreadEvents* Profiler::RegisterThread()
+{
+    // Once per thread, the buffer stays with the profiler after the thread exits
+    std::lock_guard lock{ m_ThreadsMutex };
+
+    ThreadEvents* thread{ m_Threads.emplace_back(std::make_unique<ThreadEvents>()).get() };
+    thread->threadId = static_cast<uint32_t>(m_Threads.size());
+    thread->events = std::make_unique<ProfileEvent[]>(s_EventsPerThread);
+
+    s_ThreadEvents = thread;
+    return thread;
+}
+
+void Profiler::StartCapture()
+{
+    // Threads empty their own buffers once they see the new generation
+    m_CapturedFrames = 0;
+    m_CapturePending = false;
+    s_CaptureGeneration.fetch_add(1, std::memory_order_acq_rel);
+    s_Capturing.store(true, std::memory_order_release);
+}
+
+void Profiler::WriteCapture()
+{
+    s_Capturing.store(false, std::memory_order_relaxed);
+
+    std::ofstream file(m_CapturePath, std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "Trace was not written: " << m_CapturePath << std::endl;
+        return;
+    }
+
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    uint64_t eventCount{ 0 };
+    const uint32_t generation{ GetCaptureGeneration() };
+    std::lock_guard lock{ m_ThreadsMutex };
+    for (auto&& thread : m_Threads)
+    {
+        // Threads that recorded nothing in this capture still hold an older one
+        if (thread->generation.load(std::memory_order_acquire) != generation)
+        {
+            continue;
+        }
+
+        const uint32_t count{ thread->count.load(std::memory_order_acquire) };
+        for (uint32_t i{ 0 }; i < count; ++i)
+        {
+            const ProfileEvent& event{ thread->events[i] };
+
+            // Complete events, timestamps in microseconds
+            file << (eventCount++ ? ",\n" : "\n")
+                << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->threadId
+                << ",\"ts\":" << static_cast<double>(event.beginNs) / 1000.0
+                << ",\"dur\":" << static_cast<double>(event.endNs - event.beginNs) / 1000.0 << "}";
+        }
+    }
+
+    file << "\n]}\n";
+
+    std::cout << "Trace of " << m_CapturedFrames << " frames, " << eventCount
+        << " zones written to " << m_CapturePath << std::endl;
+}
+
+} // namespace Victory
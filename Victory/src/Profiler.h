@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Victory {
+
+struct ProfileEvent
+{
+    const char* name;
+    uint64_t beginNs;
+    uint64_t endNs;
+};
+
+// CPU zones recorded into per-thread buffers while a capture runs and written
+// out as Chrome trace JSON, which chrome://tracing and Perfetto both open
+class Profiler
+{
+public:
+
+    // Creates the profiler on the main thread, before any other thread records zones
+    static Profiler* Init();
+    static void Cleanup();
+
+    // Null before Init and after Cleanup, what zones on any thread use
+    static inline Profiler* Get()
+    {
+        return s_Instance.load(std::memory_order_acquire);
+    }
+
+    // Records the next frameCount_ frames into path_. Outside of a frame the capture
+    // starts right away, so loading done before the first frame is included
+    void RequestCapture(uint32_t frameCount_, const std::string& path_);
+
+    // Frame boundaries of the application loop
+    void BeginFrame();
+    void EndFrame();
+
+    // Writes a capture that is still running, e.g. when the application closes early
+    void Flush();
+
+    // Lock free, every thread appends to its own buffer only. Zones opened in an
+    // earlier capture than the running one are dropped
+    void Record(const char* name_, uint64_t beginNs_, uint64_t endNs_, uint32_t generation_);
+
+    uint64_t Now() const;
+
+    static inline bool IsCapturing()
+    {
+        return s_Capturing.load(std::memory_order_relaxed);
+    }
+
+    // Bumped by every capture
+    static inline uint32_t GetCaptureGeneration()
+    {
+        return s_CaptureGeneration.load(std::memory_order_acquire);
+    }
+
+private:
+
+    // Written by its thread only, which empties it when it first records into a new
+    // capture. The exporter only reads buffers of the capture it writes
+    struct ThreadEvents
+    {
+        uint32_t threadId{ 0 };
+        std::unique_ptr<ProfileEvent[]> events;
+        std::atomic<uint32_t> count{ 0 };
+        std::atomic<uint32_t> generation{ 0 };
+    };
+
+    Profiler();
+    ~Profiler() = default;
+
+    ThreadEvents* RegisterThread();
+
+    void StartCapture();
+    void WriteCapture();
+
+private:
+
+    static std::atomic<Profiler*> s_Instance;
+    static std::atomic<bool> s_Capturing;
+    static std::atomic<uint32_t> s_CaptureGeneration;
+    static thread_local ThreadEvents* s_ThreadEvents;
+
+    std::chrono::steady_clock::time_point m_Epoch;
+
+    std::mutex m_ThreadsMutex;
+    std::vector<std::unique_ptr<ThreadEvents>> m_Threads;
+
+    std::string m_CapturePath;
+    uint32_t m_CaptureFrameCount{ 0 };
+    uint32_t m_CapturedFrames{ 0 };
+    bool m_CapturePending{ false };
+    bool m_InFrame{ false };
+};
+
+// Records its own lifetime as one zone when a capture is running
+class ProfileZone
+{
+public:
+
+    explicit ProfileZone(const char* name_)
+        : m_Name{ name_ }, m_Profiler{ Profiler::IsCapturing() ? Profiler::Get() : nullptr }
+    {
+        if (m_Profiler)
+        {
+            m_Generation = Profiler::GetCaptureGeneration();
+            m_BeginNs = m_Profiler->Now();
+        }
+    }
+
+    ~ProfileZone()
+    {
+        if (m_Profiler)
+        {
+            m_Profiler->Record(m_Name, m_BeginNs, m_Profiler->Now(), m_Generation);
+        }
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+
+    const char* m_Name;
+    Profiler* m_Profiler;
+    uint64_t m_BeginNs{ 0 };
+    uint32_t m_Generation{ 0 };
+};
+
+} // namespace Victory
+
+#define VICTORY_PROFILE_CONCAT_IMPL(a_, b_) a_##b_
+#define VICTORY_PROFILE_CONCAT(a_, b_) VICTORY_PROFILE_CONCAT_IMPL(a_, b_)
+
+// Zone from here to the end of the enclosing scope, name_ must outlive the capture
+#define VICTORY_PROFILE_ZONE(name_) \
+    ::Victory::ProfileZone VICTORY_PROFILE_CONCAT(profileZone, __LINE__){ name_ }
@@ -0,0 +1,129 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace Victory {
+
+static ThreadPool* s_ThreadPoolInstance{ nullptr };
+static thread_local bool s_InsideJob{ false };
+
+ThreadPool* ThreadPool::Init()
+{
+    if (s_ThreadPoolInstance)
+    {
+        return s_ThreadPoolInstance;
+    }
+
+    std::cout << "Init ThreadPool" << std::endl;
+    const uint32_t hardwareThreads{ std::max(std::thread::hardware_concurrency(), 1u) };
+    s_ThreadPoolInstance = new ThreadPool(hardwareThreads - 1);
+
+    return s_ThreadPoolInstance;
+}
+
+void ThreadPool::Cleanup()
+{
+    std::cout << "Cleanup ThreadPool" << std::endl;
+
+    delete s_ThreadPoolInstance;
+    s_ThreadPoolInstance = nullptr;
+}
+
+ThreadPool::ThreadPool(uint32_t workerCount_)
+{
+    m_Workers.reserve(workerCount_);
+    for (uint32_t i{ 0 }; i < workerCount_; ++i)
+    {
+        m_Workers.emplace_back(&ThreadPool::WorkerLoop, this, i + 1);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock{ m_Mutex };
+        m_Stop = true;
+    }
+    m_WakeCondition.notify_all();
+
+    for (auto&& worker : m_Workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::ParallelFor(uint32_t count_, uint32_t grainSize_, const Job& job_)
+{
+    if (count_ == 0)
+    {
+        return;
+    }
+
+    grainSize_ = std::max(grainSize_, 1u);
+    if (s_InsideJob || m_Workers.empty() || count_ <= grainSize_)
+    {
+        job_(0, count_, 0);
+        return;
+    }
+
+    std::lock_guard submitLock{ m_SubmitMutex };
+    {
+        std::lock_guard lock{ m_Mutex };
+        m_Job = &job_;
+        m_Count = count_;
+        m_GrainSize = grainSize_;
+        m_NextTask.store(0, std::memory_order_relaxed);
+        m_BusyWorkers = static_cast<uint32_t>(m_Workers.size());
+        ++m_Generation;
+    }
+    m_WakeCondition.notify_all();
+
+    RunTasks(0);
+
+    std::unique_lock lock{ m_Mutex };
+    m_DoneCondition.wait(lock, [this] { return m_BusyWorkers == 0; });
+    m_Job = nullptr;
+}
+
+void ThreadPool::WorkerLoop(uint32_t threadIndex_)
+{
+    uint64_t seenGeneration{ 0 };
+    while (true)
+    {
+        {
+            std::unique_lock lock{ m_Mutex };
+            m_WakeCondition.wait(lock, [&] { return m_Stop || m_Generation != seenGeneration; });
+            if (m_Stop)
+            {
+                return;
+            }
+            seenGeneration = m_Generation;
+        }
+
+        RunTasks(threadIndex_);
+
+        std::lock_guard lock{ m_Mutex };
+        if (--m_BusyWorkers == 0)
+        {
+            m_DoneCondition.notify_one();
+        }
+    }
+}
+
+void ThreadPool::RunTasks(uint32_t threadIndex_)
+{
+    s_InsideJob = true;
+    while (true)
+    {
+        const uint32_t begin{ m_NextTask.fetch_add(m_GrainSize, std::memory_order_relaxed) };
+        if (begin >= m_Count)
+        {
+            break;
+        }
+        (*m_Job)(begin, std::min(begin + m_GrainSize, m_Count), threadIndex_);
+    }
+    s_InsideJob = false;
+}
+
+} // namespace Victory
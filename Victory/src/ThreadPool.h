@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Victory {
+
+class ThreadPool
+{
+public:
+
+    // Receives the [begin, end) task range and the index of the executing thread.
+    // Thread index 0 is the calling thread, workers are 1..GetThreadCount()-1
+    using Job = std::function<void(uint32_t begin_, uint32_t end_, uint32_t threadIndex_)>;
+
+    static ThreadPool* Init();
+    static void Cleanup();
+
+    // Splits [0, count_) into ranges of grainSize_ and blocks until all of them ran.
+    // Called from inside a job it runs inline on the current thread
+    void ParallelFor(uint32_t count_, uint32_t grainSize_, const Job& job_);
+
+    inline uint32_t GetThreadCount() const
+    {
+        return static_cast<uint32_t>(m_Workers.size()) + 1;
+    }
+
+private:
+
+    explicit ThreadPool(uint32_t workerCount_);
+    ~ThreadPool();
+
+    void WorkerLoop(uint32_t threadIndex_);
+    void RunTasks(uint32_t threadIndex_);
+
+private:
+
+    std::vector<std::thread> m_Workers;
+
+    std::mutex m_SubmitMutex;
+    std::mutex m_Mutex;
+    std::condition_variable m_WakeCondition;
+    std::condition_variable m_DoneCondition;
+
+    const Job* m_Job{ nullptr };
+    uint32_t m_Count{ 0 };
+    uint32_t m_GrainSize{ 1 };
+    std::atomic<uint32_t> m_NextTask{ 0 };
+
+    uint64_t m_Generation{ 0 };
+    uint32_t m_BusyWorkers{ 0 };
+    bool m_Stop{ false };
+};
+
+} // namespace Victory
@@ -1,12 +1,48 @@
 #pragma once
 
+#include <cstdint>
+
+enum class FramePacing {
+    // CPU records the next frame while the GPU renders the previous one
+    eBalanced,
+    // Waits for the previous frame before sampling input, trades throughput for latency
+    eLowLatency,
+    // 3 frames in flight and a deeper swapchain keep the GPU fed
+    eThroughput
+};
+
+struct RendererSpecification {
+    // Renders the viewport offscreen, without window, surface or swapchain
+    bool Headless{ false };
+    uint32_t Width{ 1280 };
+    uint32_t Height{ 720 };
+    // Headless only, frames rendered before the renderer stops. 0 runs until killed
+    uint32_t FrameCount{ 1 };
+    // Headless only, the last frame is read back and written there as binary PPM
+    const char* OutputPath{ nullptr };
+
+    FramePacing Pacing{ FramePacing::eBalanced };
+    // 0 picks the default of Pacing
+    uint32_t FramesInFlight{ 0 };
+    // 0 picks the default of Pacing, the surface limits still apply
+    uint32_t SwapchainImageCount{ 0 };
+
+    // Two phase culling against a depth pyramid, where the device draws GPU driven
+    bool OcclusionCulling{ true };
+
+    // LODs generated per mesh on import, 1 keeps only the full mesh
+    uint32_t MeshLodCount{ 4 };
+    // Draws use the coarsest LOD whose error stays within this many pixels on screen
+    float LodErrorPixels{ 1.f };
+};
+
 class Renderer {
 public:
 
     static Renderer* CreateRenderer();
     static void CleanupRenderer();
 
-    virtual void Initialize(const char* applicationName) = 0;
+    virtual void Initialize(const char* applicationName, const RendererSpecification& specification) = 0;
 
     virtual bool IsRunning() = 0;
     virtual void PollEvents() = 0;
@@ -0,0 +1,155 @@
+#include "AssetCache.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace Victory
+{
+    const static std::string s_AssetCacheDirectory{ "cache" };
+
+    AssetCache::AssetCache(const std::string& sourcePath_, const char* extension_)
+        : m_SourcePath{ sourcePath_ }
+    {
+        const uint64_t pathHash{ HashBytes(
+            reinterpret_cast<const unsigned char*>(sourcePath_.data()), sourcePath_.size()) };
+
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.%s", static_cast<unsigned long long>(pathHash), extension_);
+        m_CachePath = (std::filesystem::path(s_AssetCacheDirectory) / name).string();
+    }
+
+    bool AssetCache::Open(size_t headerSize_)
+    {
+        if (!ReadSourceKey() || !m_CacheFile.Open(m_CachePath))
+        {
+            return false;
+        }
+
+        if (m_CacheFile.GetSize() < headerSize_)
+        {
+            m_CacheFile.Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool AssetCache::IsCurrent(const AssetSourceKey& key_, size_t keyOffset_)
+    {
+        if (key_.size != m_SourceSize)
+        {
+            return false;
+        }
+
+        if (key_.time != m_SourceTime)
+        {
+            if (key_.hash != HashSourceFile())
+            {
+                return false;
+            }
+
+            std::fstream file(m_CachePath, std::ios::binary | std::ios::in | std::ios::out);
+            if (file)
+            {
+                file.seekp(keyOffset_ + offsetof(AssetSourceKey, time));
+                file.write(reinterpret_cast<const char*>(&m_SourceTime), sizeof(m_SourceTime));
+            }
+        }
+
+        return true;
+    }
+
+    bool AssetCache::HasSourcePath(uint32_t pathLength_, size_t headerSize_) const
+    {
+        return pathLength_ == m_SourcePath.size() &&
+            headerSize_ + pathLength_ <= m_CacheFile.GetSize() &&
+            memcmp(m_CacheFile.GetData() + headerSize_, m_SourcePath.data(), pathLength_) == 0;
+    }
+
+    bool AssetCache::MakeSourceKey(AssetSourceKey& key_)
+    {
+        if (!ReadSourceKey())
+        {
+            return false;
+        }
+
+        key_.size = m_SourceSize;
+        key_.time = m_SourceTime;
+        key_.hash = HashSourceFile();
+        return true;
+    }
+
+    void AssetCache::Write(const std::function<void(std::ofstream&)>& write_)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(s_AssetCacheDirectory, error);
+
+        const std::string tempPath{ m_CachePath + ".tmp" };
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                std::cout << "Asset cache was not written: " << m_CachePath << std::endl;
+                return;
+            }
+
+            write_(file);
+        }
+
+        std::filesystem::rename(tempPath, m_CachePath, error);
+        if (error)
+        {
+            std::filesystem::remove(tempPath, error);
+        }
+    }
+
+    uint64_t AssetCache::HashBytes(const unsigned char* data_, size_t size_)
+    {
+        // FNV-1a
+        uint64_t hash{ 0xcbf29ce484222325ull };
+        for (size_t i{ 0 }; i < size_; ++i)
+        {
+            hash ^= data_[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    uint64_t AssetCache::AlignUp(uint64_t value_, uint64_t alignment_)
+    {
+        return (value_ + alignment_ - 1) & ~(alignment_ - 1);
+    }
+
+    bool AssetCache::ReadSourceKey()
+    {
+        std::error_code error;
+        m_SourceSize = std::filesystem::file_size(m_SourcePath, error);
+        if (error)
+        {
+            return false;
+        }
+
+        const auto sourceTime{ std::filesystem::last_write_time(m_SourcePath, error) };
+        if (error)
+        {
+            return false;
+        }
+
+        m_SourceTime = static_cast<int64_t>(sourceTime.time_since_epoch().count());
+        return true;
+    }
+
+    uint64_t AssetCache::HashSourceFile() const
+    {
+        MappedFile source;
+        if (!source.Open(m_SourcePath))
+        {
+            return 0;
+        }
+        return HashBytes(source.GetData(), source.GetSize());
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+
+#include "MappedFile.h"
+
+namespace Victory
+{
+    // Identifies the source an entry was built from, stored in the header of every entry
+    struct AssetSourceKey
+    {
+        uint64_t size;
+        int64_t time;
+        uint64_t hash;
+    };
+
+    // Common part of the binary caches of imported assets. An entry is keyed by the
+    // source path and validated against the size, mtime and content hash of the source.
+    // The header and the payload layout belong to the derived cache
+    class AssetCache
+    {
+    protected:
+
+        AssetCache(const std::string& sourcePath_, const char* extension_);
+
+        // Maps the entry if it is at least headerSize_ bytes
+        bool Open(size_t headerSize_);
+
+        // keyOffset_ is where the key sits in the header. A touched but unchanged
+        // source (fresh checkout, copy) is compared by content and its time refreshed
+        bool IsCurrent(const AssetSourceKey& key_, size_t keyOffset_);
+        // The source path is stored right after the header
+        bool HasSourcePath(uint32_t pathLength_, size_t headerSize_) const;
+
+        bool MakeSourceKey(AssetSourceKey& key_);
+
+        // Written aside and swapped in, so a crash never leaves a torn entry behind
+        void Write(const std::function<void(std::ofstream&)>& write_);
+
+        static uint64_t HashBytes(const unsigned char* data_, size_t size_);
+        static uint64_t AlignUp(uint64_t value_, uint64_t alignment_);
+
+    private:
+
+        bool ReadSourceKey();
+        uint64_t HashSourceFile() const;
+
+    protected:
+
+        std::string m_SourcePath;
+        std::string m_CachePath;
+
+        MappedFile m_CacheFile;
+
+    private:
+
+        uint64_t m_SourceSize{ 0 };
+        int64_t m_SourceTime{ 0 };
+    };
+}
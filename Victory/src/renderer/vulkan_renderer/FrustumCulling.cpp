@@ -0,0 +1,213 @@
+#include "FrustumCulling.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include <glm/common.hpp>
+
+#include "VertexData.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define VICTORY_CULL_SSE 1
+#include <immintrin.h>
+#endif
+
+// The AVX2 kernel is compiled for its own target and picked at runtime
+#if VICTORY_CULL_SSE && (defined(__GNUC__) || defined(__clang__))
+#define VICTORY_CULL_AVX2 1
+#endif
+
+namespace Victory
+{
+    constexpr uint32_t s_SphereArrayPadding{ 8 };
+
+    using CullKernel = void (*)(const Frustum& frustum_, const float* x_, const float* y_,
+        const float* z_, const float* radius_, uint32_t count_, uint8_t* visible_);
+
+    [[maybe_unused]] static void CullScalar(const Frustum& frustum_, const float* x_, const float* y_,
+        const float* z_, const float* radius_, uint32_t count_, uint8_t* visible_)
+    {
+        for (uint32_t i{ 0 }; i < count_; ++i)
+        {
+            bool inside{ true };
+            for (auto&& plane : frustum_.planes)
+            {
+                inside &= plane.x * x_[i] + plane.y * y_[i] + plane.z * z_[i] + plane.w >= -radius_[i];
+            }
+            visible_[i] = inside ? 1 : 0;
+        }
+    }
+
+#if VICTORY_CULL_SSE
+    static void CullSse(const Frustum& frustum_, const float* x_, const float* y_,
+        const float* z_, const float* radius_, uint32_t count_, uint8_t* visible_)
+    {
+        for (uint32_t i{ 0 }; i < count_; i += 4)
+        {
+            const __m128 x{ _mm_loadu_ps(x_ + i) };
+            const __m128 y{ _mm_loadu_ps(y_ + i) };
+            const __m128 z{ _mm_loadu_ps(z_ + i) };
+            const __m128 negativeRadius{ _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius_ + i)) };
+
+            __m128 inside{ _mm_castsi128_ps(_mm_set1_epi32(-1)) };
+            for (auto&& plane : frustum_.planes)
+            {
+                __m128 distance{ _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_set1_ps(plane.w)) };
+                distance = _mm_add_ps(distance, _mm_mul_ps(y, _mm_set1_ps(plane.y)));
+                distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(plane.z)));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+            }
+
+            const int mask{ _mm_movemask_ps(inside) };
+            for (uint32_t lane{ 0 }; lane < 4; ++lane)
+            {
+                visible_[i + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+            }
+        }
+    }
+#endif
+
+#if VICTORY_CULL_AVX2
+    __attribute__((target("avx2,fma")))
+    static void CullAvx2(const Frustum& frustum_, const float* x_, const float* y_,
+        const float* z_, const float* radius_, uint32_t count_, uint8_t* visible_)
+    {
+        for (uint32_t i{ 0 }; i < count_; i += 8)
+        {
+            const __m256 x{ _mm256_loadu_ps(x_ + i) };
+            const __m256 y{ _mm256_loadu_ps(y_ + i) };
+            const __m256 z{ _mm256_loadu_ps(z_ + i) };
+            const __m256 negativeRadius{ _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius_ + i)) };
+
+            __m256 inside{ _mm256_castsi256_ps(_mm256_set1_epi32(-1)) };
+            for (auto&& plane : frustum_.planes)
+            {
+                __m256 distance{ _mm256_fmadd_ps(x, _mm256_set1_ps(plane.x), _mm256_set1_ps(plane.w)) };
+                distance = _mm256_fmadd_ps(y, _mm256_set1_ps(plane.y), distance);
+                distance = _mm256_fmadd_ps(z, _mm256_set1_ps(plane.z), distance);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+            }
+
+            const int mask{ _mm256_movemask_ps(inside) };
+            for (uint32_t lane{ 0 }; lane < 8; ++lane)
+            {
+                visible_[i + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+            }
+        }
+    }
+#endif
+
+    static CullKernel SelectCullKernel()
+    {
+#if VICTORY_CULL_AVX2
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        {
+            return CullAvx2;
+        }
+#endif
+#if VICTORY_CULL_SSE
+        return CullSse;
+#else
+        return CullScalar;
+#endif
+    }
+
+    MeshBounds ComputeMeshBounds(const VertexData* vertices_, size_t vertexCount_)
+    {
+        MeshBounds bounds{};
+        if (vertexCount_ == 0)
+        {
+            return bounds;
+        }
+
+        bounds.aabbMin = glm::vec3{ FLT_MAX };
+        bounds.aabbMax = glm::vec3{ -FLT_MAX };
+        for (size_t i{ 0 }; i < vertexCount_; ++i)
+        {
+            bounds.aabbMin = glm::min(bounds.aabbMin, vertices_[i].position);
+            bounds.aabbMax = glm::max(bounds.aabbMax, vertices_[i].position);
+        }
+
+        // Centered on the box, a little looser than a minimal sphere but stable
+        bounds.center = (bounds.aabbMin + bounds.aabbMax) * 0.5f;
+        float radiusSquared{ 0.f };
+        for (size_t i{ 0 }; i < vertexCount_; ++i)
+        {
+            const glm::vec3 offset{ vertices_[i].position - bounds.center };
+            radiusSquared = std::max(radiusSquared, offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
+        }
+        bounds.radius = std::sqrt(radiusSquared);
+
+        return bounds;
+    }
+
+    Frustum ExtractFrustum(const glm::mat4& viewProjection_)
+    {
+        // Rows of the matrix, glm stores columns
+        glm::vec4 rows[4];
+        for (int i{ 0 }; i < 4; ++i)
+        {
+            rows[i] = glm::vec4{ viewProjection_[0][i], viewProjection_[1][i], viewProjection_[2][i], viewProjection_[3][i] };
+        }
+
+        // Near is -w <= z, which also holds for a [0, 1] depth range, only looser
+        Frustum frustum{};
+        frustum.planes[0] = rows[3] + rows[0];
+        frustum.planes[1] = rows[3] - rows[0];
+        frustum.planes[2] = rows[3] + rows[1];
+        frustum.planes[3] = rows[3] - rows[1];
+        frustum.planes[4] = rows[3] + rows[2];
+        frustum.planes[5] = rows[3] - rows[2];
+
+        // Normalized, so plane distances compare against radii
+        for (auto&& plane : frustum.planes)
+        {
+            plane /= std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        }
+
+        return frustum;
+    }
+
+    void BoundingSphereArray::Clear()
+    {
+        m_Count = 0;
+        m_CenterX.clear();
+        m_CenterY.clear();
+        m_CenterZ.clear();
+        m_Radius.clear();
+    }
+
+    void BoundingSphereArray::Push(const glm::vec3& center_, float radius_)
+    {
+        if (m_Count == m_CenterX.size())
+        {
+            const size_t size{ m_CenterX.size() + s_SphereArrayPadding };
+            m_CenterX.resize(size);
+            m_CenterY.resize(size);
+            m_CenterZ.resize(size);
+            m_Radius.resize(size);
+        }
+
+        m_CenterX[m_Count] = center_.x;
+        m_CenterY[m_Count] = center_.y;
+        m_CenterZ[m_Count] = center_.z;
+        m_Radius[m_Count] = radius_;
+        ++m_Count;
+    }
+
+    void BoundingSphereArray::Cull(const Frustum& frustum_, std::vector<uint8_t>& visible_) const
+    {
+        const static CullKernel s_Kernel{ SelectCullKernel() };
+
+        // Whole registers, the padding lanes are computed and ignored
+        visible_.resize(m_CenterX.size());
+        if (m_Count == 0)
+        {
+            return;
+        }
+
+        s_Kernel(frustum_, m_CenterX.data(), m_CenterY.data(), m_CenterZ.data(), m_Radius.data(),
+            static_cast<uint32_t>(m_CenterX.size()), visible_.data());
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/mat4x4.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_float4.hpp>
+
+struct VertexData;
+
+namespace Victory
+{
+    // Object space bounds of a mesh, stored in the mesh cache
+    struct MeshBounds
+    {
+        glm::vec3 center;
+        float radius;
+        glm::vec3 aabbMin;
+        glm::vec3 aabbMax;
+    };
+
+    MeshBounds ComputeMeshBounds(const VertexData* vertices_, size_t vertexCount_);
+
+    // Planes point inwards, a point p is inside when dot(plane.xyz, p) + plane.w >= 0
+    struct Frustum
+    {
+        glm::vec4 planes[6];
+    };
+
+    Frustum ExtractFrustum(const glm::mat4& viewProjection_);
+
+    // World space bounding spheres, one component per array so a kernel tests
+    // a whole register of spheres against a plane at once
+    class BoundingSphereArray
+    {
+    public:
+
+        void Clear();
+        void Push(const glm::vec3& center_, float radius_);
+
+        inline uint32_t GetCount() const
+        {
+            return m_Count;
+        }
+
+        // visible_ receives one byte per sphere, 1 if it intersects the frustum
+        void Cull(const Frustum& frustum_, std::vector<uint8_t>& visible_) const;
+
+    private:
+
+        uint32_t m_Count{ 0 };
+
+        // Padded to the widest kernel, so the tail needs no scalar loop
+        std::vector<float> m_CenterX;
+        std::vector<float> m_CenterY;
+        std::vector<float> m_CenterZ;
+        std::vector<float> m_Radius;
+    };
+}
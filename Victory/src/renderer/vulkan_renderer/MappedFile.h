@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace Victory
+{
+    // Read-only view of a whole file, mapped into the address space
+    class MappedFile
+    {
+    public:
+
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool Open(const std::string& path_);
+        void Close();
+
+        inline const unsigned char* GetData() const
+        {
+            return m_Data;
+        }
+
+        inline size_t GetSize() const
+        {
+            return m_Size;
+        }
+
+        inline bool IsOpen() const
+        {
+            return m_Data != nullptr;
+        }
+
+    private:
+
+        const unsigned char* m_Data{ nullptr };
+        size_t m_Size{ 0 };
+
+#ifdef _WIN32
+        void* m_File{ nullptr };
+        void* m_Mapping{ nullptr };
+#else
+        int m_File{ -1 };
+#endif
+    };
+}
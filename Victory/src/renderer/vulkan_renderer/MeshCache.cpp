@@ -0,0 +1,173 @@
+#include "MeshCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+
+#include "VertexData.h"
+
+namespace Victory
+{
+    constexpr uint32_t s_MeshCacheMagic{ 0x48534D56 }; // "VMSH"
+    constexpr uint32_t s_MeshCacheVersion{ 9 };
+    constexpr uint64_t s_MeshCacheAlignment{ 16 };
+
+    template<typename T>
+    static bool AreIndicesInRange(const unsigned char* data_, uint64_t indexCount_, uint64_t vertexCount_)
+    {
+        T maxIndex{ 0 };
+        for (uint64_t i{ 0 }; i < indexCount_; ++i)
+        {
+            T index;
+            memcpy(&index, data_ + i * sizeof(T), sizeof(T));
+            maxIndex = std::max(maxIndex, index);
+        }
+        return indexCount_ == 0 || maxIndex < vertexCount_;
+    }
+
+    MeshCache::MeshCache(const std::string& sourcePath_)
+        : AssetCache{ sourcePath_, "vmesh" } {}
+
+    bool MeshCache::Load(uint32_t lodLimit_)
+    {
+        if (!Open(sizeof(MeshCacheHeader)))
+        {
+            return false;
+        }
+
+        MeshCacheHeader header;
+        memcpy(&header, m_CacheFile.GetData(), sizeof(header));
+
+        if (!ValidateHeader(header) || header.lodLimit != lodLimit_ ||
+            !IsCurrent(header.source, offsetof(MeshCacheHeader, source)) || !ValidateIndices(header))
+        {
+            Release();
+            return false;
+        }
+
+        m_Header = header;
+        std::cout << "Mesh cache hit: " << m_SourcePath << std::endl;
+        return true;
+    }
+
+    void MeshCache::Store(const std::vector<PackedVertex>& vertices_, const MeshBounds& bounds_,
+        std::span<const MeshLod> lods_, uint32_t lodLimit_, std::span<const Meshlet> meshlets_,
+        const void* indices_, size_t indexCount_, uint32_t indexStride_)
+    {
+        Release();
+
+        MeshCacheHeader header{};
+        if (!MakeSourceKey(header.source))
+        {
+            return;
+        }
+
+        header.magic = s_MeshCacheMagic;
+        header.version = s_MeshCacheVersion;
+        header.pathLength = static_cast<uint32_t>(m_SourcePath.size());
+        header.vertexStride = sizeof(PackedVertex);
+        header.indexStride = indexStride_;
+        header.vertexCount = vertices_.size();
+        header.indexCount = indexCount_;
+        header.vertexOffset = AlignUp(sizeof(MeshCacheHeader) + header.pathLength, s_MeshCacheAlignment);
+        header.indexOffset = AlignUp(header.vertexOffset + header.vertexCount * header.vertexStride,
+            s_MeshCacheAlignment);
+        header.meshletCount = meshlets_.size();
+        header.meshletOffset = AlignUp(header.indexOffset + header.indexCount * header.indexStride,
+            s_MeshCacheAlignment);
+        header.bounds = bounds_;
+        header.lodLimit = lodLimit_;
+        header.lodCount = static_cast<uint32_t>(std::min(lods_.size(), static_cast<size_t>(s_MaxMeshLodCount)));
+        std::copy_n(lods_.begin(), header.lodCount, header.lods);
+
+        Write([&](std::ofstream& file_)
+        {
+            const char padding[s_MeshCacheAlignment]{};
+            file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file_.write(m_SourcePath.data(), header.pathLength);
+            file_.write(padding, header.vertexOffset - sizeof(header) - header.pathLength);
+            file_.write(reinterpret_cast<const char*>(vertices_.data()), header.vertexCount * header.vertexStride);
+            file_.write(padding, header.indexOffset - header.vertexOffset - header.vertexCount * header.vertexStride);
+            file_.write(static_cast<const char*>(indices_), header.indexCount * header.indexStride);
+            file_.write(padding, header.meshletOffset - header.indexOffset - header.indexCount * header.indexStride);
+            file_.write(reinterpret_cast<const char*>(meshlets_.data()), header.meshletCount * sizeof(Meshlet));
+        });
+    }
+
+    void MeshCache::Release()
+    {
+        m_CacheFile.Close();
+        m_Header = {};
+    }
+
+    bool MeshCache::ValidateHeader(const MeshCacheHeader& header_) const
+    {
+        if (header_.magic != s_MeshCacheMagic ||
+            header_.version != s_MeshCacheVersion ||
+            header_.vertexStride != sizeof(PackedVertex) ||
+            (header_.indexStride != sizeof(uint16_t) && header_.indexStride != sizeof(uint32_t)))
+        {
+            return false;
+        }
+
+        if (!HasSourcePath(header_.pathLength, sizeof(MeshCacheHeader)))
+        {
+            return false;
+        }
+
+        if (header_.lodCount == 0 || header_.lodCount > s_MaxMeshLodCount)
+        {
+            return false;
+        }
+
+        for (uint32_t lod{ 0 }; lod < header_.lodCount; ++lod)
+        {
+            if (static_cast<uint64_t>(header_.lods[lod].firstIndex) + header_.lods[lod].indexCount > header_.indexCount)
+            {
+                return false;
+            }
+        }
+
+        const uint64_t fileSize{ m_CacheFile.GetSize() };
+        if (header_.vertexOffset % s_MeshCacheAlignment != 0 ||
+            header_.indexOffset % s_MeshCacheAlignment != 0 ||
+            header_.meshletOffset % s_MeshCacheAlignment != 0 ||
+            header_.vertexOffset + header_.vertexCount * header_.vertexStride > header_.indexOffset ||
+            header_.indexOffset + header_.indexCount * header_.indexStride > header_.meshletOffset ||
+            header_.meshletOffset + header_.meshletCount * sizeof(Meshlet) > fileSize)
+        {
+            return false;
+        }
+
+        // Meshlets split LOD 0, they are drawn in its place
+        const Meshlet* meshlets{ reinterpret_cast<const Meshlet*>(m_CacheFile.GetData() + header_.meshletOffset) };
+        const MeshLod& lod0{ header_.lods[0] };
+        for (uint64_t meshlet{ 0 }; meshlet < header_.meshletCount; ++meshlet)
+        {
+            if (meshlets[meshlet].firstIndex < lod0.firstIndex ||
+                static_cast<uint64_t>(meshlets[meshlet].firstIndex) + meshlets[meshlet].indexCount >
+                static_cast<uint64_t>(lod0.firstIndex) + lod0.indexCount)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool MeshCache::ValidateIndices(const MeshCacheHeader& header_) const
+    {
+        // A corrupt entry must not send the GPU fetching past the vertices, it is rebuilt instead
+        const unsigned char* indices{ m_CacheFile.GetData() + header_.indexOffset };
+        const bool inRange{ header_.indexStride == sizeof(uint16_t) ?
+            AreIndicesInRange<uint16_t>(indices, header_.indexCount, header_.vertexCount) :
+            AreIndicesInRange<uint32_t>(indices, header_.indexCount, header_.vertexCount) };
+
+        if (!inRange)
+        {
+            std::cout << "Mesh cache has out of range indices: " << m_SourcePath << std::endl;
+        }
+        return inRange;
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "AssetCache.h"
+#include "FrustumCulling.h"
+#include "MeshSimplification.h"
+#include "MeshletBuilder.h"
+
+struct PackedVertex;
+
+namespace Victory
+{
+    struct MeshCacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        AssetSourceKey source;
+        uint32_t pathLength;
+        uint32_t vertexStride;
+        uint32_t indexStride;
+        // The LOD count the chain was built for, it may have stopped earlier
+        uint32_t lodLimit;
+        uint64_t vertexCount;
+        uint64_t indexCount;
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+        uint64_t meshletCount;
+        uint64_t meshletOffset;
+        MeshBounds bounds;
+        uint32_t lodCount;
+        MeshLod lods[s_MaxMeshLodCount];
+    };
+
+    // Binary copy of an imported mesh, stored in GPU-ready layout
+    class MeshCache : public AssetCache
+    {
+    public:
+
+        explicit MeshCache(const std::string& sourcePath_);
+
+        // Misses when the cache was built for another LOD limit
+        bool Load(uint32_t lodLimit_);
+        void Store(const std::vector<PackedVertex>& vertices_, const MeshBounds& bounds_,
+            std::span<const MeshLod> lods_, uint32_t lodLimit_, std::span<const Meshlet> meshlets_,
+            const void* indices_, size_t indexCount_, uint32_t indexStride_);
+        void Release();
+
+        inline const void* GetVertexData() const
+        {
+            return m_CacheFile.GetData() + m_Header.vertexOffset;
+        }
+
+        inline size_t GetVertexDataSize() const
+        {
+            return static_cast<size_t>(m_Header.vertexCount * m_Header.vertexStride);
+        }
+
+        inline uint32_t GetVertexCount() const
+        {
+            return static_cast<uint32_t>(m_Header.vertexCount);
+        }
+
+        inline const void* GetIndexData() const
+        {
+            return m_CacheFile.GetData() + m_Header.indexOffset;
+        }
+
+        inline size_t GetIndexDataSize() const
+        {
+            return static_cast<size_t>(m_Header.indexCount * m_Header.indexStride);
+        }
+
+        inline uint32_t GetIndexCount() const
+        {
+            return static_cast<uint32_t>(m_Header.indexCount);
+        }
+
+        inline uint32_t GetIndexStride() const
+        {
+            return m_Header.indexStride;
+        }
+
+        inline const MeshBounds& GetBounds() const
+        {
+            return m_Header.bounds;
+        }
+
+        inline std::span<const MeshLod> GetLods() const
+        {
+            return { m_Header.lods, m_Header.lodCount };
+        }
+
+        inline std::span<const Meshlet> GetMeshlets() const
+        {
+            return { reinterpret_cast<const Meshlet*>(m_CacheFile.GetData() + m_Header.meshletOffset),
+                static_cast<size_t>(m_Header.meshletCount) };
+        }
+
+    private:
+
+        bool ValidateHeader(const MeshCacheHeader& header_) const;
+        // Scans the indices once, every one has to address a stored vertex
+        bool ValidateIndices(const MeshCacheHeader& header_) const;
+
+    private:
+
+        MeshCacheHeader m_Header{};
+    };
+}
@@ -0,0 +1,345 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+
+#include <glm/geometric.hpp>
+
+#include "VertexData.h"
+#include "../../Profiler.h"
+
+namespace Victory
+{
+    constexpr uint32_t s_VertexCacheSize{ 16 };
+    constexpr uint32_t s_NoVertex{ UINT32_MAX };
+
+    // Clusters may cost this much more ACMR than the whole list
+    constexpr float s_OverdrawThreshold{ 1.05f };
+
+    // A vertex stamped at cacheTime_ is still cached until cache size newer vertices went in
+    static inline bool IsCached(uint32_t time_, uint32_t cacheTime_)
+    {
+        return time_ - cacheTime_ <= s_VertexCacheSize;
+    }
+
+    VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices_, size_t vertexCount_)
+    {
+        VertexCacheStats stats{};
+        if (indices_.empty() || vertexCount_ == 0)
+        {
+            return stats;
+        }
+
+        std::vector<uint32_t> cacheTime(vertexCount_, 0);
+        uint32_t time{ s_VertexCacheSize + 1 };
+        uint32_t misses{ 0 };
+
+        for (uint32_t index : indices_)
+        {
+            if (!IsCached(time, cacheTime[index]))
+            {
+                cacheTime[index] = time++;
+                ++misses;
+            }
+        }
+
+        stats.acmr = static_cast<float>(misses) / static_cast<float>(indices_.size() / 3);
+        stats.atvr = static_cast<float>(misses) / static_cast<float>(vertexCount_);
+        return stats;
+    }
+
+    void OptimizeVertexCache(std::vector<uint32_t>& indices_, size_t vertexCount_)
+    {
+        VICTORY_PROFILE_ZONE("OptimizeVertexCache");
+
+        const size_t triangleCount{ indices_.size() / 3 };
+        if (triangleCount == 0)
+        {
+            return;
+        }
+
+        // Triangles around every vertex, flattened
+        std::vector<uint32_t> liveCount(vertexCount_, 0);
+        for (uint32_t index : indices_)
+        {
+            ++liveCount[index];
+        }
+
+        std::vector<uint32_t> adjacencyOffsets(vertexCount_ + 1, 0);
+        for (size_t vertex{ 0 }; vertex < vertexCount_; ++vertex)
+        {
+            adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + liveCount[vertex];
+        }
+
+        std::vector<uint32_t> adjacency(indices_.size());
+        std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t corner{ 0 }; corner < triangleCount * 3; ++corner)
+        {
+            adjacency[adjacencyFill[indices_[corner]]++] = static_cast<uint32_t>(corner / 3);
+        }
+
+        std::vector<uint32_t> cacheTime(vertexCount_, 0);
+        std::vector<uint8_t> emitted(triangleCount, 0);
+        std::vector<uint32_t> deadEnds;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> optimized;
+        deadEnds.reserve(triangleCount * 3);
+        optimized.reserve(triangleCount * 3);
+
+        uint32_t time{ s_VertexCacheSize + 1 };
+        uint32_t cursor{ 0 };
+
+        // Recently emitted vertices first, then the next one in input order
+        auto&& SkipDeadEnd = [&]() -> uint32_t
+        {
+            while (!deadEnds.empty())
+            {
+                const uint32_t vertex{ deadEnds.back() };
+                deadEnds.pop_back();
+                if (liveCount[vertex] > 0)
+                {
+                    return vertex;
+                }
+            }
+
+            for (; cursor < vertexCount_; ++cursor)
+            {
+                if (liveCount[cursor] > 0)
+                {
+                    return cursor;
+                }
+            }
+            return s_NoVertex;
+        };
+
+        uint32_t fanning{ SkipDeadEnd() };
+        while (fanning != s_NoVertex)
+        {
+            candidates.clear();
+            for (uint32_t i{ adjacencyOffsets[fanning] }; i < adjacencyOffsets[fanning + 1]; ++i)
+            {
+                const uint32_t triangle{ adjacency[i] };
+                if (emitted[triangle])
+                {
+                    continue;
+                }
+
+                for (uint32_t corner{ 0 }; corner < 3; ++corner)
+                {
+                    const uint32_t vertex{ indices_[triangle * 3 + corner] };
+                    optimized.emplace_back(vertex);
+                    deadEnds.emplace_back(vertex);
+                    candidates.emplace_back(vertex);
+                    --liveCount[vertex];
+
+                    if (!IsCached(time, cacheTime[vertex]))
+                    {
+                        cacheTime[vertex] = time++;
+                    }
+                }
+                emitted[triangle] = 1;
+            }
+
+            // Prefer the oldest candidate that stays cached while its remaining fan is emitted
+            fanning = s_NoVertex;
+            int64_t bestPriority{ -1 };
+            for (uint32_t vertex : candidates)
+            {
+                if (liveCount[vertex] == 0)
+                {
+                    continue;
+                }
+
+                int64_t priority{ 0 };
+                if (time - cacheTime[vertex] + 2 * liveCount[vertex] <= s_VertexCacheSize)
+                {
+                    priority = time - cacheTime[vertex];
+                }
+
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    fanning = vertex;
+                }
+            }
+
+            if (fanning == s_NoVertex)
+            {
+                fanning = SkipDeadEnd();
+            }
+        }
+
+        indices_.swap(optimized);
+    }
+
+    std::vector<float> ComputeOverdrawSortKeys(const std::vector<uint32_t>& indices_, const std::vector<VertexData>& vertices_,
+        const std::vector<uint32_t>& clusterStarts_)
+    {
+        const uint32_t clusterCount{ static_cast<uint32_t>(clusterStarts_.size()) - 1 };
+        std::vector<float> sortKeys(clusterCount, 0.0f);
+
+        // Area weighted centroids and summed normals, clusters facing away from the
+        // mesh centroid occlude the rest and go first
+        std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3{ 0.0f });
+        std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3{ 0.0f });
+        glm::vec3 meshCentroid{ 0.0f };
+        float meshArea{ 0.0f };
+
+        for (uint32_t cluster{ 0 }; cluster < clusterCount; ++cluster)
+        {
+            float clusterArea{ 0.0f };
+            for (uint32_t triangle{ clusterStarts_[cluster] }; triangle < clusterStarts_[cluster + 1]; ++triangle)
+            {
+                const glm::vec3& p0{ vertices_[indices_[triangle * 3 + 0]].position };
+                const glm::vec3& p1{ vertices_[indices_[triangle * 3 + 1]].position };
+                const glm::vec3& p2{ vertices_[indices_[triangle * 3 + 2]].position };
+
+                const glm::vec3 normal{ glm::cross(p1 - p0, p2 - p0) };
+                const float area{ glm::length(normal) };
+
+                clusterCentroids[cluster] += (p0 + p1 + p2) * (area / 3.0f);
+                clusterNormals[cluster] += normal;
+                clusterArea += area;
+            }
+
+            meshCentroid += clusterCentroids[cluster];
+            meshArea += clusterArea;
+            clusterCentroids[cluster] = clusterArea > 0.0f ? clusterCentroids[cluster] / clusterArea : glm::vec3{ 0.0f };
+        }
+
+        if (meshArea <= 0.0f)
+        {
+            return sortKeys;
+        }
+        meshCentroid = meshCentroid / meshArea;
+
+        for (uint32_t cluster{ 0 }; cluster < clusterCount; ++cluster)
+        {
+            const float normalLength{ glm::length(clusterNormals[cluster]) };
+            if (normalLength > 0.0f)
+            {
+                sortKeys[cluster] = glm::dot(clusterCentroids[cluster] - meshCentroid,
+                    clusterNormals[cluster] / normalLength);
+            }
+        }
+        return sortKeys;
+    }
+
+    void OptimizeOverdraw(std::vector<uint32_t>& indices_, const std::vector<VertexData>& vertices_)
+    {
+        VICTORY_PROFILE_ZONE("OptimizeOverdraw");
+
+        const uint32_t triangleCount{ static_cast<uint32_t>(indices_.size() / 3) };
+        if (triangleCount < 2)
+        {
+            return;
+        }
+
+        const float clusterAcmrLimit{ AnalyzeVertexCache(indices_, vertices_.size()).acmr * s_OverdrawThreshold };
+
+        // Every cluster is simulated from a cold cache, it may land anywhere after sorting.
+        // A triangle that misses all its vertices is where the cache order jumped anyway
+        std::vector<uint32_t> clusterStarts;
+        std::vector<uint32_t> cacheTime(vertices_.size(), 0);
+        uint32_t time{ s_VertexCacheSize + 1 };
+        uint32_t clusterMisses{ 0 };
+        uint32_t clusterTriangles{ 0 };
+
+        for (uint32_t triangle{ 0 }; triangle < triangleCount; ++triangle)
+        {
+            const uint32_t* corners{ &indices_[triangle * 3] };
+
+            uint32_t misses{ 0 };
+            for (uint32_t corner{ 0 }; corner < 3; ++corner)
+            {
+                misses += IsCached(time, cacheTime[corners[corner]]) ? 0 : 1;
+            }
+
+            if (clusterTriangles == 0 || misses == 3)
+            {
+                clusterStarts.emplace_back(triangle);
+                time += s_VertexCacheSize + 1;
+                clusterMisses = 0;
+                clusterTriangles = 0;
+            }
+
+            for (uint32_t corner{ 0 }; corner < 3; ++corner)
+            {
+                if (!IsCached(time, cacheTime[corners[corner]]))
+                {
+                    cacheTime[corners[corner]] = time++;
+                    ++clusterMisses;
+                }
+            }
+            ++clusterTriangles;
+
+            // Cheap enough on its own, the next triangle opens a new cluster
+            if (static_cast<float>(clusterMisses) <= clusterAcmrLimit * static_cast<float>(clusterTriangles))
+            {
+                clusterTriangles = 0;
+            }
+        }
+
+        const uint32_t clusterCount{ static_cast<uint32_t>(clusterStarts.size()) };
+        if (clusterCount < 2)
+        {
+            return;
+        }
+        clusterStarts.emplace_back(triangleCount);
+
+        const std::vector<float> sortKeys{ ComputeOverdrawSortKeys(indices_, vertices_, clusterStarts) };
+        std::vector<uint32_t> clusterOrder(clusterCount);
+        for (uint32_t cluster{ 0 }; cluster < clusterCount; ++cluster)
+        {
+            clusterOrder[cluster] = cluster;
+        }
+
+        std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](uint32_t a_, uint32_t b_)
+        {
+            return sortKeys[a_] > sortKeys[b_];
+        });
+
+        std::vector<uint32_t> sorted;
+        sorted.reserve(indices_.size());
+        for (uint32_t cluster : clusterOrder)
+        {
+            sorted.insert(sorted.end(), indices_.begin() + clusterStarts[cluster] * 3,
+                indices_.begin() + clusterStarts[cluster + 1] * 3);
+        }
+
+        indices_.swap(sorted);
+    }
+
+    void OptimizeVertexFetch(std::vector<VertexData>& vertices_, std::vector<uint32_t>& indices_)
+    {
+        VICTORY_PROFILE_ZONE("OptimizeVertexFetch");
+
+        std::vector<uint32_t> remap(vertices_.size(), s_NoVertex);
+        std::vector<VertexData> reordered;
+        reordered.reserve(vertices_.size());
+
+        for (uint32_t& index : indices_)
+        {
+            if (remap[index] == s_NoVertex)
+            {
+                remap[index] = static_cast<uint32_t>(reordered.size());
+                reordered.emplace_back(vertices_[index]);
+            }
+            index = remap[index];
+        }
+
+        vertices_.swap(reordered);
+    }
+
+    MeshOptimizationStats OptimizeMesh(std::vector<VertexData>& vertices_, std::vector<uint32_t>& indices_)
+    {
+        MeshOptimizationStats stats{};
+        stats.before = AnalyzeVertexCache(indices_, vertices_.size());
+
+        OptimizeVertexCache(indices_, vertices_.size());
+        OptimizeOverdraw(indices_, vertices_);
+        OptimizeVertexFetch(vertices_, indices_);
+
+        stats.after = AnalyzeVertexCache(indices_, vertices_.size());
+        return stats;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct VertexData;
+
+namespace Victory
+{
+    // Post-transform cache behaviour of a triangle list, simulated with a FIFO cache.
+    // ACMR is vertices transformed per triangle, ATVR vertices transformed per vertex
+    struct VertexCacheStats
+    {
+        float acmr;
+        float atvr;
+    };
+
+    struct MeshOptimizationStats
+    {
+        VertexCacheStats before;
+        VertexCacheStats after;
+    };
+
+    VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices_, size_t vertexCount_);
+
+    // Tipsify, fans triangles around vertices that are still in the cache
+    void OptimizeVertexCache(std::vector<uint32_t>& indices_, size_t vertexCount_);
+
+    // How far every cluster of triangles [clusterStarts_[i], clusterStarts_[i + 1]) faces away
+    // from the mesh centroid, clusters with larger keys occlude the rest and are drawn first
+    std::vector<float> ComputeOverdrawSortKeys(const std::vector<uint32_t>& indices_, const std::vector<VertexData>& vertices_,
+        const std::vector<uint32_t>& clusterStarts_);
+
+    // Splits the cache ordered list into clusters and draws the outward facing ones first,
+    // a cluster only cuts where the cache hit rate barely suffers
+    void OptimizeOverdraw(std::vector<uint32_t>& indices_, const std::vector<VertexData>& vertices_);
+
+    // Renumbers vertices in first use order, unreferenced vertices are dropped
+    void OptimizeVertexFetch(std::vector<VertexData>& vertices_, std::vector<uint32_t>& indices_);
+
+    // The three stages above in order. BuildMeshlets later regroups LOD 0 but keeps the
+    // outward facing cluster order and the cache order within every meshlet
+    MeshOptimizationStats OptimizeMesh(std::vector<VertexData>& vertices_, std::vector<uint32_t>& indices_);
+}
@@ -0,0 +1,401 @@
+#include "MeshSimplification.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include <glm/geometric.hpp>
+
+#include "VertexData.h"
+#include "MeshOptimizer.h"
+#include "../../Profiler.h"
+
+namespace Victory
+{
+    // Every LOD aims for this share of the triangles of the one before
+    constexpr float s_LodTriangleRatio{ 0.5f };
+
+    // A LOD keeping more than this share of the triangles before is not worth its indices
+    constexpr float s_LodMinReduction{ 0.85f };
+
+    // Borders resist leaving their line more than faces resist leaving their plane
+    constexpr float s_BorderWeight{ 10.0f };
+
+    enum class VertexKind : uint8_t
+    {
+        // Every edge is shared by two triangles, collapses anywhere
+        eManifold,
+        // On an open edge, collapses along it only
+        eBorder,
+        // UV seam or non-manifold, never moves
+        eLocked
+    };
+
+    // Sum of weighted squared distances to planes, the matrix is symmetric
+    struct Quadric
+    {
+        float a00, a11, a22;
+        float a01, a02, a12;
+        float b0, b1, b2;
+        float c;
+        float weight;
+    };
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        float cost;
+    };
+
+    static Quadric MakePlaneQuadric(const glm::vec3& normal_, const glm::vec3& point_, float weight_)
+    {
+        const float d{ -glm::dot(normal_, point_) };
+
+        Quadric quadric{};
+        quadric.a00 = normal_.x * normal_.x * weight_;
+        quadric.a11 = normal_.y * normal_.y * weight_;
+        quadric.a22 = normal_.z * normal_.z * weight_;
+        quadric.a01 = normal_.x * normal_.y * weight_;
+        quadric.a02 = normal_.x * normal_.z * weight_;
+        quadric.a12 = normal_.y * normal_.z * weight_;
+        quadric.b0 = normal_.x * d * weight_;
+        quadric.b1 = normal_.y * d * weight_;
+        quadric.b2 = normal_.z * d * weight_;
+        quadric.c = d * d * weight_;
+        quadric.weight = weight_;
+        return quadric;
+    }
+
+    static void AddQuadric(Quadric& quadric_, const Quadric& other_)
+    {
+        quadric_.a00 += other_.a00;
+        quadric_.a11 += other_.a11;
+        quadric_.a22 += other_.a22;
+        quadric_.a01 += other_.a01;
+        quadric_.a02 += other_.a02;
+        quadric_.a12 += other_.a12;
+        quadric_.b0 += other_.b0;
+        quadric_.b1 += other_.b1;
+        quadric_.b2 += other_.b2;
+        quadric_.c += other_.c;
+        quadric_.weight += other_.weight;
+    }
+
+    // Mean squared distance of point_ to the planes
+    static float EvaluateQuadric(const Quadric& quadric_, const glm::vec3& point_)
+    {
+        if (quadric_.weight <= 0.0f)
+        {
+            return 0.0f;
+        }
+
+        const float x{ point_.x };
+        const float y{ point_.y };
+        const float z{ point_.z };
+        const float error{
+            quadric_.a00 * x * x + quadric_.a11 * y * y + quadric_.a22 * z * z +
+            2.0f * (quadric_.a01 * x * y + quadric_.a02 * x * z + quadric_.a12 * y * z) +
+            2.0f * (quadric_.b0 * x + quadric_.b1 * y + quadric_.b2 * z) + quadric_.c };
+        return std::max(error, 0.0f) / quadric_.weight;
+    }
+
+    static inline uint64_t EdgeKey(uint32_t a_, uint32_t b_)
+    {
+        return a_ < b_ ? (static_cast<uint64_t>(a_) << 32) | b_ : (static_cast<uint64_t>(b_) << 32) | a_;
+    }
+
+    // Triangles per edge, with vertices of equal position counted as one so UV seams are no borders
+    static void CountEdges(const std::vector<uint32_t>& indices_, const std::vector<uint32_t>& positionIds_,
+        std::unordered_map<uint64_t, uint32_t>& edgeCounts_)
+    {
+        edgeCounts_.clear();
+        edgeCounts_.reserve(indices_.size());
+        for (size_t triangle{ 0 }; triangle < indices_.size(); triangle += 3)
+        {
+            for (uint32_t corner{ 0 }; corner < 3; ++corner)
+            {
+                const uint32_t a{ positionIds_[indices_[triangle + corner]] };
+                const uint32_t b{ positionIds_[indices_[triangle + (corner + 1) % 3]] };
+                ++edgeCounts_[EdgeKey(a, b)];
+            }
+        }
+    }
+
+    float SimplifyMesh(const std::vector<VertexData>& vertices_, const std::vector<uint32_t>& indices_,
+        size_t targetIndexCount_, std::vector<uint32_t>& simplified_)
+    {
+        VICTORY_PROFILE_ZONE("SimplifyMesh");
+
+        simplified_ = indices_;
+        const size_t vertexCount{ vertices_.size() };
+
+        // Wedges sharing a position are UV seams, they are locked
+        std::vector<uint32_t> positionIds(vertexCount);
+        std::vector<VertexKind> kinds(vertexCount, VertexKind::eManifold);
+        {
+            std::unordered_map<glm::vec3, uint32_t> firstWedges;
+            firstWedges.reserve(vertexCount);
+            for (uint32_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+            {
+                auto&& [it, inserted] = firstWedges.try_emplace(vertices_[vertex].position, vertex);
+                positionIds[vertex] = it->second;
+                if (!inserted)
+                {
+                    kinds[vertex] = VertexKind::eLocked;
+                    kinds[it->second] = VertexKind::eLocked;
+                }
+            }
+        }
+
+        std::unordered_map<uint64_t, uint32_t> edgeCounts;
+        CountEdges(simplified_, positionIds, edgeCounts);
+
+        std::vector<Quadric> quadrics(vertexCount, Quadric{});
+        for (size_t triangle{ 0 }; triangle < simplified_.size(); triangle += 3)
+        {
+            const uint32_t* corners{ &simplified_[triangle] };
+            const glm::vec3& p0{ vertices_[corners[0]].position };
+            const glm::vec3& p1{ vertices_[corners[1]].position };
+            const glm::vec3& p2{ vertices_[corners[2]].position };
+
+            const glm::vec3 normal{ glm::cross(p1 - p0, p2 - p0) };
+            const float doubleArea{ glm::length(normal) };
+            if (doubleArea <= 0.0f)
+            {
+                continue;
+            }
+
+            const Quadric faceQuadric{ MakePlaneQuadric(normal / doubleArea, p0, doubleArea * 0.5f) };
+            for (uint32_t corner{ 0 }; corner < 3; ++corner)
+            {
+                AddQuadric(quadrics[corners[corner]], faceQuadric);
+            }
+
+            // Open edges add a plane through the edge, upright on the face, that keeps the outline
+            for (uint32_t corner{ 0 }; corner < 3; ++corner)
+            {
+                const uint32_t a{ corners[corner] };
+                const uint32_t b{ corners[(corner + 1) % 3] };
+                const uint32_t edgeCount{ edgeCounts[EdgeKey(positionIds[a], positionIds[b])] };
+                if (edgeCount == 1)
+                {
+                    const glm::vec3 edge{ vertices_[b].position - vertices_[a].position };
+                    const glm::vec3 edgeNormal{ glm::cross(edge, normal / doubleArea) };
+                    const float edgeLength{ glm::length(edgeNormal) };
+                    if (edgeLength > 0.0f)
+                    {
+                        const Quadric borderQuadric{ MakePlaneQuadric(edgeNormal / edgeLength,
+                            vertices_[a].position, edgeLength * edgeLength * s_BorderWeight) };
+                        AddQuadric(quadrics[a], borderQuadric);
+                        AddQuadric(quadrics[b], borderQuadric);
+                    }
+
+                    if (kinds[a] == VertexKind::eManifold)
+                    {
+                        kinds[a] = VertexKind::eBorder;
+                    }
+                    if (kinds[b] == VertexKind::eManifold)
+                    {
+                        kinds[b] = VertexKind::eBorder;
+                    }
+                }
+                else if (edgeCount > 2)
+                {
+                    kinds[a] = VertexKind::eLocked;
+                    kinds[b] = VertexKind::eLocked;
+                }
+            }
+        }
+
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+        std::vector<uint32_t> adjacency;
+        std::vector<Collapse> collapses;
+        std::vector<uint32_t> collapseTargets(vertexCount);
+        std::vector<uint8_t> touched(vertexCount);
+        float maxCost{ 0.0f };
+
+        const size_t targetTriangleCount{ targetIndexCount_ / 3 };
+        while (simplified_.size() / 3 > targetTriangleCount)
+        {
+            // Triangles around every vertex, flattened
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+            for (uint32_t index : simplified_)
+            {
+                ++adjacencyOffsets[index + 1];
+            }
+            for (size_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+            {
+                adjacencyOffsets[vertex + 1] += adjacencyOffsets[vertex];
+            }
+
+            adjacency.resize(simplified_.size());
+            std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t corner{ 0 }; corner < simplified_.size(); ++corner)
+            {
+                adjacency[adjacencyFill[simplified_[corner]]++] = static_cast<uint32_t>(corner / 3);
+            }
+
+            // Both directions of every edge, cheapest first
+            collapses.clear();
+            for (size_t triangle{ 0 }; triangle < simplified_.size(); triangle += 3)
+            {
+                for (uint32_t corner{ 0 }; corner < 3; ++corner)
+                {
+                    const uint32_t a{ simplified_[triangle + corner] };
+                    const uint32_t b{ simplified_[triangle + (corner + 1) % 3] };
+                    const bool borderEdge{ edgeCounts[EdgeKey(positionIds[a], positionIds[b])] == 1 };
+
+                    for (auto&& [from, to] : { std::pair{ a, b }, std::pair{ b, a } })
+                    {
+                        const bool movable{ kinds[from] == VertexKind::eManifold ||
+                            (kinds[from] == VertexKind::eBorder && kinds[to] != VertexKind::eManifold && borderEdge) };
+                        if (!movable || from == to)
+                        {
+                            continue;
+                        }
+
+                        Quadric quadric{ quadrics[from] };
+                        AddQuadric(quadric, quadrics[to]);
+                        collapses.push_back(Collapse{ from, to, EvaluateQuadric(quadric, vertices_[to].position) });
+                    }
+                }
+            }
+
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& a_, const Collapse& b_)
+            {
+                return a_.cost < b_.cost;
+            });
+
+            // One collapse per neighbourhood and pass, so the flip test sees the final one ring
+            for (uint32_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+            {
+                collapseTargets[vertex] = vertex;
+            }
+            std::fill(touched.begin(), touched.end(), 0);
+
+            const size_t triangleGoal{ simplified_.size() / 3 - targetTriangleCount };
+            size_t removedTriangles{ 0 };
+            size_t appliedCount{ 0 };
+
+            for (auto&& collapse : collapses)
+            {
+                if (removedTriangles >= triangleGoal)
+                {
+                    break;
+                }
+                if (touched[collapse.from] || touched[collapse.to])
+                {
+                    continue;
+                }
+
+                // Triangles that keep existing must not turn over
+                const glm::vec3& target{ vertices_[collapse.to].position };
+                bool flips{ false };
+                size_t removed{ 0 };
+                for (uint32_t i{ adjacencyOffsets[collapse.from] }; i < adjacencyOffsets[collapse.from + 1] && !flips; ++i)
+                {
+                    const uint32_t* corners{ &simplified_[adjacency[i] * 3] };
+                    if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to)
+                    {
+                        ++removed;
+                        continue;
+                    }
+
+                    glm::vec3 positions[3]{ vertices_[corners[0]].position,
+                        vertices_[corners[1]].position, vertices_[corners[2]].position };
+                    const glm::vec3 before{ glm::cross(positions[1] - positions[0], positions[2] - positions[0]) };
+                    for (uint32_t corner{ 0 }; corner < 3; ++corner)
+                    {
+                        if (corners[corner] == collapse.from)
+                        {
+                            positions[corner] = target;
+                        }
+                    }
+                    const glm::vec3 after{ glm::cross(positions[1] - positions[0], positions[2] - positions[0]) };
+                    flips = glm::dot(before, after) <= 0.0f;
+                }
+
+                if (flips)
+                {
+                    continue;
+                }
+
+                collapseTargets[collapse.from] = collapse.to;
+                AddQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+                maxCost = std::max(maxCost, collapse.cost);
+                removedTriangles += removed;
+                ++appliedCount;
+
+                for (uint32_t i{ adjacencyOffsets[collapse.from] }; i < adjacencyOffsets[collapse.from + 1]; ++i)
+                {
+                    const uint32_t* corners{ &simplified_[adjacency[i] * 3] };
+                    touched[corners[0]] = touched[corners[1]] = touched[corners[2]] = 1;
+                }
+            }
+
+            if (appliedCount == 0)
+            {
+                break;
+            }
+
+            // Drops triangles that collapsed, also the ones only flat because two wedges met
+            size_t writeIndex{ 0 };
+            for (size_t triangle{ 0 }; triangle < simplified_.size(); triangle += 3)
+            {
+                const uint32_t a{ collapseTargets[simplified_[triangle + 0]] };
+                const uint32_t b{ collapseTargets[simplified_[triangle + 1]] };
+                const uint32_t c{ collapseTargets[simplified_[triangle + 2]] };
+                if (positionIds[a] == positionIds[b] || positionIds[b] == positionIds[c] || positionIds[a] == positionIds[c])
+                {
+                    continue;
+                }
+
+                simplified_[writeIndex++] = a;
+                simplified_[writeIndex++] = b;
+                simplified_[writeIndex++] = c;
+            }
+            simplified_.resize(writeIndex);
+
+            CountEdges(simplified_, positionIds, edgeCounts);
+        }
+
+        return std::sqrt(maxCost);
+    }
+
+    void BuildLodChain(const std::vector<VertexData>& vertices_, std::vector<uint32_t>& indices_,
+        uint32_t lodLimit_, std::vector<MeshLod>& lods_)
+    {
+        VICTORY_PROFILE_ZONE("BuildLodChain");
+
+        lods_.clear();
+        lods_.push_back(MeshLod{ 0, static_cast<uint32_t>(indices_.size()), 0.0f });
+
+        const uint32_t lodLimit{ std::clamp(lodLimit_, 1u, s_MaxMeshLodCount) };
+        std::vector<uint32_t> source;
+        std::vector<uint32_t> simplified;
+        while (lods_.size() < lodLimit)
+        {
+            const MeshLod previous{ lods_.back() };
+            source.assign(indices_.begin() + previous.firstIndex,
+                indices_.begin() + previous.firstIndex + previous.indexCount);
+
+            const size_t targetIndexCount{ static_cast<size_t>(previous.indexCount / 3 * s_LodTriangleRatio) * 3 };
+            const float error{ SimplifyMesh(vertices_, source, targetIndexCount, simplified) };
+
+            // Locked seams and borders stop the collapses early
+            if (simplified.empty() || simplified.size() > previous.indexCount * s_LodMinReduction)
+            {
+                break;
+            }
+
+            OptimizeVertexCache(simplified, vertices_.size());
+            OptimizeOverdraw(simplified, vertices_);
+
+            // Errors add up, every LOD is simplified from the one before
+            lods_.push_back(MeshLod{ static_cast<uint32_t>(indices_.size()),
+                static_cast<uint32_t>(simplified.size()), previous.error + error });
+            indices_.insert(indices_.end(), simplified.begin(), simplified.end());
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct VertexData;
+
+namespace Victory
+{
+    constexpr uint32_t s_MaxMeshLodCount{ 8 };
+
+    // Index range of one level of detail within the indices of its mesh. error is how far,
+    // in object space, the simplified surface may lie from the original one
+    struct MeshLod
+    {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        float error;
+    };
+
+    // Quadric edge collapse until at most targetIndexCount_ indices are left or no edge can
+    // collapse anymore. Vertices only collapse onto others, so simplified_ indexes vertices_
+    // as well. Open borders only slide along themselves and UV seams stay where they are.
+    // Returns the error of the result
+    float SimplifyMesh(const std::vector<VertexData>& vertices_, const std::vector<uint32_t>& indices_,
+        size_t targetIndexCount_, std::vector<uint32_t>& simplified_);
+
+    // indices_ holds LOD 0 on input, coarser LODs are appended, each simplified from the one
+    // before to about half its triangles and cache optimized. Stops after lodLimit_ LODs or
+    // once simplification stalls. lods_ receives every LOD, LOD 0 included
+    void BuildLodChain(const std::vector<VertexData>& vertices_, std::vector<uint32_t>& indices_,
+        uint32_t lodLimit_, std::vector<MeshLod>& lods_);
+}
@@ -0,0 +1,343 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include "MeshOptimizer.h"
+#include "VertexData.h"
+#include "../../Profiler.h"
+
+namespace Victory
+{
+    // Normals closer than this to a half space cull too rarely to be worth the test
+    constexpr float s_MinConeSpread{ 0.1f };
+
+    static Meshlet MakeMeshlet(const std::vector<VertexData>& vertices_, const std::vector<uint32_t>& indices_,
+        uint32_t firstIndex_, uint32_t indexCount_)
+    {
+        Meshlet meshlet{};
+        meshlet.firstIndex = firstIndex_;
+        meshlet.indexCount = indexCount_;
+
+        glm::vec3 boundsMin{ FLT_MAX };
+        glm::vec3 boundsMax{ -FLT_MAX };
+        for (uint32_t i{ firstIndex_ }; i < firstIndex_ + indexCount_; ++i)
+        {
+            boundsMin = glm::min(boundsMin, vertices_[indices_[i]].position);
+            boundsMax = glm::max(boundsMax, vertices_[indices_[i]].position);
+        }
+
+        const glm::vec3 center{ (boundsMin + boundsMax) * 0.5f };
+        float radius{ 0.f };
+        for (uint32_t i{ firstIndex_ }; i < firstIndex_ + indexCount_; ++i)
+        {
+            radius = std::max(radius, glm::distance(center, vertices_[indices_[i]].position));
+        }
+        meshlet.sphere = glm::vec4{ center, radius };
+
+        // The axis averages the face normals, the cutoff is the sine of the widest angle to it
+        std::vector<glm::vec3> normals;
+        normals.reserve(indexCount_ / 3);
+        glm::vec3 normalSum{ 0.f };
+        for (uint32_t i{ firstIndex_ }; i < firstIndex_ + indexCount_; i += 3)
+        {
+            const glm::vec3& p0{ vertices_[indices_[i + 0]].position };
+            const glm::vec3& p1{ vertices_[indices_[i + 1]].position };
+            const glm::vec3& p2{ vertices_[indices_[i + 2]].position };
+
+            const glm::vec3 normal{ glm::cross(p1 - p0, p2 - p0) };
+            const float length{ glm::length(normal) };
+            if (length > 0.f)
+            {
+                normals.push_back(normal / length);
+                normalSum += normals.back();
+            }
+        }
+
+        meshlet.cone = glm::vec4{ 0.f, 0.f, 0.f, 1.f };
+        const float sumLength{ glm::length(normalSum) };
+        if (normals.empty() || sumLength <= 0.f)
+        {
+            return meshlet;
+        }
+
+        const glm::vec3 axis{ normalSum / sumLength };
+        float minDot{ 1.f };
+        for (auto&& normal : normals)
+        {
+            minDot = std::min(minDot, glm::dot(axis, normal));
+        }
+
+        if (minDot > s_MinConeSpread)
+        {
+            meshlet.cone = glm::vec4{ axis, std::sqrt(1.f - minDot * minDot) };
+        }
+        return meshlet;
+    }
+
+    // Candidate scores weigh the distance to the meshlet centroid against the widening of its cone,
+    // every new vertex a candidate brings makes it that much more expensive
+    constexpr float s_ConeWeight{ 0.5f };
+    constexpr float s_NewVertexWeight{ 0.25f };
+
+    struct MeshletTriangle
+    {
+        glm::vec3 centroid;
+        glm::vec3 normal;
+    };
+
+    void BuildMeshlets(const std::vector<VertexData>& vertices_, std::vector<uint32_t>& indices_,
+        uint32_t firstIndex_, uint32_t indexCount_, std::vector<Meshlet>& meshlets_)
+    {
+        VICTORY_PROFILE_ZONE("BuildMeshlets");
+
+        meshlets_.clear();
+
+        const uint32_t triangleCount{ indexCount_ / 3 };
+        if (triangleCount == 0)
+        {
+            return;
+        }
+        const uint32_t* triangleIndices{ indices_.data() + firstIndex_ };
+
+        std::vector<MeshletTriangle> triangles(triangleCount);
+        float areaSum{ 0.f };
+        for (uint32_t triangle{ 0 }; triangle < triangleCount; ++triangle)
+        {
+            const glm::vec3& p0{ vertices_[triangleIndices[triangle * 3 + 0]].position };
+            const glm::vec3& p1{ vertices_[triangleIndices[triangle * 3 + 1]].position };
+            const glm::vec3& p2{ vertices_[triangleIndices[triangle * 3 + 2]].position };
+
+            const glm::vec3 normal{ glm::cross(p1 - p0, p2 - p0) };
+            const float length{ glm::length(normal) };
+            triangles[triangle].centroid = (p0 + p1 + p2) / 3.f;
+            triangles[triangle].normal = length > 0.f ? normal / length : glm::vec3{ 0.f };
+            areaSum += length * 0.5f;
+        }
+
+        // Radius of a full meshlet of average triangles, normalizes the centroid distance
+        float expectedRadius{ std::sqrt(areaSum / static_cast<float>(triangleCount) * s_MeshletMaxTriangles) * 0.5f };
+        if (expectedRadius <= 0.f)
+        {
+            expectedRadius = 1.f;
+        }
+
+        // Triangles around every vertex, liveCounts drops as they are taken
+        std::vector<uint32_t> adjacencyOffsets(vertices_.size() + 1, 0);
+        for (uint32_t i{ 0 }; i < triangleCount * 3; ++i)
+        {
+            ++adjacencyOffsets[triangleIndices[i] + 1];
+        }
+        for (size_t vertex{ 0 }; vertex < vertices_.size(); ++vertex)
+        {
+            adjacencyOffsets[vertex + 1] += adjacencyOffsets[vertex];
+        }
+        std::vector<uint32_t> liveCounts(vertices_.size());
+        for (size_t vertex{ 0 }; vertex < vertices_.size(); ++vertex)
+        {
+            liveCounts[vertex] = adjacencyOffsets[vertex + 1] - adjacencyOffsets[vertex];
+        }
+        std::vector<uint32_t> adjacency(triangleCount * 3);
+        {
+            std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (uint32_t i{ 0 }; i < triangleCount * 3; ++i)
+            {
+                adjacency[cursors[triangleIndices[i]]++] = i / 3;
+            }
+        }
+
+        // Vertices and candidate triangles are stamped with the meshlet they were last seen by
+        std::vector<uint32_t> vertexStamps(vertices_.size(), UINT32_MAX);
+        std::vector<uint32_t> triangleStamps(triangleCount, UINT32_MAX);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> meshletTriangles;
+        meshletTriangles.reserve(s_MeshletMaxTriangles);
+
+        std::vector<uint32_t> reordered;
+        reordered.reserve(triangleCount * 3);
+        std::vector<uint32_t> meshletStarts;
+
+        uint32_t stamp{ 0 };
+        uint32_t meshletVertices{ 0 };
+        glm::vec3 centroidSum{ 0.f };
+        glm::vec3 normalSum{ 0.f };
+
+        const auto addTriangle = [&](uint32_t triangle_)
+        {
+            emitted[triangle_] = true;
+            meshletTriangles.push_back(triangle_);
+            centroidSum += triangles[triangle_].centroid;
+            normalSum += triangles[triangle_].normal;
+
+            for (uint32_t corner{ 0 }; corner < 3; ++corner)
+            {
+                const uint32_t vertex{ triangleIndices[triangle_ * 3 + corner] };
+                if (vertexStamps[vertex] != stamp)
+                {
+                    vertexStamps[vertex] = stamp;
+                    ++meshletVertices;
+                }
+                --liveCounts[vertex];
+
+                for (uint32_t i{ adjacencyOffsets[vertex] }; i < adjacencyOffsets[vertex + 1]; ++i)
+                {
+                    const uint32_t neighbour{ adjacency[i] };
+                    if (!emitted[neighbour] && triangleStamps[neighbour] != stamp)
+                    {
+                        triangleStamps[neighbour] = stamp;
+                        candidates.push_back(neighbour);
+                    }
+                }
+            }
+        };
+
+        uint32_t seedCursor{ 0 };
+        uint32_t emittedCount{ 0 };
+        while (emittedCount < triangleCount)
+        {
+            // Continue next to the last meshlet on the triangle with the fewest live neighbours,
+            // so the border is eaten before it fragments into islands
+            uint32_t seed{ UINT32_MAX };
+            uint32_t seedLive{ UINT32_MAX };
+            for (auto&& candidate : candidates)
+            {
+                if (emitted[candidate])
+                {
+                    continue;
+                }
+                const uint32_t live{ liveCounts[triangleIndices[candidate * 3 + 0]] +
+                    liveCounts[triangleIndices[candidate * 3 + 1]] + liveCounts[triangleIndices[candidate * 3 + 2]] };
+                if (live < seedLive)
+                {
+                    seed = candidate;
+                    seedLive = live;
+                }
+            }
+            if (seed == UINT32_MAX)
+            {
+                while (emitted[seedCursor])
+                {
+                    ++seedCursor;
+                }
+                seed = seedCursor;
+            }
+
+            ++stamp;
+            candidates.clear();
+            meshletTriangles.clear();
+            meshletVertices = 0;
+            centroidSum = glm::vec3{ 0.f };
+            normalSum = glm::vec3{ 0.f };
+            addTriangle(seed);
+
+            while (meshletTriangles.size() < s_MeshletMaxTriangles)
+            {
+                const glm::vec3 centroid{ centroidSum / static_cast<float>(meshletTriangles.size()) };
+                const float normalLength{ glm::length(normalSum) };
+                const glm::vec3 axis{ normalLength > 0.f ? normalSum / normalLength : glm::vec3{ 0.f } };
+
+                // A triangle holding the last reference to a vertex brings no new vertices, taking it
+                // now keeps the vertex from ending up alone in a later meshlet
+                uint32_t best{ UINT32_MAX };
+                float bestScore{ FLT_MAX };
+                size_t liveCandidates{ 0 };
+                for (size_t i{ 0 }; i < candidates.size(); ++i)
+                {
+                    const uint32_t candidate{ candidates[i] };
+                    if (emitted[candidate])
+                    {
+                        continue;
+                    }
+                    candidates[liveCandidates++] = candidate;
+
+                    uint32_t newVertices{ 0 };
+                    bool lastReference{ false };
+                    for (uint32_t corner{ 0 }; corner < 3; ++corner)
+                    {
+                        const uint32_t vertex{ triangleIndices[candidate * 3 + corner] };
+                        newVertices += vertexStamps[vertex] != stamp;
+                        lastReference |= liveCounts[vertex] == 1;
+                    }
+                    if (meshletVertices + newVertices > s_MeshletMaxVertices)
+                    {
+                        continue;
+                    }
+
+                    const float vertexCost{ lastReference ? 0.f : static_cast<float>(newVertices) };
+                    const float distance{ glm::distance(triangles[candidate].centroid, centroid) / expectedRadius };
+                    const float cone{ std::max(1.f - glm::dot(triangles[candidate].normal, axis) * s_ConeWeight, 1e-3f) };
+                    const float score{ (1.f + distance * (1.f - s_ConeWeight)) * cone * (1.f + vertexCost * s_NewVertexWeight) };
+                    if (score < bestScore)
+                    {
+                        best = candidate;
+                        bestScore = score;
+                    }
+                }
+                candidates.resize(liveCandidates);
+
+                if (best == UINT32_MAX)
+                {
+                    break;
+                }
+                addTriangle(best);
+            }
+
+            std::sort(meshletTriangles.begin(), meshletTriangles.end());
+            meshletStarts.push_back(static_cast<uint32_t>(reordered.size() / 3));
+            for (auto&& triangle : meshletTriangles)
+            {
+                reordered.insert(reordered.end(), triangleIndices + triangle * 3, triangleIndices + triangle * 3 + 3);
+            }
+            emittedCount += static_cast<uint32_t>(meshletTriangles.size());
+        }
+        meshletStarts.push_back(triangleCount);
+
+        // Growing meshlets undoes the cluster order of OptimizeOverdraw, meshlets are sorted by
+        // the same outward facing key instead
+        const uint32_t meshletCount{ static_cast<uint32_t>(meshletStarts.size()) - 1 };
+        const std::vector<float> sortKeys{ ComputeOverdrawSortKeys(reordered, vertices_, meshletStarts) };
+        std::vector<uint32_t> meshletOrder(meshletCount);
+        std::iota(meshletOrder.begin(), meshletOrder.end(), 0);
+        std::stable_sort(meshletOrder.begin(), meshletOrder.end(), [&](uint32_t a_, uint32_t b_)
+        {
+            return sortKeys[a_] > sortKeys[b_];
+        });
+
+        // and the triangles of every meshlet are cache optimized again, on local vertex indices
+        // so the optimizer only touches the meshlet's own vertices
+        std::vector<uint32_t> localVertices;
+        std::vector<uint32_t> localIndices;
+        uint32_t meshletFirst{ firstIndex_ };
+        for (uint32_t meshlet : meshletOrder)
+        {
+            localVertices.clear();
+            localIndices.assign(reordered.begin() + meshletStarts[meshlet] * 3, reordered.begin() + meshletStarts[meshlet + 1] * 3);
+            for (uint32_t& index : localIndices)
+            {
+                const uint32_t local{ static_cast<uint32_t>(
+                    std::find(localVertices.begin(), localVertices.end(), index) - localVertices.begin()) };
+                if (local == localVertices.size())
+                {
+                    localVertices.push_back(index);
+                }
+                index = local;
+            }
+
+            OptimizeVertexCache(localIndices, localVertices.size());
+
+            for (size_t i{ 0 }; i < localIndices.size(); ++i)
+            {
+                indices_[meshletFirst + i] = localVertices[localIndices[i]];
+            }
+            const uint32_t meshletSize{ static_cast<uint32_t>(localIndices.size()) };
+            meshlets_.push_back(MakeMeshlet(vertices_, indices_, meshletFirst, meshletSize));
+            meshletFirst += meshletSize;
+        }
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/ext/vector_float4.hpp>
+
+struct VertexData;
+
+namespace Victory
+{
+    constexpr uint32_t s_MeshletMaxVertices{ 64 };
+    constexpr uint32_t s_MeshletMaxTriangles{ 124 };
+
+    // A run of triangles with at most s_MeshletMaxVertices distinct vertices. The object space
+    // bounding sphere and the cone of its triangle normals, axis and cutoff. A cutoff of 1
+    // means the normals spread too far for the cone to ever cull
+    struct Meshlet
+    {
+        glm::vec4 sphere;
+        glm::vec4 cone;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+    };
+
+    // Splits indices_ [firstIndex_, firstIndex_ + indexCount_) into meshlets grown over adjacent
+    // triangles and reorders the range so every meshlet is a range of the index buffer, culled
+    // ones are simply not drawn
+    void BuildMeshlets(const std::vector<VertexData>& vertices_, std::vector<uint32_t>& indices_,
+        uint32_t firstIndex_, uint32_t indexCount_, std::vector<Meshlet>& meshlets_);
+}
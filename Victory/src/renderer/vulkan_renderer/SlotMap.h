@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+namespace Victory
+{
+    // Slot index plus the generation the slot had when the handle was issued,
+    // a handle goes stale once its slot is removed, even if the slot is reused
+    template<typename Tag>
+    struct Handle
+    {
+        uint32_t index{ UINT32_MAX };
+        uint32_t generation{ 0 };
+
+        inline bool IsValid() const
+        {
+            return index != UINT32_MAX;
+        }
+
+        bool operator==(const Handle&) const = default;
+    };
+
+    // Stores values in slots that never move, removed slots are reused in LIFO order
+    template<typename T, typename Tag = T>
+    class SlotMap
+    {
+    public:
+
+        using HandleType = Handle<Tag>;
+
+        HandleType Insert(T&& value_)
+        {
+            uint32_t index;
+            if (!m_FreeSlots.empty())
+            {
+                index = m_FreeSlots.back();
+                m_FreeSlots.pop_back();
+                m_Slots[index].value = std::move(value_);
+                m_Slots[index].alive = true;
+            }
+            else
+            {
+                index = static_cast<uint32_t>(m_Slots.size());
+                m_Slots.push_back(Slot{ std::move(value_), 0, true });
+            }
+
+            ++m_Count;
+            return HandleType{ index, m_Slots[index].generation };
+        }
+
+        bool Remove(HandleType handle_)
+        {
+            if (!Contains(handle_))
+            {
+                return false;
+            }
+
+            // The value stays in place until the slot is reused
+            Slot& slot{ m_Slots[handle_.index] };
+            slot.alive = false;
+            ++slot.generation;
+            m_FreeSlots.push_back(handle_.index);
+            --m_Count;
+            return true;
+        }
+
+        inline bool Contains(HandleType handle_) const
+        {
+            return handle_.index < m_Slots.size() &&
+                m_Slots[handle_.index].alive &&
+                m_Slots[handle_.index].generation == handle_.generation;
+        }
+
+        inline T* Get(HandleType handle_)
+        {
+            return Contains(handle_) ? &m_Slots[handle_.index].value : nullptr;
+        }
+
+        inline const T* Get(HandleType handle_) const
+        {
+            return Contains(handle_) ? &m_Slots[handle_.index].value : nullptr;
+        }
+
+        // Raw slot access for iteration, index_ has to be below GetCapacity()
+        inline bool IsAlive(uint32_t index_) const
+        {
+            return m_Slots[index_].alive;
+        }
+
+        inline T& At(uint32_t index_)
+        {
+            return m_Slots[index_].value;
+        }
+
+        inline const T& At(uint32_t index_) const
+        {
+            return m_Slots[index_].value;
+        }
+
+        inline HandleType GetHandle(uint32_t index_) const
+        {
+            return HandleType{ index_, m_Slots[index_].generation };
+        }
+
+        inline uint32_t GetCapacity() const
+        {
+            return static_cast<uint32_t>(m_Slots.size());
+        }
+
+        inline uint32_t GetCount() const
+        {
+            return m_Count;
+        }
+
+        template<typename Fn>
+        void ForEach(Fn&& fn_)
+        {
+            for (uint32_t i{ 0 }; i < m_Slots.size(); ++i)
+            {
+                if (m_Slots[i].alive)
+                {
+                    fn_(GetHandle(i), m_Slots[i].value);
+                }
+            }
+        }
+
+        void Clear()
+        {
+            m_Slots.clear();
+            m_FreeSlots.clear();
+            m_Count = 0;
+        }
+
+    private:
+
+        struct Slot
+        {
+            T value;
+            uint32_t generation{ 0 };
+            bool alive{ false };
+        };
+
+        std::vector<Slot> m_Slots;
+        std::vector<uint32_t> m_FreeSlots;
+        uint32_t m_Count{ 0 };
+    };
+}
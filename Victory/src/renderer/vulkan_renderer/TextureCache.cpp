@@ -0,0 +1,227 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+
+namespace Victory
+{
+    constexpr uint32_t s_TextureCacheMagic{ 0x58455456 }; // "VTEX"
+    constexpr uint32_t s_TextureCacheVersion{ 1 };
+    // Also a multiple of the texel size, as buffer to image copies require
+    constexpr uint64_t s_TextureCacheAlignment{ 16 };
+    constexpr uint32_t s_TexelSize{ 4 };
+
+    struct FilterTap
+    {
+        uint32_t source;
+        float weight;
+    };
+
+    // Source texels covered by every destination texel along one axis, weighted by coverage
+    static std::vector<std::vector<FilterTap>> MakeFilterTaps(uint32_t sourceSize_, uint32_t size_)
+    {
+        std::vector<std::vector<FilterTap>> taps(size_);
+        const float scale{ static_cast<float>(sourceSize_) / static_cast<float>(size_) };
+        for (uint32_t i{ 0 }; i < size_; ++i)
+        {
+            const float begin{ static_cast<float>(i) * scale };
+            const float end{ begin + scale };
+            for (uint32_t source{ static_cast<uint32_t>(begin) }; source < sourceSize_ && static_cast<float>(source) < end; ++source)
+            {
+                const float coverage{ std::min(end, static_cast<float>(source + 1)) - std::max(begin, static_cast<float>(source)) };
+                if (coverage > 0.f)
+                {
+                    taps[i].push_back(FilterTap{ source, coverage / scale });
+                }
+            }
+        }
+        return taps;
+    }
+
+    static void Downsample(const unsigned char* source_, uint32_t sourceWidth_, uint32_t sourceHeight_,
+        unsigned char* destination_, uint32_t width_, uint32_t height_)
+    {
+        const auto columns{ MakeFilterTaps(sourceWidth_, width_) };
+        const auto rows{ MakeFilterTaps(sourceHeight_, height_) };
+
+        for (uint32_t y{ 0 }; y < height_; ++y)
+        {
+            for (uint32_t x{ 0 }; x < width_; ++x)
+            {
+                float texel[s_TexelSize]{};
+                for (auto&& row : rows[y])
+                {
+                    for (auto&& column : columns[x])
+                    {
+                        const float weight{ row.weight * column.weight };
+                        const unsigned char* sourceTexel{ source_ +
+                            (static_cast<size_t>(row.source) * sourceWidth_ + column.source) * s_TexelSize };
+                        for (uint32_t c{ 0 }; c < s_TexelSize; ++c)
+                        {
+                            texel[c] += weight * sourceTexel[c];
+                        }
+                    }
+                }
+
+                unsigned char* destinationTexel{ destination_ + (static_cast<size_t>(y) * width_ + x) * s_TexelSize };
+                for (uint32_t c{ 0 }; c < s_TexelSize; ++c)
+                {
+                    destinationTexel[c] = static_cast<unsigned char>(std::clamp(texel[c] + 0.5f, 0.f, 255.f));
+                }
+            }
+        }
+    }
+
+    TextureMipChain BuildMipChain(const unsigned char* pixels_, uint32_t width_, uint32_t height_)
+    {
+        TextureMipChain mipChain{};
+
+        const uint32_t levelCount{ static_cast<uint32_t>(std::floor(std::log2(std::max(width_, height_)))) + 1 };
+        uint64_t dataSize{ 0 };
+        for (uint32_t level{ 0 }; level < levelCount; ++level)
+        {
+            TextureCacheLevel& mip{ mipChain.levels.emplace_back() };
+            mip.width = std::max(width_ >> level, 1u);
+            mip.height = std::max(height_ >> level, 1u);
+            mip.offset = dataSize;
+            mip.size = static_cast<uint64_t>(mip.width) * mip.height * s_TexelSize;
+            dataSize = (mip.offset + mip.size + s_TextureCacheAlignment - 1) & ~(s_TextureCacheAlignment - 1);
+        }
+
+        mipChain.data.resize(static_cast<size_t>(dataSize));
+        memcpy(mipChain.data.data(), pixels_, static_cast<size_t>(mipChain.levels[0].size));
+
+        // Every level from the one above, the chain stays cheap for large textures
+        for (uint32_t level{ 1 }; level < levelCount; ++level)
+        {
+            const TextureCacheLevel& source{ mipChain.levels[level - 1] };
+            const TextureCacheLevel& mip{ mipChain.levels[level] };
+            Downsample(mipChain.data.data() + source.offset, source.width, source.height,
+                mipChain.data.data() + mip.offset, mip.width, mip.height);
+        }
+
+        return mipChain;
+    }
+
+    TextureCache::TextureCache(const std::string& sourcePath_)
+        : AssetCache{ sourcePath_, "vtex" } {}
+
+    bool TextureCache::Load()
+    {
+        if (!Open(sizeof(TextureCacheHeader)))
+        {
+            return false;
+        }
+
+        TextureCacheHeader header;
+        memcpy(&header, m_CacheFile.GetData(), sizeof(header));
+
+        if (!ValidateHeader(header) || !IsCurrent(header.source, offsetof(TextureCacheHeader, source)))
+        {
+            Release();
+            return false;
+        }
+
+        m_Header = header;
+        m_Levels.resize(header.levelCount);
+        memcpy(m_Levels.data(), m_CacheFile.GetData() + header.levelOffset, sizeof(TextureCacheLevel) * header.levelCount);
+
+        if (!ValidateLevels(header))
+        {
+            Release();
+            return false;
+        }
+
+        std::cout << "Texture cache hit: " << m_SourcePath << std::endl;
+        return true;
+    }
+
+    void TextureCache::Store(const TextureMipChain& mipChain_)
+    {
+        Release();
+
+        TextureCacheHeader header{};
+        if (!MakeSourceKey(header.source))
+        {
+            return;
+        }
+
+        header.magic = s_TextureCacheMagic;
+        header.version = s_TextureCacheVersion;
+        header.pathLength = static_cast<uint32_t>(m_SourcePath.size());
+        header.texelSize = s_TexelSize;
+        header.width = mipChain_.levels[0].width;
+        header.height = mipChain_.levels[0].height;
+        header.levelCount = static_cast<uint32_t>(mipChain_.levels.size());
+        header.levelOffset = AlignUp(sizeof(TextureCacheHeader) + header.pathLength, s_TextureCacheAlignment);
+        header.dataOffset = AlignUp(header.levelOffset + sizeof(TextureCacheLevel) * header.levelCount,
+            s_TextureCacheAlignment);
+        header.dataSize = mipChain_.data.size();
+
+        Write([&](std::ofstream& file_)
+        {
+            const char padding[s_TextureCacheAlignment]{};
+            const uint64_t levelSize{ sizeof(TextureCacheLevel) * header.levelCount };
+            file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file_.write(m_SourcePath.data(), header.pathLength);
+            file_.write(padding, header.levelOffset - sizeof(header) - header.pathLength);
+            file_.write(reinterpret_cast<const char*>(mipChain_.levels.data()), levelSize);
+            file_.write(padding, header.dataOffset - header.levelOffset - levelSize);
+            file_.write(reinterpret_cast<const char*>(mipChain_.data.data()), header.dataSize);
+        });
+    }
+
+    void TextureCache::Release()
+    {
+        m_CacheFile.Close();
+        m_Header = {};
+        m_Levels.clear();
+    }
+
+    bool TextureCache::ValidateHeader(const TextureCacheHeader& header_) const
+    {
+        if (header_.magic != s_TextureCacheMagic ||
+            header_.version != s_TextureCacheVersion ||
+            header_.texelSize != s_TexelSize ||
+            header_.width == 0 || header_.height == 0 || header_.levelCount == 0 ||
+            header_.levelCount > static_cast<uint32_t>(std::bit_width(std::max(header_.width, header_.height))))
+        {
+            return false;
+        }
+
+        if (!HasSourcePath(header_.pathLength, sizeof(TextureCacheHeader)))
+        {
+            return false;
+        }
+
+        const uint64_t fileSize{ m_CacheFile.GetSize() };
+        return header_.dataOffset % s_TextureCacheAlignment == 0 &&
+            header_.levelOffset + sizeof(TextureCacheLevel) * header_.levelCount <= header_.dataOffset &&
+            header_.dataOffset + header_.dataSize <= fileSize;
+    }
+
+    bool TextureCache::ValidateLevels(const TextureCacheHeader& header_) const
+    {
+        // Every level is copied into the image as width x height texels, a corrupt entry must
+        // not size the image wrong or read past the texel data, it is rebuilt instead
+        for (uint32_t i{ 0 }; i < header_.levelCount; ++i)
+        {
+            const TextureCacheLevel& level{ m_Levels[i] };
+            if (level.width != std::max(header_.width >> i, 1u) ||
+                level.height != std::max(header_.height >> i, 1u) ||
+                level.size != static_cast<uint64_t>(level.width) * level.height * s_TexelSize ||
+                level.offset % s_TextureCacheAlignment != 0 ||
+                level.offset > header_.dataSize || level.size > header_.dataSize - level.offset)
+            {
+                std::cout << "Texture cache has inconsistent mip levels: " << m_SourcePath << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+}
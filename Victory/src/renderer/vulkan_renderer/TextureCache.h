@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "AssetCache.h"
+
+namespace Victory
+{
+    struct TextureCacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        AssetSourceKey source;
+        uint32_t pathLength;
+        uint32_t texelSize;
+        uint32_t width;
+        uint32_t height;
+        uint32_t levelCount;
+        uint32_t reserved;
+        uint64_t levelOffset;
+        uint64_t dataOffset;
+        uint64_t dataSize;
+    };
+
+    // Offset is relative to the start of the texel data
+    struct TextureCacheLevel
+    {
+        uint64_t offset;
+        uint64_t size;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    // RGBA8 texels of every mip level, each level starts aligned
+    struct TextureMipChain
+    {
+        std::vector<TextureCacheLevel> levels;
+        std::vector<unsigned char> data;
+    };
+
+    // Downsamples with a box filter that weights source texels by their coverage,
+    // so odd sizes do not drop rows and columns the way a 2x2 blit does
+    TextureMipChain BuildMipChain(const unsigned char* pixels_, uint32_t width_, uint32_t height_);
+
+    // Decoded texture with its complete mip chain, laid out to be copied into
+    // the image as is: one staging copy and one region per level
+    class TextureCache : public AssetCache
+    {
+    public:
+
+        explicit TextureCache(const std::string& sourcePath_);
+
+        bool Load();
+        void Store(const TextureMipChain& mipChain_);
+        void Release();
+
+        inline const void* GetData() const
+        {
+            return m_CacheFile.GetData() + m_Header.dataOffset;
+        }
+
+        inline size_t GetDataSize() const
+        {
+            return static_cast<size_t>(m_Header.dataSize);
+        }
+
+        inline const std::vector<TextureCacheLevel>& GetLevels() const
+        {
+            return m_Levels;
+        }
+
+    private:
+
+        bool ValidateHeader(const TextureCacheHeader& header_) const;
+        bool ValidateLevels(const TextureCacheHeader& header_) const;
+
+    private:
+
+        TextureCacheHeader m_Header{};
+        std::vector<TextureCacheLevel> m_Levels;
+    };
+}
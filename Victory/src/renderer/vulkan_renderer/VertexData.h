@@ -1,24 +1,34 @@
 #pragma once
 
+#include <cstdint>
+
 #include <glm/ext/vector_float3.hpp>
 #include <glm/ext/vector_float2.hpp>
 #include <glm/gtx/hash.hpp>
 
+// Vertex as imported, deduplicated and optimized before it is packed
 struct VertexData
 {
     glm::vec3 position;
-    glm::vec3 color;
     glm::vec2 texCoord;
 
     bool operator==(const VertexData& other) const {
-        return position == other.position && color == other.color && texCoord == other.texCoord;
+        return position == other.position && texCoord == other.texCoord;
     }
 };
 
+// Vertex as stored in the mesh cache and the geometry pool, 12 bytes. Positions are unorm16
+// within the mesh AABB, the fourth component only pads, texture coordinates are half floats
+struct PackedVertex
+{
+    uint16_t position[4];
+    uint16_t texCoord[2];
+};
+
 namespace std {
     template<> struct hash<VertexData> {
         size_t operator()(VertexData const& vertex) const {
-            return ((hash<glm::vec3>()(vertex.position) ^ (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^ (hash<glm::vec2>()(vertex.texCoord) << 1);
+            return (hash<glm::vec3>()(vertex.position) >> 1) ^ (hash<glm::vec2>()(vertex.texCoord) << 1);
         }
     };
 }
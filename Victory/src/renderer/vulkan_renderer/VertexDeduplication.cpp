@@ -0,0 +1,173 @@
+#include "VertexDeduplication.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "VertexData.h"
+#include "../../ThreadPool.h"
+
+namespace Victory
+{
+    constexpr uint32_t s_ParallelCornerThreshold{ 1 << 16 };
+    constexpr uint32_t s_CornersPerTask{ 1 << 14 };
+    constexpr uint32_t s_ShardsPerThread{ 4 };
+
+    static void DeduplicateSerial(const std::vector<VertexData>& corners_,
+        std::vector<VertexData>& vertices_, std::vector<uint32_t>& indices_)
+    {
+        std::unordered_map<VertexData, uint32_t> uniqueVertices;
+        uniqueVertices.reserve(corners_.size());
+        indices_.reserve(corners_.size());
+
+        for (auto&& corner : corners_)
+        {
+            auto&& [it, inserted] = uniqueVertices.try_emplace(corner, static_cast<uint32_t>(vertices_.size()));
+            if (inserted)
+            {
+                vertices_.emplace_back(corner);
+            }
+            indices_.emplace_back(it->second);
+        }
+    }
+
+    static inline uint32_t ShardOf(size_t hash_, uint32_t shardCount_)
+    {
+        const uint64_t hash{ static_cast<uint64_t>(hash_) };
+        return static_cast<uint32_t>((hash ^ (hash >> 32)) % shardCount_);
+    }
+
+    void DeduplicateVertices(const std::vector<VertexData>& corners_,
+        std::vector<VertexData>& vertices_, std::vector<uint32_t>& indices_)
+    {
+        vertices_.clear();
+        indices_.clear();
+
+        ThreadPool* threadPool{ ThreadPool::Init() };
+        const uint32_t cornerCount{ static_cast<uint32_t>(corners_.size()) };
+        if (cornerCount < s_ParallelCornerThreshold || threadPool->GetThreadCount() == 1)
+        {
+            DeduplicateSerial(corners_, vertices_, indices_);
+            return;
+        }
+
+        const uint32_t taskCount{ (cornerCount + s_CornersPerTask - 1) / s_CornersPerTask };
+        const uint32_t shardCount{ threadPool->GetThreadCount() * s_ShardsPerThread };
+
+        auto&& ForEachCorner = [&](uint32_t task_, auto&& function_)
+        {
+            const uint32_t first{ task_ * s_CornersPerTask };
+            const uint32_t last{ std::min(first + s_CornersPerTask, cornerCount) };
+            for (uint32_t corner{ first }; corner < last; ++corner)
+            {
+                function_(corner);
+            }
+        };
+
+        // Hash every corner once and bucket it by shard. Lists are per task,
+        // so walking them in task order visits corners in their original order
+        std::vector<size_t> hashes(cornerCount);
+        std::vector<std::vector<uint32_t>> buckets(static_cast<size_t>(taskCount) * shardCount);
+
+        threadPool->ParallelFor(taskCount, 1, [&](uint32_t begin_, uint32_t end_, uint32_t)
+        {
+            const std::hash<VertexData> hasher;
+            for (uint32_t task{ begin_ }; task < end_; ++task)
+            {
+                std::vector<uint32_t>* taskBuckets{ &buckets[static_cast<size_t>(task) * shardCount] };
+                ForEachCorner(task, [&](uint32_t corner_)
+                {
+                    hashes[corner_] = hasher(corners_[corner_]);
+                    taskBuckets[ShardOf(hashes[corner_], shardCount)].emplace_back(corner_);
+                });
+            }
+        });
+
+        // Each shard owns a disjoint part of the key space, so shards are deduplicated
+        // independently. Keys are corner ids hashed through the precomputed table
+        struct CornerHash
+        {
+            const size_t* hashes;
+            size_t operator()(uint32_t corner_) const { return hashes[corner_]; }
+        };
+
+        struct CornerEqual
+        {
+            const VertexData* corners;
+            bool operator()(uint32_t lhs_, uint32_t rhs_) const { return corners[lhs_] == corners[rhs_]; }
+        };
+
+        std::vector<uint32_t> cornerSlots(cornerCount);
+        std::vector<uint8_t> firstSeen(cornerCount, 0);
+        std::vector<std::vector<uint32_t>> slotToVertex(shardCount);
+
+        threadPool->ParallelFor(shardCount, 1, [&](uint32_t begin_, uint32_t end_, uint32_t)
+        {
+            for (uint32_t shard{ begin_ }; shard < end_; ++shard)
+            {
+                std::unordered_map<uint32_t, uint32_t, CornerHash, CornerEqual> slots(
+                    cornerCount / shardCount, CornerHash{ hashes.data() }, CornerEqual{ corners_.data() });
+
+                for (uint32_t task{ 0 }; task < taskCount; ++task)
+                {
+                    for (auto&& corner : buckets[static_cast<size_t>(task) * shardCount + shard])
+                    {
+                        // Single probe: either finds the earlier twin or claims a new slot
+                        auto&& [it, inserted] = slots.try_emplace(corner, static_cast<uint32_t>(slots.size()));
+                        cornerSlots[corner] = it->second;
+                        firstSeen[corner] = inserted;
+                    }
+                }
+
+                slotToVertex[shard].resize(slots.size());
+            }
+        });
+
+        // Unique vertices are numbered in first-seen order: prefix sum over tasks
+        std::vector<uint32_t> taskVertexOffsets(taskCount + 1, 0);
+        threadPool->ParallelFor(taskCount, 1, [&](uint32_t begin_, uint32_t end_, uint32_t)
+        {
+            for (uint32_t task{ begin_ }; task < end_; ++task)
+            {
+                uint32_t count{ 0 };
+                ForEachCorner(task, [&](uint32_t corner_) { count += firstSeen[corner_]; });
+                taskVertexOffsets[task + 1] = count;
+            }
+        });
+
+        for (uint32_t task{ 0 }; task < taskCount; ++task)
+        {
+            taskVertexOffsets[task + 1] += taskVertexOffsets[task];
+        }
+
+        vertices_.resize(taskVertexOffsets[taskCount]);
+        indices_.resize(cornerCount);
+
+        threadPool->ParallelFor(taskCount, 1, [&](uint32_t begin_, uint32_t end_, uint32_t)
+        {
+            for (uint32_t task{ begin_ }; task < end_; ++task)
+            {
+                uint32_t vertex{ taskVertexOffsets[task] };
+                ForEachCorner(task, [&](uint32_t corner_)
+                {
+                    if (firstSeen[corner_])
+                    {
+                        slotToVertex[ShardOf(hashes[corner_], shardCount)][cornerSlots[corner_]] = vertex;
+                        vertices_[vertex++] = corners_[corner_];
+                    }
+                });
+            }
+        });
+
+        // Merge: remap shard slots to the global vertex ids
+        threadPool->ParallelFor(taskCount, 1, [&](uint32_t begin_, uint32_t end_, uint32_t)
+        {
+            for (uint32_t task{ begin_ }; task < end_; ++task)
+            {
+                ForEachCorner(task, [&](uint32_t corner_)
+                {
+                    indices_[corner_] = slotToVertex[ShardOf(hashes[corner_], shardCount)][cornerSlots[corner_]];
+                });
+            }
+        });
+    }
+}
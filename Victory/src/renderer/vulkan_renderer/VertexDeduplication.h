@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+struct VertexData;
+
+namespace Victory
+{
+    // Collapses the per-corner vertex stream into unique vertices plus an index list.
+    // Vertices keep first-seen order, so the result does not depend on the thread count
+    void DeduplicateVertices(const std::vector<VertexData>& corners_,
+        std::vector<VertexData>& vertices_, std::vector<uint32_t>& indices_);
+}
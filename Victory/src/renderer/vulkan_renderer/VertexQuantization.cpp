@@ -0,0 +1,43 @@
+#include "VertexQuantization.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include "VertexData.h"
+
+namespace Victory
+{
+    void QuantizeVertices(const std::vector<VertexData>& vertices_, const MeshBounds& bounds_,
+        std::vector<PackedVertex>& packed_)
+    {
+        const glm::vec3 extent{ bounds_.aabbMax - bounds_.aabbMin };
+
+        // A flat axis packs to 0 and is scaled back by 0
+        glm::vec3 inverseExtent{ 0.0f };
+        for (int axis{ 0 }; axis < 3; ++axis)
+        {
+            inverseExtent[axis] = extent[axis] > 0.0f ? 1.0f / extent[axis] : 0.0f;
+        }
+
+        packed_.resize(vertices_.size());
+        for (size_t i{ 0 }; i < vertices_.size(); ++i)
+        {
+            const glm::vec3 position{ (vertices_[i].position - bounds_.aabbMin) * inverseExtent };
+
+            PackedVertex& packed{ packed_[i] };
+            packed.position[0] = glm::packUnorm1x16(position.x);
+            packed.position[1] = glm::packUnorm1x16(position.y);
+            packed.position[2] = glm::packUnorm1x16(position.z);
+            packed.position[3] = 0;
+            packed.texCoord[0] = glm::packHalf1x16(vertices_[i].texCoord.x);
+            packed.texCoord[1] = glm::packHalf1x16(vertices_[i].texCoord.y);
+        }
+    }
+
+    VertexDequantization GetDequantization(const MeshBounds& bounds_)
+    {
+        VertexDequantization dequantization{};
+        dequantization.offset = glm::vec4{ bounds_.aabbMin, 0.0f };
+        dequantization.scale = glm::vec4{ bounds_.aabbMax - bounds_.aabbMin, 0.0f };
+        return dequantization;
+    }
+}
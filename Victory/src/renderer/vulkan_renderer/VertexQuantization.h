@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+
+#include "FrustumCulling.h"
+
+struct VertexData;
+struct PackedVertex;
+
+namespace Victory
+{
+    // Packs vertices into the GPU layout, positions relative to bounds_. graphics.vert
+    // maps them back with the offset and scale of GetDequantization
+    void QuantizeVertices(const std::vector<VertexData>& vertices_, const MeshBounds& bounds_,
+        std::vector<PackedVertex>& packed_);
+
+    // Object space position is offset + unorm position * scale
+    struct VertexDequantization
+    {
+        glm::vec4 offset;
+        glm::vec4 scale;
+    };
+
+    VertexDequantization GetDequantization(const MeshBounds& bounds_);
+}
@@ -0,0 +1,435 @@
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "VulkanAllocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <iostream>
+
+#include "VulkanDevice.h"
+#include "VulkanUtils.h"
+
+namespace Victory
+{
+    constexpr VkDeviceSize s_MinNodeSize{ 256 };
+    constexpr VkDeviceSize s_DefaultBlockSize{ 64ull * 1024 * 1024 };
+    constexpr VkDeviceSize s_MinBlockSize{ 1024 * 1024 };
+
+    static inline VkDeviceSize AlignUp(VkDeviceSize value_, VkDeviceSize alignment_)
+    {
+        return (value_ + alignment_ - 1) & ~(alignment_ - 1);
+    }
+
+    static inline uint32_t PoolKey(uint32_t memoryType_, bool optimalImage_, AllocationStrategy strategy_)
+    {
+        return (memoryType_ << 2) | (static_cast<uint32_t>(optimalImage_) << 1) |
+            static_cast<uint32_t>(strategy_ == AllocationStrategy::eLinear);
+    }
+
+    static inline uint32_t MemoryTypeOf(uint32_t poolKey_)
+    {
+        return poolKey_ >> 2;
+    }
+
+    VulkanMemoryBlock::VulkanMemoryBlock(VkDeviceMemory memory_, VkDeviceSize size_, void* mapped_,
+        AllocationStrategy strategy_, uint32_t poolKey_)
+        : m_Memory{ memory_ }, m_Size{ size_ }, m_Mapped{ mapped_ }, m_Strategy{ strategy_ }, m_PoolKey{ poolKey_ }
+    {
+        if (m_Strategy == AllocationStrategy::eBuddy)
+        {
+            // Block size is a power of two, the whole block starts as one free node of the top order
+            const uint32_t orderCount{ static_cast<uint32_t>(std::countr_zero(m_Size / s_MinNodeSize)) + 1 };
+            m_FreeNodes.resize(orderCount);
+            m_FreeNodes.back().insert(0);
+        }
+    }
+
+    bool VulkanMemoryBlock::Allocate(VkDeviceSize size_, VkDeviceSize alignment_, VulkanAllocation& allocation_)
+    {
+        if (m_Strategy == AllocationStrategy::eBuddy)
+        {
+            if (!AllocateBuddy(size_, alignment_, allocation_))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            const VkDeviceSize offset{ AlignUp(m_Head, alignment_) };
+            if (offset + size_ > m_Size)
+            {
+                return false;
+            }
+
+            m_Head = offset + size_;
+            m_UsedSize += size_;
+            allocation_.offset = offset;
+        }
+
+        ++m_AllocationCount;
+        allocation_.memory = m_Memory;
+        allocation_.size = size_;
+        allocation_.mapped = m_Mapped ? static_cast<char*>(m_Mapped) + allocation_.offset : nullptr;
+        allocation_.block = this;
+
+        return true;
+    }
+
+    void VulkanMemoryBlock::Free(const VulkanAllocation& allocation_)
+    {
+        --m_AllocationCount;
+        if (m_Strategy == AllocationStrategy::eBuddy)
+        {
+            FreeBuddy(allocation_);
+            return;
+        }
+
+        m_UsedSize -= allocation_.size;
+        if (m_AllocationCount == 0)
+        {
+            m_Head = 0;
+        }
+    }
+
+    bool VulkanMemoryBlock::AllocateBuddy(VkDeviceSize size_, VkDeviceSize alignment_, VulkanAllocation& allocation_)
+    {
+        // Nodes are aligned to their own size, so a node large enough for the alignment satisfies it
+        const VkDeviceSize nodeSize{ std::bit_ceil(std::max({ size_, alignment_, s_MinNodeSize })) };
+        const uint32_t order{ static_cast<uint32_t>(std::countr_zero(nodeSize / s_MinNodeSize)) };
+        if (order >= m_FreeNodes.size())
+        {
+            return false;
+        }
+
+        uint32_t freeOrder{ order };
+        while (freeOrder < m_FreeNodes.size() && m_FreeNodes[freeOrder].empty())
+        {
+            ++freeOrder;
+        }
+
+        if (freeOrder == m_FreeNodes.size())
+        {
+            return false;
+        }
+
+        // Lowest address first keeps the block compact
+        const VkDeviceSize offset{ *m_FreeNodes[freeOrder].begin() };
+        m_FreeNodes[freeOrder].erase(m_FreeNodes[freeOrder].begin());
+
+        while (freeOrder > order)
+        {
+            --freeOrder;
+            m_FreeNodes[freeOrder].insert(offset + (s_MinNodeSize << freeOrder));
+        }
+
+        m_UsedSize += nodeSize;
+        allocation_.offset = offset;
+        allocation_.order = order;
+
+        return true;
+    }
+
+    void VulkanMemoryBlock::FreeBuddy(const VulkanAllocation& allocation_)
+    {
+        VkDeviceSize offset{ allocation_.offset };
+        uint32_t order{ allocation_.order };
+        m_UsedSize -= s_MinNodeSize << order;
+
+        while (order + 1 < m_FreeNodes.size())
+        {
+            const VkDeviceSize buddy{ offset ^ (s_MinNodeSize << order) };
+            auto&& it = m_FreeNodes[order].find(buddy);
+            if (it == m_FreeNodes[order].end())
+            {
+                break;
+            }
+
+            m_FreeNodes[order].erase(it);
+            offset = std::min(offset, buddy);
+            ++order;
+        }
+
+        m_FreeNodes[order].insert(offset);
+    }
+
+    VulkanAllocator::VulkanAllocator(VulkanDevice* vulkanDevice_)
+        : m_VulkanDevice{ vulkanDevice_ }
+    {
+        vkGetPhysicalDeviceMemoryProperties(m_VulkanDevice->GetPhysicalDevice(), &m_MemoryProperties);
+    }
+
+    VulkanAllocator::~VulkanAllocator()
+    {
+        VkDevice device{ m_VulkanDevice->GetDevice() };
+        for (auto&& [key, blocks] : m_Pools)
+        {
+            for (auto&& block : blocks)
+            {
+                if (!block->IsEmpty())
+                {
+                    std::cout << "WARNING: " << block->GetAllocationCount()
+                        << " allocations leaked in memory type " << MemoryTypeOf(key) << std::endl;
+                }
+                vkFreeMemory(device, block->GetMemory(), nullptr);
+            }
+        }
+        m_Pools.clear();
+    }
+
+    void VulkanAllocator::CreateBuffer(const VkBufferCreateInfo& bufferCI_, const VkMemoryPropertyFlags memoryProperty_,
+        VkBuffer& buffer_, VulkanAllocation& allocation_, AllocationStrategy strategy_)
+    {
+        VkDevice device{ m_VulkanDevice->GetDevice() };
+
+        CheckVulkanResult(
+            vkCreateBuffer(device, &bufferCI_, nullptr, &buffer_),
+            "Buffer was not created");
+
+        VkMemoryRequirements memRequirements{};
+        vkGetBufferMemoryRequirements(device, buffer_, &memRequirements);
+
+        allocation_ = Allocate(memRequirements, memoryProperty_, false, strategy_);
+
+        CheckVulkanResult(
+            vkBindBufferMemory(device, buffer_, allocation_.memory, allocation_.offset),
+            "Buffer was not binded");
+    }
+
+    void VulkanAllocator::DestroyBuffer(VkBuffer& buffer_, VulkanAllocation& allocation_)
+    {
+        vkDestroyBuffer(m_VulkanDevice->GetDevice(), buffer_, nullptr);
+        buffer_ = VK_NULL_HANDLE;
+        Free(allocation_);
+    }
+
+    void VulkanAllocator::CreateImage(const VkImageCreateInfo& imageCI_, const VkMemoryPropertyFlags memoryProperty_,
+        VkImage& image_, VulkanAllocation& allocation_)
+    {
+        VkDevice device{ m_VulkanDevice->GetDevice() };
+
+        CheckVulkanResult(
+            vkCreateImage(device, &imageCI_, nullptr, &image_),
+            "Image was not created");
+
+        VkMemoryRequirements memRequirements{};
+        vkGetImageMemoryRequirements(device, image_, &memRequirements);
+
+        allocation_ = Allocate(memRequirements, memoryProperty_,
+            imageCI_.tiling == VK_IMAGE_TILING_OPTIMAL, AllocationStrategy::eBuddy);
+
+        CheckVulkanResult(
+            vkBindImageMemory(device, image_, allocation_.memory, allocation_.offset),
+            "Image was not binded");
+    }
+
+    void VulkanAllocator::DestroyImage(VkImage& image_, VulkanAllocation& allocation_)
+    {
+        vkDestroyImage(m_VulkanDevice->GetDevice(), image_, nullptr);
+        image_ = VK_NULL_HANDLE;
+        Free(allocation_);
+    }
+
+    VulkanAllocation VulkanAllocator::Allocate(const VkMemoryRequirements& requirements_,
+        const VkMemoryPropertyFlags memoryProperty_, bool optimalImage_, AllocationStrategy strategy_)
+    {
+        const uint32_t memoryType{ m_VulkanDevice->FindMemoryType(requirements_.memoryTypeBits, memoryProperty_) };
+        if (memoryType == UINT32_MAX)
+        {
+            throw std::runtime_error("Suitable memory type was not found");
+        }
+
+        std::lock_guard lock{ m_Mutex };
+
+        // Large resources would waste most of a block, give them their own memory. Lazily
+        // allocated memory is committed per allocation, so it is never shared either
+        const VkDeviceSize blockSize{ GetBlockSize(memoryType) };
+        if (requirements_.size > blockSize / 2 || 
+            (memoryProperty_ & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT))
+        {
+            return AllocateDedicated(requirements_.size, memoryType);
+        }
+
+        const VkDeviceSize alignment{ std::max<VkDeviceSize>(requirements_.alignment, 1) };
+
+        VulkanAllocation allocation{};
+        allocation.memoryType = memoryType;
+
+        const uint32_t key{ PoolKey(memoryType, optimalImage_, strategy_) };
+        auto&& blocks = m_Pools[key];
+        for (auto&& block : blocks)
+        {
+            if (block->Allocate(requirements_.size, alignment, allocation))
+            {
+                return allocation;
+            }
+        }
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = blockSize;
+        allocInfo.memoryTypeIndex = memoryType;
+
+        VkDeviceMemory memory{ VK_NULL_HANDLE };
+        CheckVulkanResult(
+            vkAllocateMemory(m_VulkanDevice->GetDevice(), &allocInfo, nullptr, &memory),
+            "Memory block was not allocated");
+
+        blocks.emplace_back(std::make_unique<VulkanMemoryBlock>(memory, blockSize,
+            MapIfHostVisible(memory, memoryType), strategy_, key));
+        blocks.back()->Allocate(requirements_.size, alignment, allocation);
+
+        return allocation;
+    }
+
+    void VulkanAllocator::Free(VulkanAllocation& allocation_)
+    {
+        if (!allocation_.memory)
+        {
+            return;
+        }
+
+        std::lock_guard lock{ m_Mutex };
+
+        if (!allocation_.block)
+        {
+            VulkanMemoryStats& stats{ m_DedicatedStats[allocation_.memoryType] };
+            --stats.dedicatedCount;
+            --stats.allocationCount;
+            stats.reservedBytes -= allocation_.size;
+            stats.usedBytes -= allocation_.size;
+
+            vkFreeMemory(m_VulkanDevice->GetDevice(), allocation_.memory, nullptr);
+            allocation_ = VulkanAllocation{};
+            return;
+        }
+
+        VulkanMemoryBlock* freedBlock{ allocation_.block };
+        freedBlock->Free(allocation_);
+        allocation_ = VulkanAllocation{};
+
+        if (!freedBlock->IsEmpty())
+        {
+            return;
+        }
+
+        // Keep one empty block per pool around so alternating create and destroy does not thrash
+        auto&& blocks = m_Pools[freedBlock->GetPoolKey()];
+        const size_t emptyBlocks = std::count_if(blocks.begin(), blocks.end(),
+            [](auto&& block_) { return block_->IsEmpty(); });
+        if (emptyBlocks > 1)
+        {
+            vkFreeMemory(m_VulkanDevice->GetDevice(), freedBlock->GetMemory(), nullptr);
+            std::erase_if(blocks, [freedBlock](auto&& block_) { return block_.get() == freedBlock; });
+        }
+    }
+
+    VulkanAllocatorStats VulkanAllocator::GetStats() const
+    {
+        std::lock_guard lock{ m_Mutex };
+
+        VulkanAllocatorStats stats{};
+        for (uint32_t i{ 0 }; i < m_MemoryProperties.memoryTypeCount; ++i)
+        {
+            stats.memoryTypes[i] = m_DedicatedStats[i];
+        }
+
+        for (auto&& [key, blocks] : m_Pools)
+        {
+            VulkanMemoryStats& typeStats{ stats.memoryTypes[MemoryTypeOf(key)] };
+            for (auto&& block : blocks)
+            {
+                ++typeStats.blockCount;
+                typeStats.allocationCount += block->GetAllocationCount();
+                typeStats.reservedBytes += block->GetSize();
+                typeStats.usedBytes += block->GetUsedSize();
+            }
+        }
+
+        for (uint32_t i{ 0 }; i < m_MemoryProperties.memoryTypeCount; ++i)
+        {
+            stats.total.blockCount += stats.memoryTypes[i].blockCount;
+            stats.total.dedicatedCount += stats.memoryTypes[i].dedicatedCount;
+            stats.total.allocationCount += stats.memoryTypes[i].allocationCount;
+            stats.total.reservedBytes += stats.memoryTypes[i].reservedBytes;
+            stats.total.usedBytes += stats.memoryTypes[i].usedBytes;
+        }
+
+        return stats;
+    }
+
+    void VulkanAllocator::PrintStats() const
+    {
+        const VulkanAllocatorStats stats{ GetStats() };
+        for (uint32_t i{ 0 }; i < m_MemoryProperties.memoryTypeCount; ++i)
+        {
+            const VulkanMemoryStats& typeStats{ stats.memoryTypes[i] };
+            if (typeStats.reservedBytes == 0)
+            {
+                continue;
+            }
+
+            // Reserved, but backed only where the device had to spill
+            const bool lazy{ (m_MemoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0 };
+
+            std::cout << "Memory type " << i << (lazy ? " (lazily allocated)" : "") << ": " 
+                << typeStats.blockCount << " blocks, "
+                << typeStats.dedicatedCount << " dedicated, " << typeStats.allocationCount << " allocations, "
+                << typeStats.usedBytes / 1024 << " / " << typeStats.reservedBytes / 1024 << " KiB" << std::endl;
+        }
+
+        std::cout << "Memory total: " << stats.total.blockCount + stats.total.dedicatedCount
+            << " device allocations for " << stats.total.allocationCount << " resources, "
+            << stats.total.usedBytes / 1024 << " / " << stats.total.reservedBytes / 1024 << " KiB" << std::endl;
+    }
+
+    VkDeviceSize VulkanAllocator::GetBlockSize(uint32_t memoryType_) const
+    {
+        // Small heaps (e.g. the 256 MiB host visible device local one) get smaller blocks
+        const uint32_t heapIndex{ m_MemoryProperties.memoryTypes[memoryType_].heapIndex };
+        const VkDeviceSize heapSize{ m_MemoryProperties.memoryHeaps[heapIndex].size };
+
+        return std::clamp<VkDeviceSize>(std::bit_floor(heapSize / 8), s_MinBlockSize, s_DefaultBlockSize);
+    }
+
+    VulkanAllocation VulkanAllocator::AllocateDedicated(VkDeviceSize size_, uint32_t memoryType_)
+    {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size_;
+        allocInfo.memoryTypeIndex = memoryType_;
+
+        VulkanAllocation allocation{};
+        CheckVulkanResult(
+            vkAllocateMemory(m_VulkanDevice->GetDevice(), &allocInfo, nullptr, &allocation.memory),
+            "Dedicated memory was not allocated");
+
+        allocation.size = size_;
+        allocation.memoryType = memoryType_;
+        allocation.mapped = MapIfHostVisible(allocation.memory, memoryType_);
+
+        VulkanMemoryStats& stats{ m_DedicatedStats[memoryType_] };
+        ++stats.dedicatedCount;
+        ++stats.allocationCount;
+        stats.reservedBytes += size_;
+        stats.usedBytes += size_;
+
+        return allocation;
+    }
+
+    void* VulkanAllocator::MapIfHostVisible(VkDeviceMemory memory_, uint32_t memoryType_)
+    {
+        if (!(m_MemoryProperties.memoryTypes[memoryType_].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+        {
+            return nullptr;
+        }
+
+        // Mapped once for the lifetime of the memory, freeing it unmaps implicitly
+        void* mapped{ nullptr };
+        CheckVulkanResult(
+            vkMapMemory(m_VulkanDevice->GetDevice(), memory_, 0, VK_WHOLE_SIZE, 0, &mapped),
+            "Memory was not mapped");
+
+        return mapped;
+    }
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace Victory
+{
+    class VulkanDevice;
+    class VulkanMemoryBlock;
+
+    enum class AllocationStrategy
+    {
+        // Power-of-two sub-allocation, for long lived resources
+        eBuddy,
+        // Bump allocation, the block is recycled once all of its allocations are freed.
+        // For short lived staging memory
+        eLinear
+    };
+
+    struct VulkanAllocation
+    {
+        VkDeviceMemory memory{ VK_NULL_HANDLE };
+        VkDeviceSize offset{ 0 };
+        VkDeviceSize size{ 0 };
+        void* mapped{ nullptr };
+
+        uint32_t memoryType{ UINT32_MAX };
+        uint32_t order{ 0 };
+        VulkanMemoryBlock* block{ nullptr };
+    };
+
+    struct VulkanMemoryStats
+    {
+        uint32_t blockCount{ 0 };
+        uint32_t dedicatedCount{ 0 };
+        uint32_t allocationCount{ 0 };
+        VkDeviceSize reservedBytes{ 0 };
+        VkDeviceSize usedBytes{ 0 };
+    };
+
+    struct VulkanAllocatorStats
+    {
+        VulkanMemoryStats memoryTypes[VK_MAX_MEMORY_TYPES]{};
+        VulkanMemoryStats total{};
+    };
+
+    class VulkanMemoryBlock
+    {
+    public:
+
+        VulkanMemoryBlock(VkDeviceMemory memory_, VkDeviceSize size_, void* mapped_,
+            AllocationStrategy strategy_, uint32_t poolKey_);
+
+        bool Allocate(VkDeviceSize size_, VkDeviceSize alignment_, VulkanAllocation& allocation_);
+        void Free(const VulkanAllocation& allocation_);
+
+        inline bool IsEmpty() const
+        {
+            return m_AllocationCount == 0;
+        }
+
+        inline VkDeviceMemory GetMemory() const
+        {
+            return m_Memory;
+        }
+
+        inline VkDeviceSize GetSize() const
+        {
+            return m_Size;
+        }
+
+        inline VkDeviceSize GetUsedSize() const
+        {
+            return m_UsedSize;
+        }
+
+        inline uint32_t GetAllocationCount() const
+        {
+            return m_AllocationCount;
+        }
+
+        inline uint32_t GetPoolKey() const
+        {
+            return m_PoolKey;
+        }
+
+    private:
+
+        bool AllocateBuddy(VkDeviceSize size_, VkDeviceSize alignment_, VulkanAllocation& allocation_);
+        void FreeBuddy(const VulkanAllocation& allocation_);
+
+    private:
+
+        VkDeviceMemory m_Memory{ VK_NULL_HANDLE };
+        VkDeviceSize m_Size{ 0 };
+        void* m_Mapped{ nullptr };
+        AllocationStrategy m_Strategy;
+        uint32_t m_PoolKey{ 0 };
+
+        VkDeviceSize m_UsedSize{ 0 };
+        uint32_t m_AllocationCount{ 0 };
+
+        // Linear
+        VkDeviceSize m_Head{ 0 };
+
+        // Buddy: free node offsets per order, node size is s_MinNodeSize << order
+        std::vector<std::set<VkDeviceSize>> m_FreeNodes;
+    };
+
+    // Sub-allocates device memory out of large blocks, one pool per memory type,
+    // resource kind and strategy. Linear resources and optimal images never share
+    // a block, so bufferImageGranularity can not be violated between neighbours
+    class VulkanAllocator
+    {
+    public:
+
+        explicit VulkanAllocator(VulkanDevice* vulkanDevice_);
+        ~VulkanAllocator();
+
+        void CreateBuffer(const VkBufferCreateInfo& bufferCI_, const VkMemoryPropertyFlags memoryProperty_,
+            VkBuffer& buffer_, VulkanAllocation& allocation_,
+            AllocationStrategy strategy_ = AllocationStrategy::eBuddy);
+        void DestroyBuffer(VkBuffer& buffer_, VulkanAllocation& allocation_);
+
+        void CreateImage(const VkImageCreateInfo& imageCI_, const VkMemoryPropertyFlags memoryProperty_,
+            VkImage& image_, VulkanAllocation& allocation_);
+        void DestroyImage(VkImage& image_, VulkanAllocation& allocation_);
+
+        VulkanAllocation Allocate(const VkMemoryRequirements& requirements_,
+            const VkMemoryPropertyFlags memoryProperty_, bool optimalImage_, AllocationStrategy strategy_);
+        void Free(VulkanAllocation& allocation_);
+
+        VulkanAllocatorStats GetStats() const;
+        void PrintStats() const;
+
+    private:
+
+        VkDeviceSize GetBlockSize(uint32_t memoryType_) const;
+        VulkanAllocation AllocateDedicated(VkDeviceSize size_, uint32_t memoryType_);
+        void* MapIfHostVisible(VkDeviceMemory memory_, uint32_t memoryType_);
+
+    private:
+
+        VulkanDevice* m_VulkanDevice{ nullptr };
+
+        VkPhysicalDeviceMemoryProperties m_MemoryProperties{};
+
+        mutable std::mutex m_Mutex;
+        std::map<uint32_t, std::vector<std::unique_ptr<VulkanMemoryBlock>>> m_Pools;
+
+        VulkanMemoryStats m_DedicatedStats[VK_MAX_MEMORY_TYPES]{};
+    };
+}
@@ -0,0 +1,48 @@
+#include "VulkanDeletionQueue.h"
+
+namespace Victory
+{
+    VulkanDeletionQueue::VulkanDeletionQueue(uint32_t framesInFlight_)
+        : m_FramesInFlight{ framesInFlight_ } {}
+
+    VulkanDeletionQueue::~VulkanDeletionQueue()
+    {
+        Flush();
+    }
+
+    void VulkanDeletionQueue::Push(std::function<void()>&& deleter_)
+    {
+        m_Retired.push_back(RetiredResource{ m_SubmittedFrames, std::move(deleter_) });
+    }
+
+    void VulkanDeletionQueue::BeginFrame()
+    {
+        // Frames are submitted to one queue in order, so with the oldest fence waited
+        // at most m_FramesInFlight - 1 frames can still be running
+        if (m_SubmittedFrames + 1 < m_FramesInFlight)
+        {
+            return;
+        }
+
+        const uint64_t completedFrames{ m_SubmittedFrames + 1 - m_FramesInFlight };
+        while (!m_Retired.empty() && m_Retired.front().frame < completedFrames)
+        {
+            m_Retired.front().deleter();
+            m_Retired.pop_front();
+        }
+    }
+
+    void VulkanDeletionQueue::EndFrame()
+    {
+        ++m_SubmittedFrames;
+    }
+
+    void VulkanDeletionQueue::Flush()
+    {
+        for (auto&& retired : m_Retired)
+        {
+            retired.deleter();
+        }
+        m_Retired.clear();
+    }
+}
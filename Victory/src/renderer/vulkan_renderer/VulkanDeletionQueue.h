@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+namespace Victory
+{
+    // Destroys retired resources once no frame in flight can use them anymore,
+    // so replacing render targets or the swapchain never idles the device.
+    // A resource retired while a frame is recorded is destroyed after that frame
+    // and every earlier one completed
+    class VulkanDeletionQueue
+    {
+    public:
+
+        explicit VulkanDeletionQueue(uint32_t framesInFlight_);
+        ~VulkanDeletionQueue();
+
+        void Push(std::function<void()>&& deleter_);
+
+        // The fence of the oldest frame in flight was waited
+        void BeginFrame();
+        // The frame recorded since BeginFrame was submitted
+        void EndFrame();
+
+        // Destroys everything, the device must be idle
+        void Flush();
+
+    private:
+
+        struct RetiredResource
+        {
+            uint64_t frame{ 0 };
+            std::function<void()> deleter;
+        };
+
+    private:
+
+        uint32_t m_FramesInFlight{ 0 };
+        uint64_t m_SubmittedFrames{ 0 };
+
+        std::deque<RetiredResource> m_Retired;
+    };
+}
@@ -0,0 +1,387 @@
+#include <vector>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <vulkan/vulkan.h>
+
+#include "VulkanDepthPyramid.h"
+
+#include "VulkanDevice.h"
+#include "VulkanDeletionQueue.h"
+#include "VulkanUploadContext.h"
+#include "VulkanUtils.h"
+
+#include "../../Utils.h"
+
+namespace Victory
+{
+    const static VkFormat s_DepthPyramidFormat{ VK_FORMAT_R32_SFLOAT };
+
+    // local_size_x and local_size_y of depth_pyramid.comp
+    const static uint32_t s_PyramidGroupSize{ 8 };
+
+    struct PyramidConstants
+    {
+        uint32_t fromDepth;
+    };
+
+    VulkanDepthPyramid::VulkanDepthPyramid(VulkanDevice* vulkanDevice_, VulkanDeletionQueue* deletionQueue_)
+        : m_VulkanDevice{ vulkanDevice_ }, m_DeletionQueue{ deletionQueue_ }
+    {
+        CreateSampler();
+        CreatePipeline();
+    }
+
+    VulkanDepthPyramid::~VulkanDepthPyramid()
+    {
+        VkDevice device{ m_VulkanDevice->GetDevice() };
+
+        // The device is idle by now
+        vkDestroyDescriptorPool(device, m_DescriptorPool, nullptr);
+        for (auto&& view : m_LevelViews)
+        {
+            vkDestroyImageView(device, view, nullptr);
+        }
+        vkDestroyImageView(device, m_View, nullptr);
+        if (m_Image)
+        {
+            m_VulkanDevice->GetAllocator()->DestroyImage(m_Image, m_ImageMemory);
+        }
+
+        vkDestroyPipeline(device, m_Pipeline, nullptr);
+        vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
+        vkDestroyDescriptorSetLayout(device, m_SetLayout, nullptr);
+        vkDestroySampler(device, m_Sampler, nullptr);
+    }
+
+    void VulkanDepthPyramid::Create(VkExtent2D viewportExtent_, VkImageView depthView_)
+    {
+        Retire();
+
+        const VkExtent2D extent{ std::max((viewportExtent_.width + 1) / 2, 1u),
+            std::max((viewportExtent_.height + 1) / 2, 1u) };
+        const uint32_t levelCount{ static_cast<uint32_t>(std::bit_width(std::max(extent.width, extent.height))) };
+
+        VkImageCreateInfo imageCI{};
+        imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCI.imageType = VK_IMAGE_TYPE_2D;
+        imageCI.format = s_DepthPyramidFormat;
+        imageCI.extent = { extent.width, extent.height, 1 };
+        imageCI.mipLevels = levelCount;
+        imageCI.arrayLayers = 1;
+        imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageCI.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        imageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        m_VulkanDevice->GetAllocator()->CreateImage(imageCI, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            m_Image, m_ImageMemory);
+
+        VkImageViewCreateInfo imageViewCI{};
+        imageViewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        imageViewCI.image = m_Image;
+        imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        imageViewCI.format = s_DepthPyramidFormat;
+        imageViewCI.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageViewCI.subresourceRange.baseMipLevel = 0;
+        imageViewCI.subresourceRange.levelCount = levelCount;
+        imageViewCI.subresourceRange.baseArrayLayer = 0;
+        imageViewCI.subresourceRange.layerCount = 1;
+
+        CheckVulkanResult(
+            vkCreateImageView(m_VulkanDevice->GetDevice(), &imageViewCI, nullptr, &m_View),
+            "Depth Pyramid View was not created");
+
+        // Storage images are bound per level
+        m_LevelViews.resize(levelCount);
+        m_LevelExtents.resize(levelCount);
+        for (uint32_t level{ 0 }; level < levelCount; ++level)
+        {
+            imageViewCI.subresourceRange.baseMipLevel = level;
+            imageViewCI.subresourceRange.levelCount = 1;
+
+            CheckVulkanResult(
+                vkCreateImageView(m_VulkanDevice->GetDevice(), &imageViewCI, nullptr, &m_LevelViews[level]),
+                "Depth Pyramid Level View was not created");
+
+            // Rounded down as mip sizes are, depth_pyramid.comp widens the last texel of
+            // an odd level so the row or column it drops is still reduced
+            m_LevelExtents[level] = { std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u) };
+        }
+
+        Clear();
+
+        if (depthView_)
+        {
+            CreateDescriptorSets(depthView_);
+        }
+    }
+
+    void VulkanDepthPyramid::Record(VkCommandBuffer commandBuffer_) const
+    {
+        vkCmdBindPipeline(commandBuffer_, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = m_Image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+
+        const uint32_t levelCount{ static_cast<uint32_t>(m_LevelViews.size()) };
+        for (uint32_t level{ 0 }; level < levelCount; ++level)
+        {
+            const PyramidConstants constants{ level == 0 ? 1u : 0u };
+
+            vkCmdBindDescriptorSets(commandBuffer_, VK_PIPELINE_BIND_POINT_COMPUTE,
+                m_PipelineLayout, 0, 1, &m_DescriptorSets[level], 0, nullptr);
+            vkCmdPushConstants(commandBuffer_, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+                0, sizeof(constants), &constants);
+            vkCmdDispatch(commandBuffer_,
+                (m_LevelExtents[level].width + s_PyramidGroupSize - 1) / s_PyramidGroupSize,
+                (m_LevelExtents[level].height + s_PyramidGroupSize - 1) / s_PyramidGroupSize, 1);
+
+            // The next level reads this one
+            if (level + 1 < levelCount)
+            {
+                barrier.subresourceRange.baseMipLevel = level;
+                vkCmdPipelineBarrier(commandBuffer_, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+            }
+        }
+    }
+
+    void VulkanDepthPyramid::CreatePipeline()
+    {
+        VkDevice device{ m_VulkanDevice->GetDevice() };
+
+        // Level above, depth attachment and the written level
+        std::array<VkDescriptorSetLayoutBinding, 3> layoutBindings{};
+        for (uint32_t i{ 0 }; i < layoutBindings.size(); ++i)
+        {
+            layoutBindings[i].binding = i;
+            layoutBindings[i].descriptorCount = 1;
+            layoutBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            layoutBindings[i].pImmutableSamplers = nullptr;
+            layoutBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+        layoutBindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCI{};
+        descriptorSetLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        descriptorSetLayoutCI.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+        descriptorSetLayoutCI.pBindings = layoutBindings.data();
+
+        CheckVulkanResult(
+            vkCreateDescriptorSetLayout(device, &descriptorSetLayoutCI, nullptr, &m_SetLayout),
+            "Depth Pyramid Descriptor Set Layout was not created");
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(PyramidConstants);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutCI{};
+        pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCI.setLayoutCount = 1;
+        pipelineLayoutCI.pSetLayouts = &m_SetLayout;
+        pipelineLayoutCI.pushConstantRangeCount = 1;
+        pipelineLayoutCI.pPushConstantRanges = &pushConstantRange;
+
+        CheckVulkanResult(
+            vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &m_PipelineLayout),
+            "Depth Pyramid Pipeline Layout was not created");
+
+        const std::vector<char> csBuffer = Utils::ReadFile("depth_pyramid.comp.spv");
+
+        VkShaderModule CS{ VK_NULL_HANDLE };
+        CreateShaderModule(device, csBuffer, &CS);
+
+        VkComputePipelineCreateInfo pipelineCI{};
+        pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineCI.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineCI.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineCI.stage.module = CS;
+        pipelineCI.stage.pName = "main";
+        pipelineCI.layout = m_PipelineLayout;
+
+        CheckVulkanResult(
+            vkCreateComputePipelines(device, m_VulkanDevice->GetPipelineCache(), 1, &pipelineCI, nullptr, &m_Pipeline),
+            "Depth Pyramid Pipeline was not created");
+
+        vkDestroyShaderModule(device, CS, nullptr);
+    }
+
+    void VulkanDepthPyramid::CreateSampler()
+    {
+        // Only texelFetch reads through it
+        VkSamplerCreateInfo samplerCI{};
+        samplerCI.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerCI.magFilter = VK_FILTER_NEAREST;
+        samplerCI.minFilter = VK_FILTER_NEAREST;
+        samplerCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCI.anisotropyEnable = VK_FALSE;
+        samplerCI.maxAnisotropy = 1.f;
+        samplerCI.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+        samplerCI.unnormalizedCoordinates = VK_FALSE;
+        samplerCI.compareEnable = VK_FALSE;
+        samplerCI.compareOp = VK_COMPARE_OP_ALWAYS;
+        samplerCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerCI.minLod = 0.f;
+        samplerCI.maxLod = VK_LOD_CLAMP_NONE;
+        samplerCI.mipLodBias = 0.f;
+
+        CheckVulkanResult(
+            vkCreateSampler(m_VulkanDevice->GetDevice(), &samplerCI, nullptr, &m_Sampler),
+            "Depth Pyramid Sampler was not created");
+    }
+
+    void VulkanDepthPyramid::CreateDescriptorSets(VkImageView depthView_)
+    {
+        VkDevice device{ m_VulkanDevice->GetDevice() };
+        const uint32_t levelCount{ static_cast<uint32_t>(m_LevelViews.size()) };
+
+        std::array<VkDescriptorPoolSize, 2> poolSizes{};
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSizes[0].descriptorCount = 2 * levelCount;
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        poolSizes[1].descriptorCount = levelCount;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = 0;
+        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        poolInfo.maxSets = levelCount;
+
+        CheckVulkanResult(
+            vkCreateDescriptorPool(device, &poolInfo, nullptr, &m_DescriptorPool),
+            "Depth Pyramid Descriptor Pool was not created");
+
+        const std::vector<VkDescriptorSetLayout> layouts(levelCount, m_SetLayout);
+        m_DescriptorSets.resize(levelCount);
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = m_DescriptorPool;
+        allocInfo.descriptorSetCount = levelCount;
+        allocInfo.pSetLayouts = layouts.data();
+
+        CheckVulkanResult(
+            vkAllocateDescriptorSets(device, &allocInfo, m_DescriptorSets.data()),
+            "Depth Pyramid Descriptor Sets were not allocated");
+
+        for (uint32_t level{ 0 }; level < levelCount; ++level)
+        {
+            // Level 0 reads the depth attachment, its source binding only has to be valid
+            std::array<VkDescriptorImageInfo, 3> imageInfos{};
+            imageInfos[0].sampler = m_Sampler;
+            imageInfos[0].imageView = m_LevelViews[level == 0 ? 0 : level - 1];
+            imageInfos[0].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+            imageInfos[1].sampler = m_Sampler;
+            imageInfos[1].imageView = depthView_;
+            imageInfos[1].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            imageInfos[2].imageView = m_LevelViews[level];
+            imageInfos[2].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+            std::array<VkWriteDescriptorSet, 3> descriptorWrites{};
+            for (uint32_t i{ 0 }; i < descriptorWrites.size(); ++i)
+            {
+                descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                descriptorWrites[i].dstSet = m_DescriptorSets[level];
+                descriptorWrites[i].dstBinding = i;
+                descriptorWrites[i].dstArrayElement = 0;
+                descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                descriptorWrites[i].descriptorCount = 1;
+                descriptorWrites[i].pImageInfo = &imageInfos[i];
+            }
+            descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+
+            vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()),
+                descriptorWrites.data(), 0, nullptr);
+        }
+    }
+
+    void VulkanDepthPyramid::Clear()
+    {
+        VulkanUploadContext* uploadContext{ m_VulkanDevice->GetUploadContext() };
+        VkCommandBuffer commandBuffer{ uploadContext->GetGraphicsCommandBuffer() };
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = m_Image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+            0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkClearColorValue farPlane{};
+        farPlane.float32[0] = 1.f;
+        vkCmdClearColorImage(commandBuffer, m_Image, VK_IMAGE_LAYOUT_GENERAL, &farPlane, 1, &barrier.subresourceRange);
+
+        // The state the render graph expects at the start of a frame
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+            0, nullptr, 0, nullptr, 1, &barrier);
+
+        // Ahead of the next frame on the graphics queue
+        uploadContext->Submit();
+    }
+
+    void VulkanDepthPyramid::Retire()
+    {
+        if (!m_Image)
+        {
+            return;
+        }
+
+        // Frames in flight may still cull against the old pyramid
+        VulkanDevice* vulkanDevice{ m_VulkanDevice };
+        VkImage image{ m_Image };
+        VulkanAllocation imageMemory{ m_ImageMemory };
+        VkImageView view{ m_View };
+        std::vector<VkImageView> levelViews{ std::move(m_LevelViews) };
+        VkDescriptorPool descriptorPool{ m_DescriptorPool };
+        m_DeletionQueue->Push([=]() mutable
+        {
+            VkDevice device{ vulkanDevice->GetDevice() };
+            vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+            for (auto&& levelView : levelViews)
+            {
+                vkDestroyImageView(device, levelView, nullptr);
+            }
+            vkDestroyImageView(device, view, nullptr);
+            vulkanDevice->GetAllocator()->DestroyImage(image, imageMemory);
+        });
+
+        m_Image = VK_NULL_HANDLE;
+        m_ImageMemory = {};
+        m_View = VK_NULL_HANDLE;
+        m_LevelViews.clear();
+        m_DescriptorPool = VK_NULL_HANDLE;
+        m_DescriptorSets.clear();
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+
+#include "VulkanAllocator.h"
+
+namespace Victory
+{
+    class VulkanDevice;
+    class VulkanDeletionQueue;
+
+    // Hierarchical depth of the viewport for occlusion culling, R32 levels where every
+    // texel holds the farthest depth below it. Level 0 is half the viewport, each
+    // level halves the one above down to 1x1.
+    //
+    // The image stays in general layout. A new pyramid is cleared to the far plane,
+    // so it hides nothing until it was built once
+    class VulkanDepthPyramid
+    {
+    public:
+
+        VulkanDepthPyramid(VulkanDevice* vulkanDevice_, VulkanDeletionQueue* deletionQueue_);
+        ~VulkanDepthPyramid();
+
+        // Replaces the pyramid, the previous one is retired. depthView_ is the multisampled
+        // depth the pyramid is built from, without it the pyramid is never built
+        void Create(VkExtent2D viewportExtent_, VkImageView depthView_);
+
+        // The depth attachment is in shader read only layout. Levels are written one after
+        // the other, the last write is left to the render graph to synchronize
+        void Record(VkCommandBuffer commandBuffer_) const;
+
+        inline VkImage GetImage() const
+        {
+            return m_Image;
+        }
+
+        // Every level, for cull.comp
+        inline VkImageView GetView() const
+        {
+            return m_View;
+        }
+
+        inline VkSampler GetSampler() const
+        {
+            return m_Sampler;
+        }
+
+    private:
+
+        void CreatePipeline();
+        void CreateSampler();
+        void CreateDescriptorSets(VkImageView depthView_);
+        void Clear();
+        void Retire();
+
+    private:
+
+        VulkanDevice* m_VulkanDevice;
+        VulkanDeletionQueue* m_DeletionQueue;
+
+        VkDescriptorSetLayout m_SetLayout{ VK_NULL_HANDLE };
+        VkPipelineLayout m_PipelineLayout{ VK_NULL_HANDLE };
+        VkPipeline m_Pipeline{ VK_NULL_HANDLE };
+        VkSampler m_Sampler{ VK_NULL_HANDLE };
+
+        VkImage m_Image{ VK_NULL_HANDLE };
+        VulkanAllocation m_ImageMemory{};
+        VkImageView m_View{ VK_NULL_HANDLE };
+        std::vector<VkImageView> m_LevelViews;
+        std::vector<VkExtent2D> m_LevelExtents;
+
+        // One set per level, they are replaced with the image
+        VkDescriptorPool m_DescriptorPool{ VK_NULL_HANDLE };
+        std::vector<VkDescriptorSet> m_DescriptorSets;
+    };
+}
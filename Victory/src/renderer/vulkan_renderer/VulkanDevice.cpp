@@ -3,17 +3,24 @@
 
 #include "VulkanDevice.h"
 
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <unordered_set>
 #include <GLFW/glfw3.h>
 
 #include "VulkanUtils.h"
+#include "VulkanAllocator.h"
+#include "VulkanUploadContext.h"
 
 namespace Victory 
 {
 
     static VulkanDevice* s_VulkanDeviceInstance{ nullptr };
     const static std::string s_EngineName{ "Victory Engine" };
+    const static std::string s_PipelineCacheDirectory{ "cache" };
+    const static std::string s_PipelineCachePath{ "cache/pipeline.cache" };
 
     VulkanDevice* VulkanDevice::Init() 
     {
@@ -55,7 +62,14 @@ namespace Victory
 
     void VulkanDevice::CleanupResourses()
     {
-        vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
+        delete m_UploadContext;
+
+        SavePipelineCache();
+        vkDestroyPipelineCache(m_Device, m_PipelineCache, nullptr);
+
+        m_Allocator->PrintStats();
+        delete m_Allocator;
+
         vkDestroyDevice(m_Device, nullptr);
         vkDestroyInstance(m_Instance, nullptr);
     }
@@ -89,45 +103,6 @@ namespace Victory
 		throw std::runtime_error("failed to find supported format!");
     }
 
-    VkCommandBuffer VulkanDevice::BeginSingleTimeCommands() 
-    {
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = m_CommandPool;
-        allocInfo.commandBufferCount = 1;
-
-        VkCommandBuffer commandBuffer;
-        vkAllocateCommandBuffers(m_Device, &allocInfo, &commandBuffer);
-
-        VkCommandBufferBeginInfo beginInfo{};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-        vkBeginCommandBuffer(commandBuffer, &beginInfo);
-        return commandBuffer;
-    }
-
-    void VulkanDevice::EndSingleTimeCommands(VkCommandBuffer commandBuffer_)
-    {
-        vkEndCommandBuffer(commandBuffer_);
-
-        VkSubmitInfo submitInfo{};
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &commandBuffer_;
-
-        // TODO: submit via transfer queue, need Transfer Command pool
-        // https://vulkan-tutorial.com/Vertex_buffers/Staging_buffer
-
-        VkQueue queue;
-        GetQueue(queue, QueueIndex::eGraphics);
-        vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(queue);
-
-        vkFreeCommandBuffers(m_Device, m_CommandPool, 1, &commandBuffer_);
-    }
-
     void CollectLayers(std::vector<const char*> &layers_) 
     {
 #ifndef NDEBUG
@@ -135,12 +110,17 @@ namespace Victory
 #endif // NDEBUG
     }
 
-    void CollectExtensions(std::vector<const char*>& extensions_) 
+    void CollectExtensions(std::vector<const char*>& extensions_, bool headless_) 
     {
 #ifndef NDEBUG
         extensions_.emplace_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 #endif // NDEBUG
 
+        if (headless_) 
+        {
+            return;
+        }
+
         uint32_t glfwExtensionCount{ 0 };
         const char** glfwExtensions{ glfwGetRequiredInstanceExtensions(&glfwExtensionCount) };
         extensions_.reserve(glfwExtensionCount + 1);
@@ -150,8 +130,10 @@ namespace Victory
         }
     }
 
-    void VulkanDevice::CreateInstance(const char* applicationName_) 
+    void VulkanDevice::CreateInstance(const char* applicationName_, bool headless_) 
     {
+        m_Headless = headless_;
+
         VkApplicationInfo applicationI{};
         applicationI.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
         applicationI.pNext = nullptr;
@@ -165,7 +147,7 @@ namespace Victory
         CollectLayers(layers);
 
         std::vector<const char*> extensions;
-        CollectExtensions(extensions);
+        CollectExtensions(extensions, m_Headless);
 
         VkInstanceCreateInfo instanceCI{};
         instanceCI.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -215,9 +197,12 @@ namespace Victory
 
     void VulkanDevice::CreateLogicalDevice()
     {
-        // TODO: Support transfer and compute
         std::unordered_set<uint32_t> uniqueIndices{ 
-            m_QueueIndices.graphicsQueueIndex, m_QueueIndices.presentQueueIndex };
+            m_QueueIndices.graphicsQueueIndex, m_QueueIndices.transferQueueIndex };
+        if (!m_Headless) 
+        {
+            uniqueIndices.insert(m_QueueIndices.presentQueueIndex);
+        }
 
         std::vector<float> queuePriorities{ 1.f };
         std::vector<VkDeviceQueueCreateInfo> queueCIs;
@@ -234,14 +219,44 @@ namespace Victory
         }
 
         std::vector<const char*> layers{};
-        std::vector<const char*> extensions{ VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+        std::vector<const char*> extensions{};
+        if (!m_Headless) 
+        {
+            extensions.emplace_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+        }
+
+        // Indirect count draws let the scene cull and build its draws on the GPU,
+        // without them it keeps culling on the CPU
+        VkPhysicalDeviceProperties properties{};
+        vkGetPhysicalDeviceProperties(m_PhysicalDevice, &properties);
+
+        VkPhysicalDeviceVulkan12Features supportedFeatures12{};
+        supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+        VkPhysicalDeviceFeatures2 supportedFeatures{};
+        supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supportedFeatures.pNext = &supportedFeatures12;
+
+        const bool isVulkan12{ properties.apiVersion >= VK_API_VERSION_1_2 };
+        if (isVulkan12)
+        {
+            vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &supportedFeatures);
+        }
+        m_SupportsDrawIndirectCount = supportedFeatures12.drawIndirectCount == VK_TRUE && 
+            supportedFeatures.features.multiDrawIndirect == VK_TRUE;
+
+        VkPhysicalDeviceVulkan12Features features12{};
+        features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        features12.drawIndirectCount = m_SupportsDrawIndirectCount ? VK_TRUE : VK_FALSE;
+
         VkPhysicalDeviceFeatures features{};
         features.samplerAnisotropy = VK_TRUE;
         features.sampleRateShading = VK_TRUE;
+        features.multiDrawIndirect = m_SupportsDrawIndirectCount ? VK_TRUE : VK_FALSE;
 
         VkDeviceCreateInfo deviceCI{};
         deviceCI.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-        deviceCI.pNext = nullptr;
+        deviceCI.pNext = isVulkan12 ? &features12 : nullptr;
         deviceCI.flags = 0;
         deviceCI.queueCreateInfoCount = static_cast<uint32_t>(queueCIs.size());
         deviceCI.pQueueCreateInfos = queueCIs.data();
@@ -255,20 +270,19 @@ namespace Victory
             vkCreateDevice(m_PhysicalDevice, &deviceCI, nullptr, &m_Device),
             "Device was not created");
 
-        VkCommandPoolCreateInfo commandPoolCI{};
-        commandPoolCI.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        commandPoolCI.pNext = nullptr;
-        commandPoolCI.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-        commandPoolCI.queueFamilyIndex = GetQueueIndex(QueueIndex::eGraphics);
+        m_Allocator = new VulkanAllocator(this);
+        m_UploadContext = new VulkanUploadContext(this);
 
-        CheckVulkanResult(
-            vkCreateCommandPool(m_Device, 
-                &commandPoolCI, nullptr, &m_CommandPool),
-            "Command pool was not created");
+        CreatePipelineCache();
 
+        std::cout << "Queue families: graphics " << m_QueueIndices.graphicsQueueIndex
+            << ", present " << m_QueueIndices.presentQueueIndex
+            << ", compute " << m_QueueIndices.computeQueueIndex
+            << ", transfer " << m_QueueIndices.transferQueueIndex << std::endl;
+        std::cout << "GPU driven draws: " << (m_SupportsDrawIndirectCount ? "yes" : "no") << std::endl;
     }
 
-    uint32_t VulkanDevice::RateDeviceSuitability(VkPhysicalDevice phDevice_) 
+    uint32_t VulkanDevice::RateDeviceSuitability(VkPhysicalDevice phDevice_) const 
     {
         VkPhysicalDeviceFeatures features;
         vkGetPhysicalDeviceFeatures(phDevice_, &features);
@@ -293,6 +307,10 @@ namespace Victory
         score += 10 * suitable;
 #endif // NDEBUG
 
+        // Render nodes without a display often only expose a software implementation
+        suitable = m_Headless && properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU;
+        score += 1 * suitable;
+
         // Check other properties ...
 
         uint32_t availableExtensionsCount{};
@@ -303,8 +321,11 @@ namespace Victory
         vkEnumerateDeviceExtensionProperties(phDevice_, nullptr, 
             &availableExtensionsCount, availableExtensions.data());
 
-        const std::vector<const char*> deviceExtensions {
-            VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+        std::vector<const char*> deviceExtensions{};
+        if (!m_Headless) 
+        {
+            deviceExtensions.emplace_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+        }
 
         std::unordered_set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
 
@@ -332,46 +353,63 @@ namespace Victory
 
         std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyPropertiesCount);
         vkGetPhysicalDeviceQueueFamilyProperties(phDevice_, &queueFamilyPropertiesCount, queueFamilyProperties.data());
-    
-        uint8_t min_score{UINT8_MAX};
-        for(uint32_t i{0}, n = static_cast<uint32_t>(queueFamilyProperties.size()); i < n; ++i) 
-        {
-            uint8_t score{0};
 
-            // Graphics queue
-            if (m_QueueIndices.graphicsQueueIndex == UINT32_MAX && 
-                queueFamilyProperties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) 
+        m_QueueIndices = VulkanQueueIndices{};
+
+        // Graphics queue
+        for (uint32_t i{0}, n = static_cast<uint32_t>(queueFamilyProperties.size()); i < n; ++i) 
+        {
+            if (queueFamilyProperties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) 
             {
                 m_QueueIndices.graphicsQueueIndex = i;
-                ++score;
+                break;
             }
+        }
 
-            // Present queu
+        if (m_QueueIndices.graphicsQueueIndex == UINT32_MAX) 
+        {
+            return false;
+        }
+
+        // Present queue, prefer the graphics family
+        for (uint32_t i{0}, n = static_cast<uint32_t>(queueFamilyProperties.size()); surface_ && i < n; ++i) 
+        {
             VkBool32 presentSupport = false;
             vkGetPhysicalDeviceSurfaceSupportKHR(phDevice_, i, surface_, &presentSupport);
-            if (m_QueueIndices.presentQueueIndex == UINT32_MAX && 
-                presentSupport == VK_TRUE) 
+            if (presentSupport == VK_TRUE && 
+                (m_QueueIndices.presentQueueIndex == UINT32_MAX || i == m_QueueIndices.graphicsQueueIndex)) 
             {
                 m_QueueIndices.presentQueueIndex = i;
-                ++score;
             }
+        }
 
-            // Compute queue
-            if (queueFamilyProperties[i].queueFlags & VK_QUEUE_COMPUTE_BIT) 
+        // Culling and the depth pyramid sit between the graphics passes of a frame,
+        // compute runs on the graphics queue
+        m_QueueIndices.computeQueueIndex = m_QueueIndices.graphicsQueueIndex;
+
+        // Transfer queue, prefer families that do as little else as possible so uploads
+        // run asynchronously. Fall back to the graphics family
+        m_QueueIndices.transferQueueIndex = m_QueueIndices.graphicsQueueIndex;
+
+        uint32_t transferScore{ 0 };
+        for (uint32_t i{0}, n = static_cast<uint32_t>(queueFamilyProperties.size()); i < n; ++i) 
+        {
+            const VkQueueFlags flags{ queueFamilyProperties[i].queueFlags };
+            if (flags & VK_QUEUE_GRAPHICS_BIT) 
             {
-                m_QueueIndices.computeQueueIndex = i;
-                ++score;
+                continue;
             }
 
-            // Transfer queue
-            if (min_score > score && queueFamilyProperties[i].queueFlags & VK_QUEUE_TRANSFER_BIT) 
+            // Compute families support transfer implicitly
+            const uint32_t score{ flags & VK_QUEUE_COMPUTE_BIT ? 1u : (flags & VK_QUEUE_TRANSFER_BIT ? 2u : 0u) };
+            if (score > transferScore) 
             {
-                min_score = score;
+                transferScore = score;
                 m_QueueIndices.transferQueueIndex = i;
             }
         }
 
-        return !(m_QueueIndices.graphicsQueueIndex == UINT32_MAX);
+        return true;
     }
 
     void VulkanDevice::DefineMaxSampleCount() 
@@ -387,4 +425,89 @@ namespace Victory
         if (counts & VK_SAMPLE_COUNT_4_BIT) { m_MaxSampleCount = VK_SAMPLE_COUNT_4_BIT; return; }
         if (counts & VK_SAMPLE_COUNT_2_BIT) { m_MaxSampleCount = VK_SAMPLE_COUNT_2_BIT; return; }
     }
-}
\ No newline at end of file
+
+    void VulkanDevice::CreatePipelineCache()
+    {
+        std::vector<char> cacheData;
+        {
+            std::ifstream file(s_PipelineCachePath, std::ios::binary | std::ios::ate);
+            if (file)
+            {
+                cacheData.resize(static_cast<size_t>(file.tellg()));
+                file.seekg(0);
+                file.read(cacheData.data(), static_cast<std::streamsize>(cacheData.size()));
+            }
+        }
+
+        // Data from another driver or GPU is useless at best, only hand over a matching header
+        if (cacheData.size() >= sizeof(VkPipelineCacheHeaderVersionOne))
+        {
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(m_PhysicalDevice, &properties);
+
+            VkPipelineCacheHeaderVersionOne header{};
+            memcpy(&header, cacheData.data(), sizeof(header));
+
+            const bool valid = header.headerSize >= sizeof(header) &&
+                header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                header.vendorID == properties.vendorID &&
+                header.deviceID == properties.deviceID &&
+                memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+
+            if (!valid)
+            {
+                std::cout << "Pipeline cache belongs to another device or driver, starting empty" << std::endl;
+                cacheData.clear();
+            }
+        }
+        else
+        {
+            cacheData.clear();
+        }
+
+        VkPipelineCacheCreateInfo pipelineCacheCI{};
+        pipelineCacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        pipelineCacheCI.initialDataSize = cacheData.size();
+        pipelineCacheCI.pInitialData = cacheData.empty() ? nullptr : cacheData.data();
+
+        CheckVulkanResult(
+            vkCreatePipelineCache(m_Device, &pipelineCacheCI, nullptr, &m_PipelineCache),
+            "Pipeline Cash was not created");
+    }
+
+    void VulkanDevice::SavePipelineCache()
+    {
+        size_t cacheSize{ 0 };
+        if (vkGetPipelineCacheData(m_Device, m_PipelineCache, &cacheSize, nullptr) != VK_SUCCESS || cacheSize == 0)
+        {
+            return;
+        }
+
+        std::vector<char> cacheData(cacheSize);
+        if (vkGetPipelineCacheData(m_Device, m_PipelineCache, &cacheSize, cacheData.data()) != VK_SUCCESS)
+        {
+            return;
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(s_PipelineCacheDirectory, error);
+
+        // Write aside and swap in, so a crash never leaves a torn cache behind
+        const std::string tempPath{ s_PipelineCachePath + ".tmp" };
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                std::cout << "Pipeline cache was not written: " << s_PipelineCachePath << std::endl;
+                return;
+            }
+            file.write(cacheData.data(), static_cast<std::streamsize>(cacheSize));
+        }
+
+        std::filesystem::rename(tempPath, s_PipelineCachePath, error);
+        if (error)
+        {
+            std::filesystem::remove(tempPath, error);
+        }
+    }
+}
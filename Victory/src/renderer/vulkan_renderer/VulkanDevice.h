@@ -1,6 +1,9 @@
 #pragma once
 
 namespace Victory {
+    class VulkanAllocator;
+    class VulkanUploadContext;
+
     enum class QueueIndex 
     {
         eGraphics,
@@ -43,7 +46,9 @@ namespace Victory {
         static VulkanDevice* Init();
         static void Cleanup();
 
-        void CreateInstance(const char* applicationName_);
+        // Headless instances skip the window system extensions
+        void CreateInstance(const char* applicationName_, bool headless_ = false);
+        // Without a surface no present queue or swapchain support is required
         void PickPhysicalDevice(VkSurfaceKHR surface_);
         void CreateLogicalDevice();
 
@@ -54,9 +59,6 @@ namespace Victory {
         const VkFormat FindSupportedFormat(const std::vector<VkFormat> &formats, 
             VkImageTiling tiling_, VkFormatFeatureFlags features_);
 
-        VkCommandBuffer BeginSingleTimeCommands();
-        void EndSingleTimeCommands(VkCommandBuffer commandBuffer_);
-
         inline const VkInstance GetInstance() const 
         {
             return m_Instance;
@@ -87,11 +89,38 @@ namespace Victory {
             vkGetDeviceQueue(m_Device, m_QueueIndices[queueIndex_], 0, &queue_);
         }
 
+        inline bool IsHeadless() const 
+        {
+            return m_Headless;
+        }
+
         inline VkSampleCountFlagBits GetMaxSampleCount() const 
         {
             return m_MaxSampleCount;
         }
 
+        inline VulkanAllocator* GetAllocator() const 
+        {
+            return m_Allocator;
+        }
+
+        inline VulkanUploadContext* GetUploadContext() const 
+        {
+            return m_UploadContext;
+        }
+
+        // drawIndirectCount and multiDrawIndirect, enabled whenever the device has them
+        inline bool SupportsDrawIndirectCount() const 
+        {
+            return m_SupportsDrawIndirectCount;
+        }
+
+        // Shared by every pipeline, persisted across launches
+        inline VkPipelineCache GetPipelineCache() const 
+        {
+            return m_PipelineCache;
+        }
+
     private:
 
         VulkanDevice() = default;
@@ -99,10 +128,13 @@ namespace Victory {
 
         void CleanupResourses();
 
-        uint32_t RateDeviceSuitability(VkPhysicalDevice phDevice_);
+        uint32_t RateDeviceSuitability(VkPhysicalDevice phDevice_) const;
         bool PickQueueIndecies(VkPhysicalDevice phDevice_, VkSurfaceKHR surface_);
         void DefineMaxSampleCount();
 
+        void CreatePipelineCache();
+        void SavePipelineCache();
+
     private:
 
         VkInstance m_Instance{ VK_NULL_HANDLE };
@@ -110,9 +142,14 @@ namespace Victory {
         VkDevice m_Device{ VK_NULL_HANDLE };
 
         VulkanQueueIndices m_QueueIndices;
+        bool m_Headless{ false };
+
+        VulkanAllocator* m_Allocator{ nullptr };
+        VulkanUploadContext* m_UploadContext{ nullptr };
 
-        VkCommandPool m_CommandPool;
+        VkPipelineCache m_PipelineCache{ VK_NULL_HANDLE };
 
         VkSampleCountFlagBits m_MaxSampleCount{ VK_SAMPLE_COUNT_1_BIT };
+        bool m_SupportsDrawIndirectCount{ false };
     };
 }
@@ -0,0 +1,117 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <fstream>
+
+#include "VulkanFileUtils.h"
+
+#include "VertexData.h"
+#include "VertexDeduplication.h"
+#include "../../ThreadPool.h"
+#include "../../Profiler.h"
+
+// Load Object
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+// Load Image
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+namespace Victory 
+{
+    void LoadModel(const std::string& path_, std::vector<VertexData>& vertices_, std::vector<uint32_t>& indices_)
+    {
+        VICTORY_PROFILE_ZONE("LoadModel");
+
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warn, err;
+
+        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path_.c_str())) {
+            throw std::runtime_error(warn + err);
+        }
+
+        // Flatten all shapes into one corner stream, built in parallel
+        std::vector<size_t> shapeOffsets(shapes.size() + 1, 0);
+        for (size_t i{ 0 }; i < shapes.size(); ++i)
+        {
+            shapeOffsets[i + 1] = shapeOffsets[i] + shapes[i].mesh.indices.size();
+        }
+
+        std::vector<VertexData> corners(shapeOffsets.back());
+        ThreadPool::Init()->ParallelFor(static_cast<uint32_t>(corners.size()), 1 << 14, 
+            [&](uint32_t begin_, uint32_t end_, uint32_t)
+        {
+            size_t shape = std::upper_bound(shapeOffsets.begin(), shapeOffsets.end(), begin_) - shapeOffsets.begin() - 1;
+            for (uint32_t corner{ begin_ }; corner < end_; ++corner)
+            {
+                while (corner >= shapeOffsets[shape + 1])
+                {
+                    ++shape;
+                }
+
+                const tinyobj::index_t& index{ shapes[shape].mesh.indices[corner - shapeOffsets[shape]] };
+                VertexData& vertex{ corners[corner] };
+
+                vertex.position = {
+                    attrib.vertices[3 * index.vertex_index + 0],
+                    attrib.vertices[3 * index.vertex_index + 1],
+                    attrib.vertices[3 * index.vertex_index + 2]
+                };
+
+                vertex.texCoord = {
+                    attrib.texcoords[2 * index.texcoord_index + 0],
+                    1.f - attrib.texcoords[2 * index.texcoord_index + 1]
+                };
+            }
+        });
+
+        DeduplicateVertices(corners, vertices_, indices_);
+    }
+
+    unsigned char* LoadPixels(const std::string& path_, int& texWidth, int& texHeight)
+    {
+        VICTORY_PROFILE_ZONE("LoadPixels");
+
+        int texChannels;
+        stbi_uc* pixels = stbi_load(path_.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+
+        if (!pixels) {
+            throw std::runtime_error("Textrue was not loaded");
+        }
+
+        return pixels;
+    }
+
+    void DeletePixels(unsigned char* pixels)
+    {
+        stbi_image_free(pixels);
+    }
+
+    void SavePixels(const std::string& path_, const unsigned char* pixels_, uint32_t width_, uint32_t height_)
+    {
+        std::ofstream file(path_, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Image was not saved");
+        }
+
+        file << "P6\n" << width_ << " " << height_ << "\n255\n";
+
+        std::vector<char> row(static_cast<size_t>(width_) * 3);
+        for (uint32_t y{ 0 }; y < height_; ++y)
+        {
+            const unsigned char* src{ pixels_ + static_cast<size_t>(y) * width_ * 4 };
+            for (uint32_t x{ 0 }; x < width_; ++x)
+            {
+                row[x * 3 + 0] = static_cast<char>(src[x * 4 + 0]);
+                row[x * 3 + 1] = static_cast<char>(src[x * 4 + 1]);
+                row[x * 3 + 2] = static_cast<char>(src[x * 4 + 2]);
+            }
+            file.write(row.data(), static_cast<std::streamsize>(row.size()));
+        }
+    }
+
+}
\ No newline at end of file
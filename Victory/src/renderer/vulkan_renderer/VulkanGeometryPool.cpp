@@ -0,0 +1,75 @@
+#include <vector>
+#include <stdexcept>
+#include <vulkan/vulkan.h>
+
+#include "VulkanGeometryPool.h"
+
+#include "VulkanDevice.h"
+#include "VulkanUploadContext.h"
+#include "VertexData.h"
+
+namespace Victory
+{
+    VulkanGeometryPool::VulkanGeometryPool(VulkanDevice* vulkanDevice_,
+        uint32_t vertexCapacity_, uint32_t indexCapacity_)
+        : m_VulkanDevice{ vulkanDevice_ }, m_VertexCapacity{ vertexCapacity_ }, m_IndexCapacity{ indexCapacity_ }
+    {
+        VulkanAllocator* allocator{ m_VulkanDevice->GetAllocator() };
+
+        VkBufferCreateInfo bufferCI{};
+        bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCI.size = sizeof(PackedVertex) * static_cast<VkDeviceSize>(vertexCapacity_);
+        bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+        bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        allocator->CreateBuffer(bufferCI, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            m_VertexBuffer, m_VertexBufferMemory);
+
+        bufferCI.size = sizeof(uint32_t) * static_cast<VkDeviceSize>(indexCapacity_);
+        bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+
+        allocator->CreateBuffer(bufferCI, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            m_IndexBuffer, m_IndexBufferMemory);
+    }
+
+    VulkanGeometryPool::~VulkanGeometryPool()
+    {
+        VulkanAllocator* allocator{ m_VulkanDevice->GetAllocator() };
+
+        allocator->DestroyBuffer(m_VertexBuffer, m_VertexBufferMemory);
+        allocator->DestroyBuffer(m_IndexBuffer, m_IndexBufferMemory);
+    }
+
+    GeometryRange VulkanGeometryPool::Upload(const void* vertices_, uint32_t vertexCount_,
+        const uint32_t* indices_, uint32_t indexCount_)
+    {
+        if (vertexCount_ > m_VertexCapacity - m_VertexCount || indexCount_ > m_IndexCapacity - m_IndexCount)
+        {
+            throw std::runtime_error("Geometry pool is full");
+        }
+
+        GeometryRange range{};
+        range.firstIndex = m_IndexCount;
+        range.indexCount = indexCount_;
+        range.vertexOffset = static_cast<int32_t>(m_VertexCount);
+        range.vertexCount = vertexCount_;
+
+        // Only the written ranges change owner, the rest of the pool keeps being drawn from
+        VulkanUploadContext* uploadContext{ m_VulkanDevice->GetUploadContext() };
+        uploadContext->UploadBuffer(vertices_, sizeof(PackedVertex) * static_cast<VkDeviceSize>(vertexCount_),
+            m_VertexBuffer, sizeof(PackedVertex) * static_cast<VkDeviceSize>(m_VertexCount));
+        uploadContext->UploadBuffer(indices_, sizeof(uint32_t) * static_cast<VkDeviceSize>(indexCount_),
+            m_IndexBuffer, sizeof(uint32_t) * static_cast<VkDeviceSize>(m_IndexCount));
+
+        m_VertexCount += vertexCount_;
+        m_IndexCount += indexCount_;
+        return range;
+    }
+
+    void VulkanGeometryPool::Bind(VkCommandBuffer commandBuffer_) const
+    {
+        const VkDeviceSize offset{ 0 };
+        vkCmdBindVertexBuffers(commandBuffer_, 0, 1, &m_VertexBuffer, &offset);
+        vkCmdBindIndexBuffer(commandBuffer_, m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+    }
+}
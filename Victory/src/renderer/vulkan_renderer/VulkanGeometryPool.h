@@ -0,0 +1,59 @@
+#pragma once
+
+#include "VulkanAllocator.h"
+
+namespace Victory
+{
+    class VulkanDevice;
+
+    // Place of one mesh inside the pool, the arguments of its indexed draw
+    struct GeometryRange
+    {
+        uint32_t firstIndex{ 0 };
+        uint32_t indexCount{ 0 };
+        int32_t vertexOffset{ 0 };
+        uint32_t vertexCount{ 0 };
+    };
+
+    // One vertex and one 32 bit index buffer shared by every mesh. The scene binds
+    // them once and any draw, indirect ones included, addresses a mesh through
+    // firstIndex and vertexOffset. Meshes live as long as the scene, so ranges are
+    // handed out linearly and never freed
+    class VulkanGeometryPool
+    {
+    public:
+
+        VulkanGeometryPool(VulkanDevice* vulkanDevice_, uint32_t vertexCapacity_, uint32_t indexCapacity_);
+        ~VulkanGeometryPool();
+
+        // Copies are recorded into the open upload batch
+        GeometryRange Upload(const void* vertices_, uint32_t vertexCount_,
+            const uint32_t* indices_, uint32_t indexCount_);
+
+        void Bind(VkCommandBuffer commandBuffer_) const;
+
+        inline uint32_t GetVertexCount() const
+        {
+            return m_VertexCount;
+        }
+
+        inline uint32_t GetIndexCount() const
+        {
+            return m_IndexCount;
+        }
+
+    private:
+
+        VulkanDevice* m_VulkanDevice;
+
+        uint32_t m_VertexCapacity;
+        uint32_t m_IndexCapacity;
+        uint32_t m_VertexCount{ 0 };
+        uint32_t m_IndexCount{ 0 };
+
+        VkBuffer m_VertexBuffer{ VK_NULL_HANDLE };
+        VulkanAllocation m_VertexBufferMemory{};
+        VkBuffer m_IndexBuffer{ VK_NULL_HANDLE };
+        VulkanAllocation m_IndexBufferMemory{};
+    };
+}
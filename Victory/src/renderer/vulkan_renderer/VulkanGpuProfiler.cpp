@@ -0,0 +1,203 @@
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "VulkanGpuProfiler.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "VulkanDevice.h"
+#include "VulkanUtils.h"
+
+namespace Victory
+{
+    const static uint32_t s_MaxScopesPerFrame{ 32 };
+    const static uint32_t s_HistorySize{ 240 };
+
+    VulkanGpuProfiler::VulkanGpuProfiler(VulkanDevice* vulkanDevice_, uint32_t framesInFlight_)
+        : m_VulkanDevice{ vulkanDevice_ }
+    {
+        VkPhysicalDevice physicalDevice{ m_VulkanDevice->GetPhysicalDevice() };
+
+        uint32_t queueFamilyCount{ 0 };
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+        const uint32_t validBits{
+            queueFamilies[m_VulkanDevice->GetQueueIndex(QueueIndex::eGraphics)].timestampValidBits };
+        if (validBits == 0)
+        {
+            std::cout << "GPU profiler disabled, the graphics queue has no timestamps" << std::endl;
+            return;
+        }
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+        m_TimestampPeriod = properties.limits.timestampPeriod;
+        m_TimestampMask = validBits >= 64 ? UINT64_MAX : (uint64_t{ 1 } << validBits) - 1;
+
+        VkQueryPoolCreateInfo queryPoolCI{};
+        queryPoolCI.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolCI.pNext = nullptr;
+        queryPoolCI.flags = 0;
+        queryPoolCI.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolCI.queryCount = s_MaxScopesPerFrame * 2;
+        queryPoolCI.pipelineStatistics = 0;
+
+        m_Frames.resize(framesInFlight_);
+        for (auto&& frame : m_Frames)
+        {
+            CheckVulkanResult(
+                vkCreateQueryPool(m_VulkanDevice->GetDevice(), &queryPoolCI, nullptr, &frame.queryPool),
+                "Timestamp query pool was not created");
+            frame.scopes.reserve(s_MaxScopesPerFrame);
+        }
+
+        m_Results.resize(s_MaxScopesPerFrame * 2);
+    }
+
+    VulkanGpuProfiler::~VulkanGpuProfiler()
+    {
+        for (auto&& frame : m_Frames)
+        {
+            vkDestroyQueryPool(m_VulkanDevice->GetDevice(), frame.queryPool, nullptr);
+        }
+    }
+
+    void VulkanGpuProfiler::BeginFrame(uint32_t frameIndex_)
+    {
+        if (!IsSupported())
+        {
+            return;
+        }
+
+        m_CurrentFrame = frameIndex_;
+
+        FrameQueries& frame{ m_Frames[frameIndex_] };
+        Collect(frame);
+        frame.scopes.clear();
+        frame.reset = false;
+    }
+
+    void VulkanGpuProfiler::BeginScope(VkCommandBuffer commandBuffer_, const std::string& name_)
+    {
+        if (!IsSupported())
+        {
+            return;
+        }
+
+        FrameQueries& frame{ m_Frames[m_CurrentFrame] };
+        if (frame.scopes.size() == s_MaxScopesPerFrame)
+        {
+            return;
+        }
+
+        // The first command buffer of the frame resets the whole pool for the ones after it
+        if (!frame.reset)
+        {
+            vkCmdResetQueryPool(commandBuffer_, frame.queryPool, 0, s_MaxScopesPerFrame * 2);
+            frame.reset = true;
+        }
+
+        auto [it, inserted] = m_PassIndices.try_emplace(name_, static_cast<uint32_t>(m_Passes.size()));
+        if (inserted)
+        {
+            PassHistory& pass{ m_Passes.emplace_back() };
+            pass.name = name_;
+            pass.samples.reserve(s_HistorySize);
+        }
+
+        m_OpenScope = static_cast<uint32_t>(frame.scopes.size());
+        frame.scopes.push_back(it->second);
+
+        vkCmdWriteTimestamp(commandBuffer_, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.queryPool, m_OpenScope * 2);
+    }
+
+    void VulkanGpuProfiler::EndScope(VkCommandBuffer commandBuffer_)
+    {
+        if (m_OpenScope == UINT32_MAX)
+        {
+            return;
+        }
+
+        vkCmdWriteTimestamp(commandBuffer_, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            m_Frames[m_CurrentFrame].queryPool, m_OpenScope * 2 + 1);
+        m_OpenScope = UINT32_MAX;
+    }
+
+    std::vector<GpuPassStats> VulkanGpuProfiler::GetStats() const
+    {
+        std::vector<GpuPassStats> stats;
+        stats.reserve(m_Passes.size());
+
+        std::vector<float> sorted;
+        for (auto&& pass : m_Passes)
+        {
+            GpuPassStats& passStats{ stats.emplace_back() };
+            passStats.name = pass.name;
+            passStats.lastMs = pass.lastMs;
+            passStats.sampleCount = static_cast<uint32_t>(pass.samples.size());
+            if (pass.samples.empty())
+            {
+                continue;
+            }
+
+            sorted = pass.samples;
+            std::sort(sorted.begin(), sorted.end());
+
+            float sum{ 0.f };
+            for (float sample : sorted)
+            {
+                sum += sample;
+            }
+
+            const size_t last{ sorted.size() - 1 };
+            passStats.averageMs = sum / static_cast<float>(sorted.size());
+            passStats.p50Ms = sorted[last * 50 / 100];
+            passStats.p95Ms = sorted[last * 95 / 100];
+            passStats.p99Ms = sorted[last * 99 / 100];
+        }
+
+        return stats;
+    }
+
+    void VulkanGpuProfiler::Collect(FrameQueries& frame_)
+    {
+        if (frame_.scopes.empty())
+        {
+            return;
+        }
+
+        // No wait bit, a frame that is somehow not done yet is dropped instead of stalling
+        const uint32_t queryCount{ static_cast<uint32_t>(frame_.scopes.size()) * 2 };
+        const VkResult result{ vkGetQueryPoolResults(m_VulkanDevice->GetDevice(), frame_.queryPool,
+            0, queryCount, queryCount * sizeof(uint64_t), m_Results.data(), sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT) };
+        if (result != VK_SUCCESS)
+        {
+            return;
+        }
+
+        for (uint32_t scope{ 0 }, n = static_cast<uint32_t>(frame_.scopes.size()); scope < n; ++scope)
+        {
+            const uint64_t begin{ m_Results[scope * 2] & m_TimestampMask };
+            const uint64_t end{ m_Results[scope * 2 + 1] & m_TimestampMask };
+            const uint64_t ticks{ (end - begin) & m_TimestampMask };
+
+            PassHistory& pass{ m_Passes[frame_.scopes[scope]] };
+            pass.lastMs = static_cast<float>(static_cast<double>(ticks) * m_TimestampPeriod * 1e-6);
+
+            if (pass.samples.size() < s_HistorySize)
+            {
+                pass.samples.push_back(pass.lastMs);
+            }
+            else
+            {
+                pass.samples[pass.next] = pass.lastMs;
+                pass.next = (pass.next + 1) % s_HistorySize;
+            }
+        }
+    }
+}
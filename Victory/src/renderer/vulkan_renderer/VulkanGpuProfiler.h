@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace Victory
+{
+    class VulkanDevice;
+
+    struct GpuPassStats
+    {
+        std::string name;
+        float lastMs{ 0.f };
+        float averageMs{ 0.f };
+        float p50Ms{ 0.f };
+        float p95Ms{ 0.f };
+        float p99Ms{ 0.f };
+        uint32_t sampleCount{ 0 };
+    };
+
+    // Timestamps around GPU passes, one query pool per frame in flight.
+    // Results are collected once the frame comes around again, its fence already
+    // waited, so reading them never stalls
+    class VulkanGpuProfiler
+    {
+    public:
+
+        VulkanGpuProfiler(VulkanDevice* vulkanDevice_, uint32_t framesInFlight_);
+        ~VulkanGpuProfiler();
+
+        // Collects what frameIndex_ measured last time, the fence of that frame must have signaled
+        void BeginFrame(uint32_t frameIndex_);
+
+        // Scopes of a frame may span several command buffers as long as they are
+        // submitted in recording order. Must be called outside of a render pass
+        void BeginScope(VkCommandBuffer commandBuffer_, const std::string& name_);
+        void EndScope(VkCommandBuffer commandBuffer_);
+
+        // Rolling statistics over the last s_HistorySize frames, in first seen order
+        std::vector<GpuPassStats> GetStats() const;
+
+        inline bool IsSupported() const
+        {
+            return m_TimestampPeriod > 0.f;
+        }
+
+    private:
+
+        struct FrameQueries
+        {
+            VkQueryPool queryPool{ VK_NULL_HANDLE };
+            // Pass of every scope written, scope i owns queries 2i and 2i + 1
+            std::vector<uint32_t> scopes;
+            bool reset{ false };
+        };
+
+        struct PassHistory
+        {
+            std::string name;
+            std::vector<float> samples;
+            uint32_t next{ 0 };
+            float lastMs{ 0.f };
+        };
+
+        void Collect(FrameQueries& frame_);
+
+    private:
+
+        VulkanDevice* m_VulkanDevice{ nullptr };
+
+        float m_TimestampPeriod{ 0.f };
+        uint64_t m_TimestampMask{ 0 };
+
+        std::vector<FrameQueries> m_Frames;
+        uint32_t m_CurrentFrame{ 0 };
+        uint32_t m_OpenScope{ UINT32_MAX };
+
+        std::vector<PassHistory> m_Passes;
+        std::unordered_map<std::string, uint32_t> m_PassIndices;
+
+        std::vector<uint64_t> m_Results;
+    };
+}
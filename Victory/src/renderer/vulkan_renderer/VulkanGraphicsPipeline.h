@@ -33,7 +33,6 @@ namespace Victory
         VulkanDevice* m_VulkanDevice{ nullptr };
         VulkanSwapchain* m_VulkanSwapchain{ nullptr };
 
-        VkPipelineCache m_PipelineCache{ VK_NULL_HANDLE };
         VkRenderPass m_RenderPass{ VK_NULL_HANDLE };
         VkPipeline m_Pipeline{ VK_NULL_HANDLE };
 
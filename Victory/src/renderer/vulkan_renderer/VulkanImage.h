@@ -2,6 +2,8 @@
 
 #include <string>
 
+#include "VulkanAllocator.h"
+
 namespace Victory 
 {
     class VulkanDevice;
@@ -19,8 +21,6 @@ namespace Victory
 
         void TransitionImageLayout(VkImageLayout oldLayout_, VkImageLayout newLayout_);
 
-        void GenerateMipmaps(VkFormat imageFormat_);
-
         void CleanupAll();
 
         inline VkImage GetImage() const {
@@ -31,7 +31,7 @@ namespace Victory
             return m_ImageView;
         }
 
-        inline VkDeviceMemory GetImageMemory() const {
+        inline const VulkanAllocation& GetImageMemory() const {
             return m_ImageMemory;
         }
 
@@ -45,9 +45,8 @@ namespace Victory
 
         VkImage m_Image{ VK_NULL_HANDLE };
         VkImageView m_ImageView{ VK_NULL_HANDLE };
-        VkDeviceMemory m_ImageMemory{ VK_NULL_HANDLE };
+        VulkanAllocation m_ImageMemory{};
 
-        VkExtent2D m_ImageExtent;
         uint32_t m_MipLevels{ 1 };
     };
 }
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "VulkanMaterial.h"
+
+#include "VulkanDevice.h"
+#include "VulkanFileUtils.h"
+
+namespace Victory
+{
+    VulkanMaterial::VulkanMaterial(VulkanDevice* vulkanDevice_)
+        : m_VulkanDevice{ vulkanDevice_ }, m_Image{ vulkanDevice_ } {}
+
+    void VulkanMaterial::LoadTexture(const std::string& path_, VkImageCreateInfo& imageCI_)
+    {
+        TextureCache textureCache{ path_ };
+        if (textureCache.Load())
+        {
+            // Staged straight from the mapped cache file, no decode and no mip generation
+            UploadMipChain(textureCache.GetData(), textureCache.GetDataSize(), textureCache.GetLevels(), imageCI_);
+            return;
+        }
+
+        int texWidth, texHeight;
+        unsigned char* pixels{ Victory::LoadPixels(path_, texWidth, texHeight) };
+
+        const TextureMipChain mipChain{ BuildMipChain(pixels, 
+            static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight)) };
+        Victory::DeletePixels(pixels);
+
+        textureCache.Store(mipChain);
+        UploadMipChain(mipChain.data.data(), mipChain.data.size(), mipChain.levels, imageCI_);
+    }
+
+    void VulkanMaterial::WriteDescriptorSet(VkDescriptorSet descriptorSet_, VkSampler sampler_)
+    {
+        m_DescriptorSet = descriptorSet_;
+
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfo.imageView = m_Image.GetImageView();
+        imageInfo.sampler = sampler_;
+
+        VkWriteDescriptorSet descriptorWrite{};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = m_DescriptorSet;
+        descriptorWrite.dstBinding = 0;
+        descriptorWrite.dstArrayElement = 0;
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.pImageInfo = &imageInfo;
+
+        vkUpdateDescriptorSets(m_VulkanDevice->GetDevice(), 1, &descriptorWrite, 0, nullptr);
+    }
+
+    bool VulkanMaterial::IsReady() const
+    {
+        return m_VulkanDevice->GetUploadContext()->IsComplete(m_UploadTicket);
+    }
+
+    void VulkanMaterial::CleanupAll()
+    {
+        // The descriptor set goes away with the pool of the scene
+        m_Image.CleanupAll();
+    }
+
+    void VulkanMaterial::UploadMipChain(const void* data_, VkDeviceSize size_,
+        const std::vector<TextureCacheLevel>& levels_, VkImageCreateInfo& imageCI_)
+    {
+        // Staging memory belongs to the upload batch and is released once the copy completed
+        VulkanUploadContext* uploadContext{ m_VulkanDevice->GetUploadContext() };
+        VkBuffer stagingBuffer{ uploadContext->Stage(data_, size_) };
+
+        imageCI_.extent.width = levels_[0].width;
+        imageCI_.extent.height = levels_[0].height;
+        imageCI_.mipLevels = static_cast<uint32_t>(levels_.size());
+
+        m_Image.CreateImage(imageCI_, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        m_Image.TransitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        CopyBufferToImage(stagingBuffer, levels_);
+
+        VkImageSubresourceRange range{};
+        range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        range.baseMipLevel = 0;
+        range.levelCount = imageCI_.mipLevels;
+        range.baseArrayLayer = 0;
+        range.layerCount = 1;
+        uploadContext->TransferOwnership(m_Image.GetImage(), range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+        m_Image.TransitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        m_Image.CreateImageView(imageCI_.format, VK_IMAGE_ASPECT_COLOR_BIT);
+
+        m_UploadTicket = uploadContext->GetPendingTicket();
+    }
+
+    void VulkanMaterial::CopyBufferToImage(VkBuffer stagingBuffer_, const std::vector<TextureCacheLevel>& levels_) 
+    {
+        // Every level in one copy
+        std::vector<VkBufferImageCopy> regions(levels_.size());
+        for (size_t i{ 0 }; i < levels_.size(); ++i)
+        {
+            VkBufferImageCopy& region{ regions[i] };
+            region.bufferOffset = levels_[i].offset;
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = static_cast<uint32_t>(i);
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+
+            region.imageOffset = {0, 0, 0};
+            region.imageExtent = { levels_[i].width, levels_[i].height, 1 };
+        }
+
+        VkCommandBuffer commandBuffer = m_VulkanDevice->GetUploadContext()->GetTransferCommandBuffer();
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer_, m_Image.GetImage(),
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+
+#include "VulkanImage.h"
+#include "VulkanUploadContext.h"
+#include "TextureCache.h"
+
+namespace Victory
+{
+    class VulkanDevice;
+
+    // Texture of a material instance and the descriptor set it is bound with
+    class VulkanMaterial
+    {
+    public:
+        explicit VulkanMaterial(VulkanDevice* vulkanDevice_);
+
+        void LoadTexture(const std::string& path_, VkImageCreateInfo& imageCI_);
+        void WriteDescriptorSet(VkDescriptorSet descriptorSet_, VkSampler sampler_);
+
+        // The material can be bound once the upload batch of its texture completed
+        bool IsReady() const;
+
+        void CleanupAll();
+
+        inline VkDescriptorSet GetDescriptorSet() const
+        {
+            return m_DescriptorSet;
+        }
+
+    private:
+
+        void UploadMipChain(const void* data_, VkDeviceSize size_,
+            const std::vector<TextureCacheLevel>& levels_, VkImageCreateInfo& imageCI_);
+        void CopyBufferToImage(VkBuffer stagingBuffer_, const std::vector<TextureCacheLevel>& levels_);
+
+    private:
+
+        VulkanDevice* m_VulkanDevice;
+
+        VulkanImage m_Image;
+        UploadTicket m_UploadTicket{ 0 };
+
+        VkDescriptorSet m_DescriptorSet{ VK_NULL_HANDLE };
+    };
+}
@@ -1,19 +1,17 @@
 #pragma once
 
-struct CreateBufferSettings;
-struct VertexData;
+#include <string>
+#include <vector>
+
+#include "VulkanUploadContext.h"
+#include "VulkanGeometryPool.h"
+#include "FrustumCulling.h"
+#include "MeshSimplification.h"
+#include "MeshletBuilder.h"
 
 namespace Victory 
 {
-    struct CreateBufferSettings {
-        VkDeviceSize size;
-        VkBufferUsageFlags usage;
-        VkMemoryPropertyFlags properties;
-    };
-
     class VulkanDevice;
-    class VulkanSwapchain;
-    class VulkanImage;
 
     class VulkanModel
     {
@@ -21,70 +19,48 @@ namespace Victory
         VulkanModel();
         ~VulkanModel();
 
-        void LoadModel(const std::string& path_);
-        void LoadTexture(const std::string& path_, VkImageCreateInfo& imageCI_);
-        void CreateDescriptors(VkDescriptorSetLayout layout_, VkDescriptorBufferInfo bufferI_);
+        // Vertices and indices are placed in geometryPool_, which outlives the model.
+        // Up to lodLimit_ LODs share the vertices, their indices follow one another
+        void LoadModel(const std::string& path_, VulkanGeometryPool* geometryPool_, uint32_t lodLimit_);
 
-        void CleanupAll();
+        // Uploads are recorded into the shared upload batch, the mesh can be drawn
+        // once the batch it went into completed
+        bool IsReady() const;
 
-        inline const VkBuffer& GetVertexBuffer() const
+        inline const GeometryRange& GetGeometry() const
         {
-            return m_VertexBuffer;
+            return m_Geometry;
         }
 
-        inline const VkBuffer& GetIndexBuffer() const
+        inline uint32_t GetIndexCount() const
         {
-            return m_IndexBuffer;
+            return m_Geometry.indexCount;
         }
 
-        inline const std::vector<VertexData>& GetVerices() const
+        inline const MeshBounds& GetBounds() const
         {
-            return m_Vertices;
+            return m_Bounds;
         }
 
-        inline const std::vector<uint16_t>& GetIndices() const
+        // Index ranges relative to the geometry, finest first
+        inline const std::vector<MeshLod>& GetLods() const
         {
-            return m_Indices;
+            return m_Lods;
         }
 
-        inline const VkDescriptorSet& GetDescriptorSet() const 
+        inline const std::vector<Meshlet>& GetMeshlets() const
         {
-            return m_DescriptorSet;
+            return m_Meshlets;
         }
 
-    private:
-
-        void CreateVertexBuffer();
-        void CreateIndexBuffer();
-
-        void CreateSampler();
-
-        // TODO: Split this functions
-        void BindBuffer(const CreateBufferSettings& bufferSettings_,
-            VkBuffer& buffer_, VkDeviceMemory& bufferMemory_);
-        void CopyBuffer(VkBuffer srcBuffer_, VkBuffer dstBuffer_, VkDeviceSize size_);
-        void CopyBufferToImage(VkBuffer stagingBuffer_, const VkImageCreateInfo& imageCI_);
-
-        void CreateDescriptorPool();
-        void CreateDescriptorSets(uint32_t maxFrames_, VkDescriptorSetLayout layout_, VkDescriptorBufferInfo bufferI_);
-
     private:
 
         VulkanDevice* m_VulkanDevice;
-        VulkanSwapchain* m_VulkanSwapchain;
-
-        std::vector<VertexData> m_Vertices;
-        std::vector<uint16_t> m_Indices;
-
-        VkBuffer m_VertexBuffer{ VK_NULL_HANDLE };
-        VkDeviceMemory m_VertexBufferMemory{ VK_NULL_HANDLE };
-        VkBuffer m_IndexBuffer{ VK_NULL_HANDLE };
-        VkDeviceMemory m_IndexBufferMemory{ VK_NULL_HANDLE };
-
-        VulkanImage* m_Image;
-        VkSampler m_ImageSampler{ VK_NULL_HANDLE };
 
-        VkDescriptorPool m_DescriptorPool;
-        VkDescriptorSet m_DescriptorSet;
+        GeometryRange m_Geometry{};
+        MeshBounds m_Bounds{};
+        std::vector<MeshLod> m_Lods;
+        std::vector<Meshlet> m_Meshlets;
+        UploadTicket m_UploadTicket{ 0 };
     };
 }
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "VulkanParallelRecorder.h"
+
+#include "VulkanDevice.h"
+#include "VulkanUtils.h"
+
+namespace Victory
+{
+    VulkanParallelRecorder::VulkanParallelRecorder(VulkanDevice* vulkanDevice_,
+        uint32_t framesInFlight_, uint32_t threadCount_)
+        : m_VulkanDevice{ vulkanDevice_ }, m_ThreadCount{ threadCount_ }
+    {
+        VkCommandPoolCreateInfo commandPoolCI{};
+        commandPoolCI.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        commandPoolCI.pNext = nullptr;
+        commandPoolCI.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        commandPoolCI.queueFamilyIndex = m_VulkanDevice->GetQueueIndex(QueueIndex::eGraphics);
+
+        m_Pools.resize(framesInFlight_ * threadCount_);
+        for (auto&& pool : m_Pools)
+        {
+            CheckVulkanResult(
+                vkCreateCommandPool(m_VulkanDevice->GetDevice(),
+                    &commandPoolCI, nullptr, &pool.commandPool),
+                "Secondary command pool was not created");
+        }
+    }
+
+    VulkanParallelRecorder::~VulkanParallelRecorder()
+    {
+        // Command buffers are freed together with their pools
+        for (auto&& pool : m_Pools)
+        {
+            vkDestroyCommandPool(m_VulkanDevice->GetDevice(), pool.commandPool, nullptr);
+        }
+    }
+
+    void VulkanParallelRecorder::BeginFrame(uint32_t frameIndex_)
+    {
+        m_CurrentFrame = frameIndex_;
+
+        for (uint32_t thread{ 0 }; thread < m_ThreadCount; ++thread)
+        {
+            ThreadCommandPool& pool{ m_Pools[frameIndex_ * m_ThreadCount + thread] };
+            if (pool.used)
+            {
+                vkResetCommandPool(m_VulkanDevice->GetDevice(), pool.commandPool, 0);
+                pool.used = 0;
+            }
+        }
+    }
+
+    VkCommandBuffer VulkanParallelRecorder::Begin(uint32_t threadIndex_,
+        VkRenderPass renderPass_, VkFramebuffer frameBuffer_)
+    {
+        ThreadCommandPool& pool{ m_Pools[m_CurrentFrame * m_ThreadCount + threadIndex_] };
+
+        if (pool.used == pool.commandBuffers.size())
+        {
+            VkCommandBufferAllocateInfo allocateI{};
+            allocateI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocateI.pNext = nullptr;
+            allocateI.commandPool = pool.commandPool;
+            allocateI.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocateI.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer{ VK_NULL_HANDLE };
+            CheckVulkanResult(
+                vkAllocateCommandBuffers(m_VulkanDevice->GetDevice(), &allocateI, &commandBuffer),
+                "Secondary command buffer was not allocated");
+            pool.commandBuffers.push_back(commandBuffer);
+        }
+
+        VkCommandBuffer commandBuffer{ pool.commandBuffers[pool.used++] };
+
+        VkCommandBufferInheritanceInfo inheritanceI{};
+        inheritanceI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceI.pNext = nullptr;
+        inheritanceI.renderPass = renderPass_;
+        inheritanceI.subpass = 0;
+        inheritanceI.framebuffer = frameBuffer_;
+
+        VkCommandBufferBeginInfo beginI{};
+        beginI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginI.pNext = nullptr;
+        beginI.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginI.pInheritanceInfo = &inheritanceI;
+
+        vkBeginCommandBuffer(commandBuffer, &beginI);
+        return commandBuffer;
+    }
+}
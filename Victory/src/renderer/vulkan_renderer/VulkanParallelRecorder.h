@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+
+namespace Victory
+{
+    class VulkanDevice;
+
+    // Secondary command buffers for recording one render pass from many threads.
+    // Every (frame, thread) pair owns a command pool, so threads never share a pool
+    // and a frame resets all of its pools at once after its fence signaled
+    class VulkanParallelRecorder
+    {
+    public:
+
+        VulkanParallelRecorder(VulkanDevice* vulkanDevice_, uint32_t framesInFlight_, uint32_t threadCount_);
+        ~VulkanParallelRecorder();
+
+        // Recycles every command buffer the frame recorded last time
+        void BeginFrame(uint32_t frameIndex_);
+
+        // Returns a secondary command buffer already begun inside renderPass_,
+        // only threadIndex_ may call this for its own index during the frame
+        VkCommandBuffer Begin(uint32_t threadIndex_, VkRenderPass renderPass_, VkFramebuffer frameBuffer_);
+
+    private:
+
+        struct ThreadCommandPool
+        {
+            VkCommandPool commandPool{ VK_NULL_HANDLE };
+            std::vector<VkCommandBuffer> commandBuffers;
+            uint32_t used{ 0 };
+        };
+
+    private:
+
+        VulkanDevice* m_VulkanDevice{ nullptr };
+
+        uint32_t m_ThreadCount{ 0 };
+        uint32_t m_CurrentFrame{ 0 };
+
+        // [frame * threadCount + thread]
+        std::vector<ThreadCommandPool> m_Pools;
+    };
+}
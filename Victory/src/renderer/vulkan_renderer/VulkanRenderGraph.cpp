@@ -0,0 +1,611 @@
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "VulkanRenderGraph.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include "VulkanDevice.h"
+#include "VulkanSwapchain.h"
+#include "VulkanFrameBuffer.h"
+#include "VulkanGraphicsPipeline.h"
+#include "VulkanDeletionQueue.h"
+#include "VulkanUtils.h"
+
+namespace Victory
+{
+    const static VkMemoryPropertyFlags s_LazyMemoryProperty{
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT };
+
+    static RenderGraphImageState GetUsageState(RenderGraphUsage usage_, bool write_)
+    {
+        switch (usage_)
+        {
+        case RenderGraphUsage::eColorAttachment:
+            // Written attachments may also be loaded
+            return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                write_ ? VkAccessFlags{ VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT } :
+                    VK_ACCESS_COLOR_ATTACHMENT_READ_BIT };
+        case RenderGraphUsage::eDepthAttachment:
+            return { write_ ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                write_ ? VkAccessFlags{ VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT } :
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT };
+        case RenderGraphUsage::eSampled:
+            return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT };
+        case RenderGraphUsage::eComputeSampled:
+            return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT };
+        case RenderGraphUsage::eStorage:
+            return { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                write_ ? VkAccessFlags{ VK_ACCESS_SHADER_WRITE_BIT } : VK_ACCESS_SHADER_READ_BIT };
+        case RenderGraphUsage::eTransferSrc:
+            return { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT };
+        case RenderGraphUsage::eTransferDst:
+            return { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT };
+        }
+
+        throw std::invalid_argument("Unknown render graph usage");
+    }
+
+    VulkanRenderGraph::VulkanRenderGraph(VulkanDevice* vulkanDevice_, VulkanDeletionQueue* deletionQueue_)
+        : m_VulkanDevice{ vulkanDevice_ }, m_DeletionQueue{ deletionQueue_ } {}
+
+    VulkanRenderGraph::~VulkanRenderGraph()
+    {
+        // The device is idle by now
+        VkDevice device{ m_VulkanDevice->GetDevice() };
+        for (auto&& resource : m_Resources)
+        {
+            if (resource.transient)
+            {
+                vkDestroyImage(device, resource.image, nullptr);
+            }
+        }
+
+        for (auto&& memory : m_TransientMemory)
+        {
+            m_VulkanDevice->GetAllocator()->Free(memory);
+        }
+
+        for (auto&& memory : m_LazyMemory)
+        {
+            m_VulkanDevice->GetAllocator()->Free(memory);
+        }
+    }
+
+    RenderGraphResource VulkanRenderGraph::CreateImage(const std::string& name_,
+        const VkImageCreateInfo& imageCI_, VkImageAspectFlags aspect_)
+    {
+        Resource& resource{ m_Resources.emplace_back() };
+        resource.name = name_;
+        resource.aspect = aspect_;
+        resource.transient = true;
+        resource.imageCI = imageCI_;
+
+        return static_cast<RenderGraphResource>(m_Resources.size() - 1);
+    }
+
+    RenderGraphResource VulkanRenderGraph::ImportImage(const std::string& name_, VkImageAspectFlags aspect_,
+        const RenderGraphImageState& initial_, VkImageLayout finalLayout_)
+    {
+        Resource& resource{ m_Resources.emplace_back() };
+        resource.name = name_;
+        resource.aspect = aspect_;
+        resource.initial = initial_;
+        resource.finalLayout = finalLayout_;
+
+        return static_cast<RenderGraphResource>(m_Resources.size() - 1);
+    }
+
+    RenderGraphPass VulkanRenderGraph::AddPass(const std::string& name_, VulkanGraphicsPipeline* pipeline_,
+        std::function<void(VkCommandBuffer)>&& record_)
+    {
+        Pass& pass{ m_Passes.emplace_back() };
+        pass.name = name_;
+        pass.pipeline = pipeline_;
+        pass.record = std::move(record_);
+
+        return static_cast<RenderGraphPass>(m_Passes.size() - 1);
+    }
+
+    void VulkanRenderGraph::Read(RenderGraphPass pass_, RenderGraphResource resource_, RenderGraphUsage usage_)
+    {
+        m_Passes[pass_].uses.push_back(ResourceUse{ resource_, usage_, false });
+    }
+
+    void VulkanRenderGraph::Write(RenderGraphPass pass_, RenderGraphResource resource_, RenderGraphUsage usage_)
+    {
+        if (usage_ == RenderGraphUsage::eSampled || usage_ == RenderGraphUsage::eComputeSampled)
+        {
+            throw std::invalid_argument("Sampled images can not be written");
+        }
+        m_Passes[pass_].uses.push_back(ResourceUse{ resource_, usage_, true });
+    }
+
+    void VulkanRenderGraph::MarkOutput(RenderGraphResource resource_)
+    {
+        m_Resources[resource_].output = true;
+    }
+
+    void VulkanRenderGraph::MarkSideEffect(RenderGraphPass pass_)
+    {
+        m_Passes[pass_].sideEffect = true;
+    }
+
+    void VulkanRenderGraph::ResizeImage(RenderGraphResource resource_, VkExtent2D extent_)
+    {
+        m_Resources[resource_].imageCI.extent.width = extent_.width;
+        m_Resources[resource_].imageCI.extent.height = extent_.height;
+    }
+
+    void VulkanRenderGraph::Compile()
+    {
+        m_Stats = RenderGraphStats{};
+        m_Stats.passCount = static_cast<uint32_t>(m_Passes.size());
+
+        CullPasses();
+        ComputeLifetimes();
+        AllocateTransients();
+        ComputeBarriers();
+    }
+
+    void VulkanRenderGraph::SetImage(RenderGraphResource resource_, VkImage image_)
+    {
+        m_Resources[resource_].image = image_;
+    }
+
+    VkImage VulkanRenderGraph::GetImage(RenderGraphResource resource_) const
+    {
+        return m_Resources[resource_].image;
+    }
+
+    void VulkanRenderGraph::Execute(uint32_t frameIndex_, std::vector<VkCommandBuffer>& commandBuffers_)
+    {
+        VulkanGraphicsPipeline* openPipeline{ nullptr };
+        VkCommandBuffer commandBuffer{ VK_NULL_HANDLE };
+
+        for (RenderGraphPass passIndex : m_ExecutionOrder)
+        {
+            Pass& pass{ m_Passes[passIndex] };
+            if (pass.pipeline != openPipeline)
+            {
+                if (openPipeline)
+                {
+                    openPipeline->EndFrame();
+                }
+
+                openPipeline = pass.pipeline;
+                commandBuffer = openPipeline->BeginFrame(frameIndex_);
+                commandBuffers_.push_back(commandBuffer);
+            }
+
+            RecordBarriers(commandBuffer, pass.barriers);
+            pass.record(commandBuffer);
+        }
+
+        if (openPipeline)
+        {
+            RecordBarriers(commandBuffer, m_FinalBarriers);
+            openPipeline->EndFrame();
+        }
+    }
+
+    VkDeviceSize VulkanRenderGraph::GetCommittedLazyBytes() const
+    {
+        VkDeviceSize committedBytes{ 0 };
+        for (auto&& memory : m_LazyMemory)
+        {
+            VkDeviceSize memoryCommitment{ 0 };
+            vkGetDeviceMemoryCommitment(m_VulkanDevice->GetDevice(), memory.memory, &memoryCommitment);
+            committedBytes += memoryCommitment;
+        }
+
+        return committedBytes;
+    }
+
+    void VulkanRenderGraph::PrintStats() const
+    {
+        std::cout << "Render graph: " << m_Stats.passCount - m_Stats.culledPassCount << "/" << m_Stats.passCount
+            << " passes, " << m_Stats.imageBarrierCount << " image barriers in " << m_Stats.barrierBatchCount
+            << " batches, transients " << m_Stats.transientBytes / 1024 << " KiB, "
+            << m_Stats.aliasedBytes / 1024 << " KiB saved by aliasing" << std::endl;
+
+        if (m_Stats.lazyBytes)
+        {
+            std::cout << "Render graph: " << m_Stats.lazyBytes / 1024 << " KiB of transients lazily allocated, "
+                << GetCommittedLazyBytes() / 1024 << " KiB committed" << std::endl;
+        }
+    }
+
+    void VulkanRenderGraph::CullPasses()
+    {
+        std::vector<bool> needed(m_Resources.size());
+        for (size_t i{ 0 }; i < m_Resources.size(); ++i)
+        {
+            needed[i] = m_Resources[i].output;
+        }
+
+        // Walking backwards every consumer is decided before its producers. Written
+        // resources stay needed, an earlier pass may provide content a later one loads
+        for (size_t i{ m_Passes.size() }; i-- > 0;)
+        {
+            Pass& pass{ m_Passes[i] };
+            pass.culled = !pass.sideEffect;
+            for (auto&& use : pass.uses)
+            {
+                if (use.write && needed[use.resource])
+                {
+                    pass.culled = false;
+                }
+            }
+
+            if (pass.culled)
+            {
+                ++m_Stats.culledPassCount;
+                continue;
+            }
+
+            for (auto&& use : pass.uses)
+            {
+                needed[use.resource] = true;
+            }
+        }
+
+        m_ExecutionOrder.clear();
+        for (uint32_t i{ 0 }, n = static_cast<uint32_t>(m_Passes.size()); i < n; ++i)
+        {
+            if (m_Passes[i].culled)
+            {
+                continue;
+            }
+
+            // Every pipeline owns one command buffer per frame, it can only be begun once
+            const VulkanGraphicsPipeline* pipeline{ m_Passes[i].pipeline };
+            if (!m_ExecutionOrder.empty() && m_Passes[m_ExecutionOrder.back()].pipeline != pipeline &&
+                std::any_of(m_ExecutionOrder.begin(), m_ExecutionOrder.end(),
+                    [&](RenderGraphPass pass_) { return m_Passes[pass_].pipeline == pipeline; }))
+            {
+                throw std::runtime_error("Render graph passes of one pipeline are not consecutive");
+            }
+
+            m_ExecutionOrder.push_back(i);
+        }
+    }
+
+    void VulkanRenderGraph::ComputeLifetimes()
+    {
+        for (auto&& resource : m_Resources)
+        {
+            resource.firstUse = UINT32_MAX;
+            resource.lastUse = 0;
+            resource.lastState = RenderGraphImageState{};
+        }
+
+        for (uint32_t order{ 0 }, n = static_cast<uint32_t>(m_ExecutionOrder.size()); order < n; ++order)
+        {
+            for (auto&& use : m_Passes[m_ExecutionOrder[order]].uses)
+            {
+                Resource& resource{ m_Resources[use.resource] };
+                resource.firstUse = std::min(resource.firstUse, order);
+                resource.lastUse = order;
+                resource.lastState = GetUsageState(use.usage, use.write);
+            }
+        }
+    }
+
+    void VulkanRenderGraph::AllocateTransients()
+    {
+        ReleaseTransients();
+
+        VkDevice device{ m_VulkanDevice->GetDevice() };
+
+        struct MemoryBlock
+        {
+            VkMemoryRequirements requirements{};
+            std::vector<RenderGraphResource> occupants;
+        };
+
+        std::vector<RenderGraphResource> transients;
+        std::vector<RenderGraphResource> lazyTransients;
+        std::vector<VkMemoryRequirements> requirements(m_Resources.size());
+        for (uint32_t i{ 0 }, n = static_cast<uint32_t>(m_Resources.size()); i < n; ++i)
+        {
+            Resource& resource{ m_Resources[i] };
+            if (!resource.transient || resource.firstUse == UINT32_MAX)
+            {
+                continue;
+            }
+
+            CheckVulkanResult(
+                vkCreateImage(device, &resource.imageCI, nullptr, &resource.image),
+                "Transient image was not created");
+            vkGetImageMemoryRequirements(device, resource.image, &requirements[i]);
+            m_Stats.transientBytes += requirements[i].size;
+
+            // Attachments that are only cleared, drawn and resolved within a render pass
+            if ((resource.imageCI.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) &&
+                m_VulkanDevice->FindMemoryType(requirements[i].memoryTypeBits, s_LazyMemoryProperty) != UINT32_MAX)
+            {
+                lazyTransients.push_back(i);
+                m_Stats.lazyBytes += requirements[i].size;
+                continue;
+            }
+
+            transients.push_back(i);
+        }
+
+        // Largest first, smaller images then fit into the memory of larger ones
+        std::sort(transients.begin(), transients.end(), [&](RenderGraphResource a_, RenderGraphResource b_)
+        {
+            return requirements[a_].size > requirements[b_].size;
+        });
+
+        std::vector<MemoryBlock> blocks;
+        for (RenderGraphResource transient : transients)
+        {
+            const Resource& resource{ m_Resources[transient] };
+            const VkMemoryRequirements& imageRequirements{ requirements[transient] };
+
+            auto fits = [&](const MemoryBlock& block_)
+            {
+                if (!(block_.requirements.memoryTypeBits & imageRequirements.memoryTypeBits))
+                {
+                    return false;
+                }
+
+                return std::none_of(block_.occupants.begin(), block_.occupants.end(), [&](RenderGraphResource occupant_)
+                {
+                    const Resource& occupant{ m_Resources[occupant_] };
+                    return resource.firstUse <= occupant.lastUse && occupant.firstUse <= resource.lastUse;
+                });
+            };
+
+            auto it{ std::find_if(blocks.begin(), blocks.end(), fits) };
+            if (it == blocks.end())
+            {
+                blocks.push_back(MemoryBlock{ imageRequirements, { transient } });
+                continue;
+            }
+
+            it->requirements.size = std::max(it->requirements.size, imageRequirements.size);
+            it->requirements.alignment = std::max(it->requirements.alignment, imageRequirements.alignment);
+            it->requirements.memoryTypeBits &= imageRequirements.memoryTypeBits;
+            it->occupants.push_back(transient);
+        }
+
+        VulkanAllocator* allocator{ m_VulkanDevice->GetAllocator() };
+
+        // Committed per allocation, sharing one would only make it grow to the largest image
+        m_LazyMemory.resize(lazyTransients.size());
+        for (size_t i{ 0 }; i < lazyTransients.size(); ++i)
+        {
+            Resource& resource{ m_Resources[lazyTransients[i]] };
+            resource.aliasPrevious = lazyTransients[i];
+
+            m_LazyMemory[i] = allocator->Allocate(requirements[lazyTransients[i]],
+                s_LazyMemoryProperty, true, AllocationStrategy::eBuddy);
+            CheckVulkanResult(
+                vkBindImageMemory(device, resource.image, m_LazyMemory[i].memory, m_LazyMemory[i].offset),
+                "Transient image was not binded");
+        }
+
+        m_TransientMemory.resize(blocks.size());
+        for (size_t i{ 0 }; i < blocks.size(); ++i)
+        {
+            MemoryBlock& block{ blocks[i] };
+            m_TransientMemory[i] = allocator->Allocate(block.requirements,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true, AllocationStrategy::eBuddy);
+            m_Stats.aliasedBytes += block.requirements.size;
+
+            // In lifetime order, the first occupant follows the last one of the previous frame
+            std::sort(block.occupants.begin(), block.occupants.end(), [&](RenderGraphResource a_, RenderGraphResource b_)
+            {
+                return m_Resources[a_].firstUse < m_Resources[b_].firstUse;
+            });
+
+            const size_t occupantCount{ block.occupants.size() };
+            for (size_t j{ 0 }; j < occupantCount; ++j)
+            {
+                Resource& resource{ m_Resources[block.occupants[j]] };
+                resource.aliasPrevious = block.occupants[(j + occupantCount - 1) % occupantCount];
+
+                CheckVulkanResult(
+                    vkBindImageMemory(device, resource.image, m_TransientMemory[i].memory, m_TransientMemory[i].offset),
+                    "Transient image was not binded");
+            }
+        }
+
+        m_Stats.aliasedBytes = m_Stats.transientBytes - m_Stats.lazyBytes - m_Stats.aliasedBytes;
+    }
+
+    void VulkanRenderGraph::ComputeBarriers()
+    {
+        // source is the last write or layout transition, visible what a barrier from it
+        // already covers. Reads outside of that need a barrier of their own
+        struct TrackedState
+        {
+            RenderGraphImageState state{};
+            bool write{ false };
+            VkPipelineStageFlags sourceStages{ 0 };
+            VkAccessFlags sourceAccess{ 0 };
+            VkPipelineStageFlags visibleStages{ 0 };
+            VkAccessFlags visibleAccess{ 0 };
+        };
+
+        std::vector<TrackedState> states(m_Resources.size());
+        for (size_t i{ 0 }; i < m_Resources.size(); ++i)
+        {
+            const Resource& resource{ m_Resources[i] };
+            if (!resource.transient)
+            {
+                states[i] = TrackedState{ resource.initial, resource.initial.access != 0 };
+                continue;
+            }
+
+            // Contents are discarded, but the memory may still be in use by whoever had it last
+            if (resource.aliasPrevious != UINT32_MAX)
+            {
+                const RenderGraphImageState& previous{ m_Resources[resource.aliasPrevious].lastState };
+                states[i] = TrackedState{ { VK_IMAGE_LAYOUT_UNDEFINED, previous.stages, previous.access }, true };
+            }
+        }
+
+        for (RenderGraphPass passIndex : m_ExecutionOrder)
+        {
+            Pass& pass{ m_Passes[passIndex] };
+            pass.barriers = BarrierBatch{};
+
+            for (auto&& use : pass.uses)
+            {
+                TrackedState& tracked{ states[use.resource] };
+                const RenderGraphImageState required{ GetUsageState(use.usage, use.write) };
+
+                // Reads in the same layout share one barrier, later writers wait for all of them.
+                // A read in a stage that barrier did not reach waits for the source on its own
+                if (!tracked.write && !use.write && tracked.state.layout == required.layout)
+                {
+                    if ((required.stages & ~tracked.visibleStages) != 0 || (required.access & ~tracked.visibleAccess) != 0)
+                    {
+                        const RenderGraphImageState source{ tracked.state.layout, tracked.sourceStages, tracked.sourceAccess };
+                        if (source.stages != 0)
+                        {
+                            AddBarrier(pass.barriers, use.resource, source, required, true);
+                        }
+                        tracked.visibleStages |= required.stages;
+                        tracked.visibleAccess |= required.access;
+                    }
+
+                    tracked.state.stages |= required.stages;
+                    tracked.state.access |= required.access;
+                    continue;
+                }
+
+                AddBarrier(pass.barriers, use.resource, tracked.state, required, tracked.write);
+
+                // After a transition later readers chain on this barrier, otherwise on the write
+                TrackedState next{ required, use.write, required.stages, required.access, 0, 0 };
+                if (!use.write)
+                {
+                    const bool transition{ tracked.state.layout != required.layout };
+                    next.sourceStages = transition || !tracked.write ? required.stages : tracked.state.stages;
+                    next.sourceAccess = transition || !tracked.write ? 0 : tracked.state.access;
+                    next.visibleStages = required.stages;
+                    next.visibleAccess = required.access;
+                }
+                tracked = next;
+            }
+
+            if (!pass.barriers.barriers.empty())
+            {
+                ++m_Stats.barrierBatchCount;
+            }
+        }
+
+        m_FinalBarriers = BarrierBatch{};
+        for (size_t i{ 0 }; i < m_Resources.size(); ++i)
+        {
+            const Resource& resource{ m_Resources[i] };
+            if (resource.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED || resource.firstUse == UINT32_MAX ||
+                resource.finalLayout == states[i].state.layout)
+            {
+                continue;
+            }
+
+            const RenderGraphImageState final{ resource.finalLayout, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0 };
+            AddBarrier(m_FinalBarriers, static_cast<RenderGraphResource>(i), states[i].state, final, states[i].write);
+        }
+
+        if (!m_FinalBarriers.barriers.empty())
+        {
+            ++m_Stats.barrierBatchCount;
+        }
+    }
+
+    void VulkanRenderGraph::AddBarrier(BarrierBatch& batch_, RenderGraphResource resource_,
+        const RenderGraphImageState& src_, const RenderGraphImageState& dst_, bool srcWrite_)
+    {
+        // Only writes need to be made available, after reads an execution dependency is enough
+        Barrier& barrier{ batch_.barriers.emplace_back() };
+        barrier.resource = resource_;
+        barrier.src = src_;
+        barrier.src.access = srcWrite_ ? src_.access : 0;
+        barrier.dst = dst_;
+
+        batch_.srcStages |= src_.stages;
+        batch_.dstStages |= dst_.stages;
+        ++m_Stats.imageBarrierCount;
+    }
+
+    void VulkanRenderGraph::RecordBarriers(VkCommandBuffer commandBuffer_, const BarrierBatch& batch_)
+    {
+        if (batch_.barriers.empty())
+        {
+            return;
+        }
+
+        m_ImageBarriers.clear();
+        for (auto&& barrier : batch_.barriers)
+        {
+            const Resource& resource{ m_Resources[barrier.resource] };
+
+            VkImageMemoryBarrier& imageBarrier{ m_ImageBarriers.emplace_back() };
+            imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            imageBarrier.pNext = nullptr;
+            imageBarrier.srcAccessMask = barrier.src.access;
+            imageBarrier.dstAccessMask = barrier.dst.access;
+            imageBarrier.oldLayout = barrier.src.layout;
+            imageBarrier.newLayout = barrier.dst.layout;
+            imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.image = resource.image;
+            imageBarrier.subresourceRange.aspectMask = resource.aspect;
+            imageBarrier.subresourceRange.baseMipLevel = 0;
+            imageBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+            imageBarrier.subresourceRange.baseArrayLayer = 0;
+            imageBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+        }
+
+        vkCmdPipelineBarrier(commandBuffer_, batch_.srcStages, batch_.dstStages, 0,
+            0, nullptr, 0, nullptr, static_cast<uint32_t>(m_ImageBarriers.size()), m_ImageBarriers.data());
+    }
+
+    void VulkanRenderGraph::ReleaseTransients()
+    {
+        std::vector<VkImage> images;
+        for (auto&& resource : m_Resources)
+        {
+            if (resource.transient && resource.image)
+            {
+                images.push_back(resource.image);
+                resource.image = VK_NULL_HANDLE;
+            }
+            resource.aliasPrevious = UINT32_MAX;
+        }
+
+        if (images.empty() && m_TransientMemory.empty() && m_LazyMemory.empty())
+        {
+            return;
+        }
+
+        std::vector<VulkanAllocation> memory{ m_TransientMemory };
+        memory.insert(memory.end(), m_LazyMemory.begin(), m_LazyMemory.end());
+
+        // Frames in flight may still render into them
+        m_DeletionQueue->Push([vulkanDevice = m_VulkanDevice, images, memory]() mutable
+        {
+            for (VkImage image : images)
+            {
+                vkDestroyImage(vulkanDevice->GetDevice(), image, nullptr);
+            }
+
+            for (auto&& allocation : memory)
+            {
+                vulkanDevice->GetAllocator()->Free(allocation);
+            }
+        });
+        m_TransientMemory.clear();
+        m_LazyMemory.clear();
+    }
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "VulkanAllocator.h"
+
+namespace Victory
+{
+    class VulkanDevice;
+    class VulkanDeletionQueue;
+    class VulkanGraphicsPipeline;
+
+    using RenderGraphResource = uint32_t;
+    using RenderGraphPass = uint32_t;
+
+    enum class RenderGraphUsage
+    {
+        eColorAttachment,
+        eDepthAttachment,
+        eSampled,
+        // Sampled by a compute shader
+        eComputeSampled,
+        // Storage image of a compute shader, kept in general layout
+        eStorage,
+        eTransferSrc,
+        eTransferDst
+    };
+
+    struct RenderGraphImageState
+    {
+        VkImageLayout layout{ VK_IMAGE_LAYOUT_UNDEFINED };
+        VkPipelineStageFlags stages{ VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT };
+        VkAccessFlags access{ 0 };
+    };
+
+    struct RenderGraphStats
+    {
+        uint32_t passCount{ 0 };
+        uint32_t culledPassCount{ 0 };
+        uint32_t barrierBatchCount{ 0 };
+        uint32_t imageBarrierCount{ 0 };
+        VkDeviceSize transientBytes{ 0 };
+        VkDeviceSize aliasedBytes{ 0 };
+        // Transients in lazily allocated memory, they take no part in aliasing
+        VkDeviceSize lazyBytes{ 0 };
+    };
+
+    // Passes of a frame declare the images they read and write, the graph orders
+    // the synchronization between them. Compile culls passes nothing depends on and
+    // precomputes one batched barrier per pass, so a frame only records them.
+    //
+    // Transient images are owned by the graph. Their content never outlives a frame,
+    // so images whose lifetimes do not overlap share memory. Imported images belong to
+    // someone else and can change every frame, e.g. the acquired swapchain image.
+    //
+    // Transient attachments (VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) go into lazily
+    // allocated memory where the device has it, on tilers they never get backing.
+    //
+    // Passes run in the order they were added. Consecutive passes of one pipeline
+    // record into its command buffer, render passes must not change layouts themselves
+    class VulkanRenderGraph
+    {
+    public:
+
+        VulkanRenderGraph(VulkanDevice* vulkanDevice_, VulkanDeletionQueue* deletionQueue_);
+        ~VulkanRenderGraph();
+
+        RenderGraphResource CreateImage(const std::string& name_,
+            const VkImageCreateInfo& imageCI_, VkImageAspectFlags aspect_);
+        // initial_ is the state the image is in when a frame starts, its stages are what
+        // the first barrier waits for. The image is left in finalLayout_ unless it is undefined
+        RenderGraphResource ImportImage(const std::string& name_, VkImageAspectFlags aspect_,
+            const RenderGraphImageState& initial_, VkImageLayout finalLayout_ = VK_IMAGE_LAYOUT_UNDEFINED);
+
+        RenderGraphPass AddPass(const std::string& name_, VulkanGraphicsPipeline* pipeline_,
+            std::function<void(VkCommandBuffer)>&& record_);
+        void Read(RenderGraphPass pass_, RenderGraphResource resource_, RenderGraphUsage usage_);
+        void Write(RenderGraphPass pass_, RenderGraphResource resource_, RenderGraphUsage usage_);
+
+        // Culling keeps every pass these depend on
+        void MarkOutput(RenderGraphResource resource_);
+        // For passes writing outside the graph, e.g. into a host buffer
+        void MarkSideEffect(RenderGraphPass pass_);
+
+        // Takes effect with the next Compile
+        void ResizeImage(RenderGraphResource resource_, VkExtent2D extent_);
+
+        // (Re)creates the transient images and the barriers. The images it replaces
+        // are retired, frames in flight may still use them
+        void Compile();
+
+        void SetImage(RenderGraphResource resource_, VkImage image_);
+        VkImage GetImage(RenderGraphResource resource_) const;
+
+        // Records every pass that survived culling, commandBuffers_ receives the
+        // command buffers in submission order
+        void Execute(uint32_t frameIndex_, std::vector<VkCommandBuffer>& commandBuffers_);
+
+        inline const RenderGraphStats& GetStats() const
+        {
+            return m_Stats;
+        }
+
+        // What the device actually backs of the lazily allocated transients
+        VkDeviceSize GetCommittedLazyBytes() const;
+
+        void PrintStats() const;
+
+    private:
+
+        struct ResourceUse
+        {
+            RenderGraphResource resource{ 0 };
+            RenderGraphUsage usage{ RenderGraphUsage::eSampled };
+            bool write{ false };
+        };
+
+        struct Resource
+        {
+            std::string name;
+            VkImageAspectFlags aspect{ 0 };
+            VkImage image{ VK_NULL_HANDLE };
+
+            bool transient{ false };
+            VkImageCreateInfo imageCI{};
+
+            bool output{ false };
+            RenderGraphImageState initial{};
+            VkImageLayout finalLayout{ VK_IMAGE_LAYOUT_UNDEFINED };
+
+            // Execution order indices of the first and last pass using it
+            uint32_t firstUse{ UINT32_MAX };
+            uint32_t lastUse{ 0 };
+            RenderGraphImageState lastState{};
+            // Transient that used the memory before this one, itself if it is alone
+            RenderGraphResource aliasPrevious{ UINT32_MAX };
+        };
+
+        struct Barrier
+        {
+            RenderGraphResource resource{ 0 };
+            RenderGraphImageState src{};
+            RenderGraphImageState dst{};
+        };
+
+        struct BarrierBatch
+        {
+            VkPipelineStageFlags srcStages{ 0 };
+            VkPipelineStageFlags dstStages{ 0 };
+            std::vector<Barrier> barriers;
+        };
+
+        struct Pass
+        {
+            std::string name;
+            VulkanGraphicsPipeline* pipeline{ nullptr };
+            std::function<void(VkCommandBuffer)> record;
+            std::vector<ResourceUse> uses;
+
+            bool sideEffect{ false };
+            bool culled{ false };
+            BarrierBatch barriers;
+        };
+
+        void CullPasses();
+        void ComputeLifetimes();
+        void AllocateTransients();
+        void ComputeBarriers();
+
+        void AddBarrier(BarrierBatch& batch_, RenderGraphResource resource_,
+            const RenderGraphImageState& src_, const RenderGraphImageState& dst_, bool srcWrite_);
+        void RecordBarriers(VkCommandBuffer commandBuffer_, const BarrierBatch& batch_);
+
+        void ReleaseTransients();
+
+    private:
+
+        VulkanDevice* m_VulkanDevice{ nullptr };
+        VulkanDeletionQueue* m_DeletionQueue{ nullptr };
+
+        std::vector<Resource> m_Resources;
+        std::vector<Pass> m_Passes;
+        std::vector<RenderGraphPass> m_ExecutionOrder;
+
+        // Shared by the transients placed in them
+        std::vector<VulkanAllocation> m_TransientMemory;
+        // One per lazily allocated transient
+        std::vector<VulkanAllocation> m_LazyMemory;
+
+        BarrierBatch m_FinalBarriers;
+        std::vector<VkImageMemoryBarrier> m_ImageBarriers;
+
+        RenderGraphStats m_Stats{};
+    };
+}
@@ -6,17 +6,29 @@
 #include <GLFW/glfw3.h>
 
 #include <string>
+#include <algorithm>
 
 #include "Window.h"
 #include "VulkanDevice.h"
+#include "VulkanAllocator.h"
+#include "VulkanUploadContext.h"
 #include "VulkanSwapchain.h"
 #include "VulkanFrameBuffer.h"
 #include "VulkanImage.h"
 #include "VulkanGraphicsPipeline.h"
-#include "VulkanModel.h"
+#include "VulkanScene.h"
+#include "VulkanParallelRecorder.h"
+#include "VulkanGpuProfiler.h"
+#include "VulkanUniformRing.h"
+#include "VulkanDeletionQueue.h"
+#include "VulkanRenderGraph.h"
+#include "VulkanDepthPyramid.h"
+#include "VulkanFileUtils.h"
 #include "VulkanUtils.h"
 
 #include "../../Utils.h"
+#include "../../ThreadPool.h"
+#include "../../Profiler.h"
 
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_vulkan.h>
@@ -26,12 +38,36 @@
 
 static VkExtent2D s_ViewportSize{ 1080, 720 };
 
-// TODO: Model managment
-Victory::VulkanModel m_NewModel;
+// Below this many draw batches per thread the viewport records inline
+const static uint32_t s_MinBatchesPerThread{ 256 };
+
+// Frames recorded by the capture button of the profiler panel
+const static uint32_t s_OnDemandTraceFrames{ 120 };
+const static char* s_OnDemandTracePath{ "trace.json" };
+
+// Frames the reported input latency is averaged over
+const static uint32_t s_LatencyHistorySize{ 120 };
+
+// Per frame partition of the uniform ring
+const static VkDeviceSize s_UniformRingFrameSize{ 64 * 1024 };
+
+// The acquire semaphore is waited where the first barrier of the swapchain image waits
+const static Victory::RenderGraphImageState s_AcquiredImageState{
+    VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0 };
+
+// Viewport images are cleared every frame, the previous frame sampled or copied them
+const static Victory::RenderGraphImageState s_ViewportImageState{
+    VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0 };
+
+// Built by the previous frame, the early culling of the next one reads it
+const static Victory::RenderGraphImageState s_DepthPyramidState{
+    VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT };
+
+// Offscreen color format when there is no surface to match
+const static VkFormat s_HeadlessFormat{ VK_FORMAT_R8G8B8A8_SRGB };
 
 struct UniformBufferObject 
 {
-    glm::mat4 model;
     glm::mat4 view;
     glm::mat4 proj;
 };
@@ -51,27 +87,31 @@ namespace Victory
     {
     public:
 
-        ViewportPipeline() {};
+        ViewportPipeline(VulkanScene* scene_, VulkanUniformRing* uniformRing_, 
+            VulkanDeletionQueue* deletionQueue_, VulkanRenderGraph* renderGraph_, uint32_t framesInFlight_) 
+            : m_Scene{ scene_ }, m_UniformRing{ uniformRing_ }, m_DeletionQueue{ deletionQueue_ }, 
+            m_RenderGraph{ renderGraph_ }, m_FramesInFlight{ framesInFlight_ } {};
 
         virtual ~ViewportPipeline() override 
         {
             VkDevice device{ m_VulkanDevice->GetDevice() };
 
-            vkFreeMemory(device, m_UniformBufferMemory, nullptr);
-            vkDestroyBuffer(device, m_UniformBuffer, nullptr);
+            vkDestroyDescriptorPool(device, m_DescriptorPool, nullptr);
+            delete m_ParallelRecorder;
+            delete m_DepthPyramid;
 
             m_FrameBuffer->CleanupAll();
             delete m_FrameBuffer;
 
             vkDestroyPipeline(device, m_Pipeline, nullptr);
             vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
-            vkDestroyPipelineCache(device, m_PipelineCache, nullptr);
             vkDestroyRenderPass(device, m_RenderPass, nullptr);
+            vkDestroyRenderPass(device, m_LateRenderPass, nullptr);
             vkDestroyDescriptorSetLayout(device, m_DescriptorSetLayout, nullptr);
         }
 
         virtual void InitResources(VkFormat format_, VkExtent2D extent_, 
-            const uint32_t frameBuffersCount_) override
+            const uint32_t /*frameBuffersCount_*/) override
         {
             m_FramesImageCI.pNext = nullptr;
             m_FramesImageCI.flags = 0;
@@ -84,27 +124,48 @@ namespace Victory
             m_FramesImageCI.arrayLayers = 1;
             m_FramesImageCI.samples = VK_SAMPLE_COUNT_1_BIT;
             m_FramesImageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-            m_FramesImageCI.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+            m_FramesImageCI.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | 
+                VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
             m_FramesImageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
             m_FramesImageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
+            // Renders offscreen only, so it works the same with or without a swapchain.
+            // One image per frame in flight, independent of the swapchain depth
             m_VulkanDevice = Victory::VulkanDevice::Init();
-            m_VulkanSwapchain = Victory::VulkanSwapchain::Init();
+            m_FrameBuffersCount = m_FramesInFlight;
 
             CreateDescriptorSetLayout();
 
-            CreateRenderPass();
-            CreatePipelineCash();
+            // Occlusion culling renders in an early and a late pass, the early one has to keep
+            // its attachments. The late pass only loads them, both are compatible
+            m_OcclusionCulling = m_Scene->IsOcclusionCulling();
+            CreateRenderPass(VK_ATTACHMENT_LOAD_OP_CLEAR, 
+                m_OcclusionCulling ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE, m_RenderPass);
+            if (m_OcclusionCulling)
+            {
+                CreateRenderPass(VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_DONT_CARE, m_LateRenderPass);
+            }
             CreatePipelineLayout();
             CreatePipeline();
 
-            CreateUniformBuffer();
+            CreateDescriptorSet();
+
+            m_ParallelRecorder = new VulkanParallelRecorder(m_VulkanDevice, 
+                m_FramesInFlight, ThreadPool::Init()->GetThreadCount());
+
+            // cull.comp binds a pyramid even when it does not test against one
+            if (m_Scene->IsGpuDriven())
+            {
+                m_DepthPyramid = new VulkanDepthPyramid(m_VulkanDevice, m_DeletionQueue);
+            }
 
-            CreateFrameBuffers(frameBuffersCount_);
+            // Frame buffers are created once the render graph placed these
+            CreateTransientImages();
         }
 
         virtual VkCommandBuffer BeginFrame(const uint32_t currentFrame_) override 
         {
+            m_CurrentFrame = currentFrame_;
             UpdateUniformBuffer();
 
             VkCommandBufferBeginInfo beginI{};
@@ -116,54 +177,35 @@ namespace Victory
             m_CurrentCommandBuffer = m_FrameBuffer->GetCommandBuffer(currentFrame_);
             vkBeginCommandBuffer(m_CurrentCommandBuffer, &beginI);
 
+            // Secondaries of the early and the late pass come from the same pools
+            m_ParallelRecorder->BeginFrame(m_CurrentFrame);
+
             return m_CurrentCommandBuffer;
         }
 
-        virtual void RecordBuffer(const uint32_t bufferIndex_) override 
+        virtual void RecordBuffer(const uint32_t /*imageIndex_*/) override 
         {
-            std::array<VkClearValue, 2> clearValues{};
-            clearValues[0].color = {{0.f, 0.f, 0.f, 1.f}};
-            clearValues[1].depthStencil = {1.f, 0};
+            m_ImageIndex = m_CurrentFrame;
 
-            VkRenderPassBeginInfo renderPassBI{};
-            renderPassBI.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassBI.pNext = nullptr;
-            renderPassBI.renderPass = m_RenderPass;
-            renderPassBI.framebuffer = m_FrameBuffer->GetFrameBuffer(bufferIndex_);
-            renderPassBI.renderArea.extent.height = m_FramesImageCI.extent.height;
-            renderPassBI.renderArea.extent.width = m_FramesImageCI.extent.width;
-            renderPassBI.renderArea.offset = { 0,0 };
-            renderPassBI.clearValueCount = static_cast<uint32_t>(clearValues.size());
-            renderPassBI.pClearValues = clearValues.data();
-
-            vkCmdBeginRenderPass(m_CurrentCommandBuffer, &renderPassBI, VK_SUBPASS_CONTENTS_INLINE);
-            {
-                vkCmdBindPipeline(m_CurrentCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
-
-                VkViewport viewport{};
-                viewport.x = 0.f;
-                viewport.y = 0.f;
-                viewport.width = static_cast<float>(m_FramesImageCI.extent.width);
-                viewport.height = static_cast<float>(m_FramesImageCI.extent.height);
-                viewport.minDepth = 0.f;
-                viewport.maxDepth = 1.f;
+            // GPU driven scenes cull here, the commands have to be written before the pass reads them
+            m_Scene->PrepareDraws(m_CurrentFrame, m_SceneView);
+            m_Scene->RecordCulling(m_CurrentCommandBuffer, CullPhase::eEarly);
 
-                vkCmdSetViewport(m_CurrentCommandBuffer, 0, 1, &viewport);
-                vkCmdSetScissor(m_CurrentCommandBuffer, 0, 1, &renderPassBI.renderArea);
-
-                {
-                    std::vector<VkDeviceSize> offsets{0};
-                    vkCmdBindVertexBuffers(m_CurrentCommandBuffer, 0, 1, &m_NewModel.GetVertexBuffer(), offsets.data());
-                    vkCmdBindIndexBuffer(m_CurrentCommandBuffer, m_NewModel.GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT16);
+            RecordScene(m_RenderPass, CullPhase::eEarly);
+        }
 
-                    // TODO: descriptor set for every model
-                    vkCmdBindDescriptorSets(m_CurrentCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, 
-                        m_PipelineLayout, 0, 1, &m_NewModel.GetDescriptorSet(), 0, nullptr);
+        // Occlusion culling only, after the depth pyramid was built from the early pass.
+        // Draws what the pyramid of the last frame hid but this one does not
+        void RecordLate()
+        {
+            m_Scene->RecordCulling(m_CurrentCommandBuffer, CullPhase::eLate);
+            RecordScene(m_LateRenderPass, CullPhase::eLate);
+        }
 
-                    vkCmdDrawIndexed(m_CurrentCommandBuffer, static_cast<uint32_t>(m_NewModel.GetIndices().size()), 1, 0, 0, 0);
-                }
-            }
-            vkCmdEndRenderPass(m_CurrentCommandBuffer);
+        // The render graph moved the depth attachment into shader read only layout
+        void RecordDepthPyramid(VkCommandBuffer commandBuffer_) const
+        {
+            m_DepthPyramid->Record(commandBuffer_);
         }
 
         virtual void EndFrame() override 
@@ -173,44 +215,190 @@ namespace Victory
 
         virtual void RecreateResources() override 
         {
-            m_FrameBuffer->CleanupAll();
-            CreateFrameBuffers(m_VulkanSwapchain->GetImageCount());
+            // Frames in flight still render into the old targets
+            VulkanFrameBuffer* retiredFrameBuffer{ m_FrameBuffer };
+            m_DeletionQueue->Push([retiredFrameBuffer]()
+            {
+                retiredFrameBuffer->CleanupAll();
+                delete retiredFrameBuffer;
+            });
+
+            m_RenderGraph->ResizeImage(m_MsaaImage, s_ViewportSize);
+            m_RenderGraph->ResizeImage(m_DepthImage, s_ViewportSize);
+            m_RenderGraph->Compile();
+
+            CreateFrameBuffers(m_FrameBuffersCount);
         };
 
-        VkDescriptorSetLayout GetDescriptorSetLayout() const
+        // The render graph has to be compiled, the attachments are its transient images
+        inline void CreateTargets()
         {
-            return m_DescriptorSetLayout;
+            CreateFrameBuffers(m_FrameBuffersCount);
         }
 
-        VkBuffer GetUniformBuffer() const 
+        const std::vector<VulkanImage>& GetImages() const
         {
-            return m_UniformBuffer;
+            return m_FrameBuffer->GetFrameImages();
         }
 
-        const std::vector<VulkanImage>& GetImages() const
+        inline RenderGraphResource GetMsaaImage() const
         {
-            return m_FrameBuffer->GetFrameImages();
+            return m_MsaaImage;
+        }
+
+        inline RenderGraphResource GetDepthImage() const
+        {
+            return m_DepthImage;
+        }
+
+        inline bool IsOcclusionCulling() const
+        {
+            return m_OcclusionCulling;
+        }
+
+        // Replaced on resize
+        inline VkImage GetDepthPyramidImage() const
+        {
+            return m_DepthPyramid->GetImage();
+        }
+
+        // The next recorded frame copies its color image into buffer_ as tightly packed texels
+        inline void SetReadbackBuffer(VkBuffer buffer_)
+        {
+            m_ReadbackBuffer = buffer_;
+        }
+
+        // The render graph moved the color image into transfer source layout
+        void RecordReadback(VkCommandBuffer commandBuffer_)
+        {
+            if (!m_ReadbackBuffer)
+            {
+                return;
+            }
+
+            VkBufferImageCopy region{};
+            region.bufferOffset = 0;
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = 0;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+            region.imageOffset = { 0, 0, 0 };
+            region.imageExtent = m_FramesImageCI.extent;
+
+            vkCmdCopyImageToBuffer(commandBuffer_, m_FrameBuffer->GetFrameImages()[m_ImageIndex].GetImage(), 
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_ReadbackBuffer, 1, &region);
+
+            // The graph tracks images only, the host read of the buffer is synchronized here
+            VkBufferMemoryBarrier bufferBarrier{};
+            bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+            bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufferBarrier.buffer = m_ReadbackBuffer;
+            bufferBarrier.offset = 0;
+            bufferBarrier.size = VK_WHOLE_SIZE;
+
+            vkCmdPipelineBarrier(commandBuffer_, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 
+                0, nullptr, 1, &bufferBarrier, 0, nullptr);
+
+            m_ReadbackBuffer = VK_NULL_HANDLE;
         }
 
     private:
 
+        void RecordScene(VkRenderPass renderPass_, CullPhase phase_)
+        {
+            std::array<VkClearValue, 2> clearValues{};
+            clearValues[0].color = {{0.f, 0.f, 0.f, 1.f}};
+            clearValues[1].depthStencil = {1.f, 0};
+
+            VkRenderPassBeginInfo renderPassBI{};
+            renderPassBI.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassBI.pNext = nullptr;
+            renderPassBI.renderPass = renderPass_;
+            renderPassBI.framebuffer = m_FrameBuffer->GetFrameBuffer(m_ImageIndex);
+            renderPassBI.renderArea.extent.height = m_FramesImageCI.extent.height;
+            renderPassBI.renderArea.extent.width = m_FramesImageCI.extent.width;
+            renderPassBI.renderArea.offset = { 0,0 };
+            renderPassBI.clearValueCount = static_cast<uint32_t>(clearValues.size());
+            renderPassBI.pClearValues = clearValues.data();
+
+            const uint32_t batchCount{ m_Scene->GetBatchCount() };
+            ThreadPool* threadPool{ ThreadPool::Init() };
+            const uint32_t threadCount{ threadPool->GetThreadCount() };
+            const uint32_t grainSize{ std::max(s_MinBatchesPerThread, (batchCount + threadCount - 1) / threadCount) };
+
+            // Small scenes are not worth the secondary command buffers
+            if (batchCount <= grainSize)
+            {
+                vkCmdBeginRenderPass(m_CurrentCommandBuffer, &renderPassBI, VK_SUBPASS_CONTENTS_INLINE);
+                {
+                    RecordDraws(m_CurrentCommandBuffer, renderPassBI.renderArea, 0, batchCount, phase_);
+                }
+                vkCmdEndRenderPass(m_CurrentCommandBuffer);
+                return;
+            }
+
+            // Every thread records its ranges into secondaries from its own pool,
+            // the primary executes them in batch order
+            m_SecondaryCommandBuffers.assign((batchCount + grainSize - 1) / grainSize, VK_NULL_HANDLE);
+
+            vkCmdBeginRenderPass(m_CurrentCommandBuffer, &renderPassBI, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            {
+                threadPool->ParallelFor(batchCount, grainSize, 
+                    [&](uint32_t begin_, uint32_t end_, uint32_t threadIndex_)
+                {
+                    VICTORY_PROFILE_ZONE("RecordSecondary");
+
+                    VkCommandBuffer commandBuffer{ 
+                        m_ParallelRecorder->Begin(threadIndex_, renderPass_, renderPassBI.framebuffer) };
+                    RecordDraws(commandBuffer, renderPassBI.renderArea, begin_, end_, phase_);
+                    vkEndCommandBuffer(commandBuffer);
+
+                    m_SecondaryCommandBuffers[begin_ / grainSize] = commandBuffer;
+                });
+
+                vkCmdExecuteCommands(m_CurrentCommandBuffer, 
+                    static_cast<uint32_t>(m_SecondaryCommandBuffers.size()), m_SecondaryCommandBuffers.data());
+            }
+            vkCmdEndRenderPass(m_CurrentCommandBuffer);
+        }
+
+        // State is not inherited by secondaries, every command buffer sets all of it
+        void RecordDraws(VkCommandBuffer commandBuffer_, const VkRect2D& renderArea_, 
+            uint32_t begin_, uint32_t end_, CullPhase phase_) const
+        {
+            VkViewport viewport{};
+            viewport.x = 0.f;
+            viewport.y = 0.f;
+            viewport.width = static_cast<float>(renderArea_.extent.width);
+            viewport.height = static_cast<float>(renderArea_.extent.height);
+            viewport.minDepth = 0.f;
+            viewport.maxDepth = 1.f;
+
+            vkCmdSetViewport(commandBuffer_, 0, 1, &viewport);
+            vkCmdSetScissor(commandBuffer_, 0, 1, &renderArea_);
+
+            vkCmdBindDescriptorSets(commandBuffer_, VK_PIPELINE_BIND_POINT_GRAPHICS, 
+                m_PipelineLayout, 0, 1, &m_DescriptorSet, 1, &m_UniformOffset);
+
+            // The scene binds geometry once, pipelines and materials as its sorted batches need them
+            m_Scene->RecordBatches(commandBuffer_, m_PipelineLayout, { &m_Pipeline, 1 }, begin_, end_, phase_);
+        }
+
         void CreateDescriptorSetLayout()
         {
             VkDescriptorSetLayoutBinding uboLayoutBinding{};
             uboLayoutBinding.binding = 0;
-            uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
             uboLayoutBinding.descriptorCount = 1;
             uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
             uboLayoutBinding.pImmutableSamplers = nullptr;
 
-            VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-            samplerLayoutBinding.binding = 1;
-            samplerLayoutBinding.descriptorCount = 1;
-            samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            samplerLayoutBinding.pImmutableSamplers = nullptr;
-            samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-            std::vector<VkDescriptorSetLayoutBinding>  bindings{uboLayoutBinding, samplerLayoutBinding};
+            std::vector<VkDescriptorSetLayoutBinding>  bindings{uboLayoutBinding};
 
             VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCI{};
             descriptorSetLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -225,10 +413,16 @@ namespace Victory
 
         void CreatePipelineLayout() 
         {
+            // Set 0 is per frame, set 1 the instance transforms, set 2 the material
+            const std::vector<VkDescriptorSetLayout> setLayouts{
+                m_DescriptorSetLayout,
+                m_Scene->GetInstanceSetLayout(),
+                m_Scene->GetMaterialSetLayout() };
+
             VkPipelineLayoutCreateInfo pipelineLayoutCI{};
             pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-            pipelineLayoutCI.setLayoutCount = 1;
-            pipelineLayoutCI.pSetLayouts = &m_DescriptorSetLayout;
+            pipelineLayoutCI.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+            pipelineLayoutCI.pSetLayouts = setLayouts.data();
             pipelineLayoutCI.pushConstantRangeCount = 0;
             pipelineLayoutCI.pPushConstantRanges = nullptr;
 
@@ -238,28 +432,29 @@ namespace Victory
                 "Pipeline Layout was not created");
         }
 
-        void CreateRenderPass() 
+        void CreateRenderPass(VkAttachmentLoadOp loadOp_, VkAttachmentStoreOp storeOp_, VkRenderPass& renderPass_) 
         {
             std::vector<VkAttachmentDescription> attachments{ 3 };
             // MSAA Attachment
             attachments[0].flags = 0;
             attachments[0].format = m_FramesImageCI.format;
             attachments[0].samples = m_VulkanDevice->GetMaxSampleCount();
-            attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            attachments[0].loadOp = loadOp_;
+            // Unless a later pass loads them, only the resolve is kept and the samples never leave tile memory
+            attachments[0].storeOp = storeOp_;
             attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
             attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachments[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
             attachments[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
             // Depth Attachment
             attachments[1].flags = 0;
             attachments[1].format = m_VulkanDevice->FindDepthFormat();
             attachments[1].samples = m_VulkanDevice->GetMaxSampleCount();
-            attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachments[1].loadOp = loadOp_;
+            attachments[1].storeOp = storeOp_;
             attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
             attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachments[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
             attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
             // Resolve attachment
             attachments[2].flags = 0;
@@ -269,8 +464,8 @@ namespace Victory
             attachments[2].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
             attachments[2].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
             attachments[2].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            attachments[2].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            attachments[2].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            attachments[2].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            attachments[2].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
             VkAttachmentReference msaaAttachmentRef{};
             msaaAttachmentRef.attachment = 0;
@@ -296,24 +491,6 @@ namespace Victory
             subpassDescriptions[0].preserveAttachmentCount = 0;
             subpassDescriptions[0].pPreserveAttachments = nullptr;
 
-            std::vector<VkSubpassDependency> subpassDependencies{ 2 };
-            // Before Begin Render Pass
-	        subpassDependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-	        subpassDependencies[0].dstSubpass = 0;
-	        subpassDependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-	        subpassDependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	        subpassDependencies[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-	        subpassDependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	        subpassDependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-            // After End Render Pass
-	        subpassDependencies[1].srcSubpass = 0;
-	        subpassDependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-	        subpassDependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	        subpassDependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-	        subpassDependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	        subpassDependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-	        subpassDependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
             VkRenderPassCreateInfo renderPassCI{};
             renderPassCI.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
             renderPassCI.pNext = nullptr;
@@ -322,24 +499,15 @@ namespace Victory
             renderPassCI.pAttachments = attachments.data();
             renderPassCI.subpassCount = static_cast<uint32_t>(subpassDescriptions.size());
             renderPassCI.pSubpasses = subpassDescriptions.data();
-            renderPassCI.dependencyCount = static_cast<uint32_t>(subpassDependencies.size());
-            renderPassCI.pDependencies = subpassDependencies.data();
+            // The render graph transitions the attachments and orders the passes
+            renderPassCI.dependencyCount = 0;
+            renderPassCI.pDependencies = nullptr;
 
             CheckVulkanResult(
-                vkCreateRenderPass(m_VulkanDevice->GetDevice(), &renderPassCI, nullptr, &m_RenderPass),
+                vkCreateRenderPass(m_VulkanDevice->GetDevice(), &renderPassCI, nullptr, &renderPass_),
                 "Render pass was not created");
         }
 
-        void CreatePipelineCash()
-        {
-            VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
-	        pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-            CheckVulkanResult(
-	            vkCreatePipelineCache(m_VulkanDevice->GetDevice(), 
-                    &pipelineCacheCreateInfo, nullptr, &m_PipelineCache),
-                "Pipeline Cash was not created");
-        }
-
         void CreatePipeline()
         {
             const std::vector<char> vsBuffer = Utils::ReadFile("graphics.vert.spv");
@@ -361,8 +529,9 @@ namespace Victory
             vertexShaderStageCIs[1].module = FS;
             vertexShaderStageCIs[1].pName = "main";
 
-            auto&& bindingDescription{ Victory::GetBindingDescription() };
-            auto&& attributegDescriptions{ Victory::GetAttributeDescriptions() };
+            const VertexLayout vertexLayout{ GetPackedVertexLayout() };
+            auto&& bindingDescription{ Victory::GetBindingDescription(vertexLayout) };
+            auto&& attributegDescriptions{ Victory::GetAttributeDescriptions(vertexLayout) };
 
             VkPipelineVertexInputStateCreateInfo vertexInputStateCI{};
             vertexInputStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -476,7 +645,7 @@ namespace Victory
             pipelineCI.basePipelineIndex = -1;
 
             CheckVulkanResult(
-                vkCreateGraphicsPipelines(m_VulkanDevice->GetDevice(), m_PipelineCache, 1, 
+                vkCreateGraphicsPipelines(m_VulkanDevice->GetDevice(), m_VulkanDevice->GetPipelineCache(), 1, 
                     &pipelineCI, nullptr, &m_Pipeline),
                 "Pipeline was not created");
 
@@ -484,23 +653,8 @@ namespace Victory
             vkDestroyShaderModule(m_VulkanDevice->GetDevice(), VS, nullptr);
         }
 
-        void CreateFrameBuffers(const uint32_t frameBuffersCount)
+        void CreateTransientImages()
         {
-            m_FrameBuffer = new VulkanFrameBuffer(m_VulkanDevice);
-
-            m_FramesImageCI.extent.width = s_ViewportSize.width;
-            m_FramesImageCI.extent.height = s_ViewportSize.height;
-
-            // Color Images
-            m_FrameBuffer->CreateFrameBufferImages(m_FramesImageCI, frameBuffersCount);
-
-            auto&& images{ m_FrameBuffer->GetFrameImages() };
-            for (auto&& image : images)
-            {
-                image.TransitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-            }
-
-            // Depth Image
             VkImageCreateInfo depthImageCI{};
             depthImageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
             depthImageCI.pNext = nullptr;
@@ -514,99 +668,149 @@ namespace Victory
             depthImageCI.arrayLayers = 1;
             depthImageCI.samples = m_VulkanDevice->GetMaxSampleCount();
             depthImageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-            depthImageCI.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            // Both attachments live within the render pass only, see the store ops. With occlusion
+            // culling they outlive the early pass and the depth pyramid is built from the depth
+            depthImageCI.usage = m_OcclusionCulling ? 
+                VkImageUsageFlags{ VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT } :
+                VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
             depthImageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
             depthImageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-            // MSAA
-            VkImageCreateInfo msaaImageCI{};
-            msaaImageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-            msaaImageCI.pNext = nullptr;
-            msaaImageCI.flags = 0;
-            msaaImageCI.imageType = VK_IMAGE_TYPE_2D;
-            msaaImageCI.format = m_VulkanSwapchain->GetSurfaceFormat().format;
-            msaaImageCI.extent.depth = 1;
-            msaaImageCI.extent.height = s_ViewportSize.height;
-            msaaImageCI.extent.width = s_ViewportSize.width;
-            msaaImageCI.mipLevels = 1;
-            msaaImageCI.arrayLayers = 1;
-            msaaImageCI.samples = m_VulkanDevice->GetMaxSampleCount();
-            msaaImageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-            msaaImageCI.usage = VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-            msaaImageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-            msaaImageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            VkImageCreateInfo msaaImageCI{ depthImageCI };
+            msaaImageCI.format = m_FramesImageCI.format;
+            msaaImageCI.usage = m_OcclusionCulling ? VkImageUsageFlags{ VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT } :
+                VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+            m_MsaaImage = m_RenderGraph->CreateImage("ViewportMsaa", msaaImageCI, VK_IMAGE_ASPECT_COLOR_BIT);
+            m_DepthImage = m_RenderGraph->CreateImage("ViewportDepth", depthImageCI, VK_IMAGE_ASPECT_DEPTH_BIT);
+        }
+
+        void CreateFrameBuffers(const uint32_t frameBuffersCount)
+        {
+            m_FrameBuffer = new VulkanFrameBuffer(m_VulkanDevice);
 
+            m_FramesImageCI.extent.width = s_ViewportSize.width;
+            m_FramesImageCI.extent.height = s_ViewportSize.height;
+
+            // Color Images, the render graph moves them between the passes
+            m_FrameBuffer->CreateFrameBufferImages(m_FramesImageCI, frameBuffersCount);
+
+            // The render graph owns the images, the frame buffer only their views
             std::vector<VulkanImage> attachments(2, VulkanImage(m_VulkanDevice));
-            attachments[0].CreateImage(msaaImageCI, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-            attachments[0].CreateImageView(msaaImageCI.format, VK_IMAGE_ASPECT_COLOR_BIT);
-            attachments[1].CreateImage(depthImageCI, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-            attachments[1].CreateImageView(depthImageCI.format, VK_IMAGE_ASPECT_DEPTH_BIT);
+            attachments[0].SetImage(m_RenderGraph->GetImage(m_MsaaImage));
+            attachments[0].CreateImageView(m_FramesImageCI.format, VK_IMAGE_ASPECT_COLOR_BIT);
+            attachments[1].SetImage(m_RenderGraph->GetImage(m_DepthImage));
+            attachments[1].CreateImageView(m_VulkanDevice->FindDepthFormat(), VK_IMAGE_ASPECT_DEPTH_BIT);
 
             m_FrameBuffer->SetAttachments(attachments);
 
             m_FrameBuffer->CreateCommandPool(QueueIndex::eGraphics);
             m_FrameBuffer->CreateFrameBuffers(m_RenderPass, s_ViewportSize);
             m_FrameBuffer->CreateCommandBuffers();
+
+            // Without occlusion culling a 1x1 pyramid that is never built is enough
+            if (m_DepthPyramid)
+            {
+                m_DepthPyramid->Create(m_OcclusionCulling ? s_ViewportSize : VkExtent2D{ 1, 1 },
+                    m_OcclusionCulling ? attachments[1].GetImageView() : VK_NULL_HANDLE);
+                m_Scene->SetDepthPyramid(m_DepthPyramid->GetView(), m_DepthPyramid->GetSampler(), s_ViewportSize);
+            }
         }
 
-        void CreateUniformBuffer() 
+        void CreateDescriptorSet()
         {
-            VkDeviceSize bufferSize = static_cast<uint64_t>(sizeof(UniformBufferObject));
-
-            VkDevice device{ m_VulkanDevice->GetDevice() };
-
-            VkBufferCreateInfo bufferCI{};
-            bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-            bufferCI.size = bufferSize;
-            bufferCI.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-            bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            VkDescriptorPoolSize poolSize{};
+            poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            poolSize.descriptorCount = 1;
 
-            vkCreateBuffer(device, &bufferCI, nullptr, &m_UniformBuffer);
+            VkDescriptorPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            poolInfo.flags = 0;
+            poolInfo.poolSizeCount = 1;
+            poolInfo.pPoolSizes = &poolSize;
+            poolInfo.maxSets = 1;
 
-            VkMemoryRequirements memRequirements{};
-            vkGetBufferMemoryRequirements(device, m_UniformBuffer, &memRequirements);
-
-            VkMemoryAllocateInfo allocInfo{};
-            allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            allocInfo.allocationSize = memRequirements.size;
-            allocInfo.memoryTypeIndex = m_VulkanDevice->FindMemoryType(memRequirements.memoryTypeBits, 
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-            vkAllocateMemory(device, &allocInfo, nullptr, &m_UniformBufferMemory);
+            CheckVulkanResult(
+                vkCreateDescriptorPool(m_VulkanDevice->GetDevice(), &poolInfo, nullptr, &m_DescriptorPool),
+                "Descriptor Pool was not created");
 
-            vkBindBufferMemory(device, m_UniformBuffer, m_UniformBufferMemory, 0);
+            VkDescriptorSetAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            allocInfo.descriptorPool = m_DescriptorPool;
+            allocInfo.descriptorSetCount = 1;
+            allocInfo.pSetLayouts = &m_DescriptorSetLayout;
 
-            vkMapMemory(device, m_UniformBufferMemory, 0, bufferSize, 0, &m_UniformBufferMapped);
+            CheckVulkanResult(
+                vkAllocateDescriptorSets(m_VulkanDevice->GetDevice(), &allocInfo, &m_DescriptorSet),
+                "Descriptor Set was not allocated");
+
+            // Written once, every frame selects its data with a dynamic offset into the ring
+            VkDescriptorBufferInfo bufferInfo{};
+            bufferInfo.buffer = m_UniformRing->GetBuffer();
+            bufferInfo.offset = 0;
+            bufferInfo.range = sizeof(UniformBufferObject);
+
+            VkWriteDescriptorSet descriptorWrite{};
+            descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrite.dstSet = m_DescriptorSet;
+            descriptorWrite.dstBinding = 0;
+            descriptorWrite.dstArrayElement = 0;
+            descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            descriptorWrite.descriptorCount = 1;
+            descriptorWrite.pBufferInfo = &bufferInfo;
+
+            vkUpdateDescriptorSets(m_VulkanDevice->GetDevice(), 1, &descriptorWrite, 0, nullptr);
         }
 
         void UpdateUniformBuffer() 
         {
-            static auto startTime = std::chrono::high_resolution_clock::now();
-
-            auto currentTime = std::chrono::high_resolution_clock::now();
-            float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
-
             UniformBufferObject ubo{};
-            ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(10.0f), glm::vec3(0.f, 0.f, 1.f));
             ubo.view = glm::lookAt(glm::vec3(2.f, 2.f, 2.f), glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 0.f, 1.f));
             ubo.proj = glm::perspective(glm::radians(45.0f), 
                 m_FramesImageCI.extent.width / static_cast<float>(m_FramesImageCI.extent.height), 0.1f, 10.0f);
             ubo.proj[1][1] *= -1;
 
-            memcpy(m_UniformBufferMapped, &ubo, sizeof(ubo));
+            m_UniformOffset = m_UniformRing->Push(ubo);
+            m_SceneView = SceneView{ ubo.view, ubo.proj, m_FramesImageCI.extent.height };
         }
     
     private:
 
-        VkBuffer m_UniformBuffer;
-        VkDeviceMemory m_UniformBufferMemory;
-        void* m_UniformBufferMapped;
+        VulkanScene* m_Scene;
+        VulkanUniformRing* m_UniformRing;
+        VulkanDeletionQueue* m_DeletionQueue;
+        VulkanRenderGraph* m_RenderGraph;
+        uint32_t m_FramesInFlight{ 0 };
+        uint32_t m_FrameBuffersCount{ 0 };
+        uint32_t m_CurrentFrame{ 0 };
+        uint32_t m_ImageIndex{ 0 };
+
+        VkBuffer m_ReadbackBuffer{ VK_NULL_HANDLE };
+
+        RenderGraphResource m_MsaaImage{ 0 };
+        RenderGraphResource m_DepthImage{ 0 };
+
+        bool m_OcclusionCulling{ false };
+        VkRenderPass m_LateRenderPass{ VK_NULL_HANDLE };
+        VulkanDepthPyramid* m_DepthPyramid{ nullptr };
+
+        VulkanParallelRecorder* m_ParallelRecorder{ nullptr };
+        std::vector<VkCommandBuffer> m_SecondaryCommandBuffers;
+
+        uint32_t m_UniformOffset{ 0 };
+        // Of the uniforms pushed this frame, culling uses the same frustum the shaders see
+        SceneView m_SceneView{ glm::mat4{ 1.f }, glm::mat4{ 1.f }, 1 };
+
+        VkDescriptorPool m_DescriptorPool{ VK_NULL_HANDLE };
+        VkDescriptorSet m_DescriptorSet{ VK_NULL_HANDLE };
     };
 
     class ImGuiPipeline : public VulkanGraphicsPipeline
     {
     public:
-        ImGuiPipeline() {};
+        ImGuiPipeline(VulkanGpuProfiler* gpuProfiler_, VulkanDeletionQueue* deletionQueue_, 
+            const FrameLatency* latency_) 
+            : m_GpuProfiler{ gpuProfiler_ }, m_DeletionQueue{ deletionQueue_ }, m_Latency{ latency_ } {};
         virtual ~ImGuiPipeline() 
         {
             // CleanupDescriptorSets();
@@ -646,6 +850,8 @@ namespace Victory
 
         virtual VkCommandBuffer BeginFrame(const uint32_t currentFrame_)
         {
+            VICTORY_PROFILE_ZONE("ImGuiPipeline::BeginFrame");
+
             ImGui_ImplVulkan_NewFrame();
             ImGui_ImplGlfw_NewFrame();
 
@@ -699,6 +905,8 @@ namespace Victory
                     ImGui::Image(m_DescriptorSets[currentFrame_], ImVec2{ viewportPanelSize.x, viewportPanelSize.y });
                 }
 		        ImGui::End();
+
+                DrawGpuProfiler();
             }
             ImGui::Render();
             if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
@@ -745,10 +953,23 @@ namespace Victory
 
         virtual void RecreateResources()
         {
-            m_FrameBuffer->CleanupAll();
+            // Views of the retired swapchain images, frames in flight may still draw into them
+            VulkanFrameBuffer* retiredFrameBuffer{ m_FrameBuffer };
+            m_DeletionQueue->Push([retiredFrameBuffer]()
+            {
+                retiredFrameBuffer->CleanupAll();
+                delete retiredFrameBuffer;
+            });
+
             CreateFrameBuffers();
         }
 
+        // The swapchain images, indexed like the acquired image
+        const std::vector<VulkanImage>& GetImages() const
+        {
+            return m_FrameBuffer->GetFrameImages();
+        }
+
         void InitDescriptorSets(const std::vector<VulkanImage>& images_, bool needCreateSampler = false) 
         {
             if (needCreateSampler)
@@ -756,6 +977,16 @@ namespace Victory
                 CreateSampler();
             }
 
+            // The previous sets may still be bound by frames in flight
+            if (!m_DescriptorSets.empty())
+            {
+                m_DeletionQueue->Push([device = m_VulkanDevice->GetDevice(), pool = m_DescriptorPool, 
+                    sets = m_DescriptorSets]()
+                {
+                    vkFreeDescriptorSets(device, pool, static_cast<uint32_t>(sets.size()), sets.data());
+                });
+            }
+
             const size_t imageCount = images_.size();
             m_DescriptorSets.resize(imageCount);
             for (size_t i{ 0 }; i < imageCount; ++i) 
@@ -777,6 +1008,54 @@ namespace Victory
 
     private:
 
+        void DrawGpuProfiler()
+        {
+            ImGui::Begin("GPU Profiler");
+            {
+                ImGui::Text("Input to GPU complete: %.2f ms, avg %.2f ms, max %.2f ms, %u frames in flight", 
+                    m_Latency->lastMs, m_Latency->averageMs, m_Latency->maxMs, m_Latency->framesInFlight);
+
+                if (ImGui::Button("Capture CPU trace"))
+                {
+                    Profiler::Init()->RequestCapture(s_OnDemandTraceFrames, s_OnDemandTracePath);
+                }
+
+                if (!m_GpuProfiler->IsSupported())
+                {
+                    ImGui::Text("The graphics queue does not support timestamps");
+                }
+                else if (ImGui::BeginTable("GpuPasses", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+                {
+                    ImGui::TableSetupColumn("Pass");
+                    ImGui::TableSetupColumn("Last, ms");
+                    ImGui::TableSetupColumn("Avg, ms");
+                    ImGui::TableSetupColumn("P50, ms");
+                    ImGui::TableSetupColumn("P95, ms");
+                    ImGui::TableSetupColumn("P99, ms");
+                    ImGui::TableHeadersRow();
+
+                    for (auto&& pass : m_GpuProfiler->GetStats())
+                    {
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%s", pass.name.c_str());
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.3f", pass.lastMs);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.3f", pass.averageMs);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.3f", pass.p50Ms);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.3f", pass.p95Ms);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.3f", pass.p99Ms);
+                    }
+                    ImGui::EndTable();
+                }
+            }
+            ImGui::End();
+        }
+
         void CreateSampler() 
         {
             VkSamplerCreateInfo samplerInfo{};
@@ -826,7 +1105,7 @@ namespace Victory
             info.Device = m_VulkanDevice->GetDevice();
             info.QueueFamily = m_VulkanDevice->GetQueueIndex(QueueIndex::eGraphics);
             m_VulkanDevice->GetQueue(info.Queue, QueueIndex::eGraphics);
-            info.PipelineCache = 0;
+            info.PipelineCache = m_VulkanDevice->GetPipelineCache();
             info.DescriptorPool = m_DescriptorPool;
             info.Subpass = 0;
             info.MinImageCount = minImageCount_;
@@ -847,8 +1126,8 @@ namespace Victory
             attachmets[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
             attachmets[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
             attachmets[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            attachmets[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            attachmets[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            attachmets[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            attachmets[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
             VkAttachmentReference colorAttachmentRef{};
             colorAttachmentRef.attachment = 0;
@@ -859,22 +1138,14 @@ namespace Victory
 	        subpass.colorAttachmentCount = 1;
 	        subpass.pColorAttachments = &colorAttachmentRef;
 
-	        VkSubpassDependency dependency = {};
-	        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-	        dependency.dstSubpass = 0;
-	        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	        dependency.srcAccessMask = 0;
-	        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
 	        VkRenderPassCreateInfo info = {};
 	        info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 	        info.attachmentCount = static_cast<uint32_t>(attachmets.size());
 	        info.pAttachments = attachmets.data();
 	        info.subpassCount = 1;
 	        info.pSubpasses = &subpass;
-	        info.dependencyCount = 1;
-	        info.pDependencies = &dependency;
+	        info.dependencyCount = 0;
+	        info.pDependencies = nullptr;
 
             CheckVulkanResult(
 	            vkCreateRenderPass(m_VulkanDevice->GetDevice(), &info, nullptr, &m_RenderPass),
@@ -1096,7 +1367,7 @@ namespace Victory
             pipelineCI.basePipelineIndex = -1;
 
             CheckVulkanResult(
-                vkCreateGraphicsPipelines(m_VulkanDevice->GetDevice(), nullptr, 1, 
+                vkCreateGraphicsPipelines(m_VulkanDevice->GetDevice(), m_VulkanDevice->GetPipelineCache(), 1, 
                     &pipelineCI, nullptr, &m_Pipeline), 
                 "Pipeline was not created");
 
@@ -1125,6 +1396,9 @@ namespace Victory
     private:
 
         GLFWwindow* m_Window;
+        VulkanGpuProfiler* m_GpuProfiler;
+        VulkanDeletionQueue* m_DeletionQueue;
+        const FrameLatency* m_Latency;
 
         VkDescriptorPool m_DescriptorPool;
         std::vector<VkDescriptorSet> m_DescriptorSets;
@@ -1144,67 +1418,95 @@ Renderer* VulkanRenderer::CreateRenderer()
 void OnWindowResize(GLFWwindow *window_, int width_, int height_);
 void OnWindowClose(GLFWwindow *window_);
 
-void VulkanRenderer::Initialize(const char* applicationName_) 
+void VulkanRenderer::Initialize(const char* applicationName_, const RendererSpecification& specification_) 
 {
-        m_Window = Victory::Window::Init(this);
-        Victory::Window::SetResizeCallback(OnWindowResize);
-        Victory::Window::SetCloseCallback(OnWindowClose);
+        m_Headless = specification_.Headless;
+        ConfigurePacing(specification_);
 
         m_VulkanDevice = Victory::VulkanDevice::Init();
-        m_VulkanDevice->CreateInstance(applicationName_);
-        m_VulkanSwapchain = Victory::VulkanSwapchain::Init(m_VulkanDevice, m_Window);
-        m_VulkanSwapchain->CreateSurface();
-        m_VulkanDevice->PickPhysicalDevice(m_VulkanSwapchain->GetSurface());
-        m_VulkanDevice->CreateLogicalDevice();
-        m_VulkanSwapchain->CreateSwapchain();
+
+        if (m_Headless)
+        {
+            m_VulkanDevice->CreateInstance(applicationName_, true);
+            m_VulkanDevice->PickPhysicalDevice(VK_NULL_HANDLE);
+            m_VulkanDevice->CreateLogicalDevice();
+        }
+        else
+        {
+            m_Window = Victory::Window::Init(this);
+            Victory::Window::SetResizeCallback(OnWindowResize);
+            Victory::Window::SetCloseCallback(OnWindowClose);
+
+            m_VulkanDevice->CreateInstance(applicationName_);
+            m_VulkanSwapchain = Victory::VulkanSwapchain::Init(m_VulkanDevice, m_Window);
+            m_VulkanSwapchain->CreateSurface();
+            m_VulkanDevice->PickPhysicalDevice(m_VulkanSwapchain->GetSurface());
+            m_VulkanDevice->CreateLogicalDevice();
+            m_VulkanSwapchain->SetRequestedImageCount(m_SwapchainImageCount);
+            m_VulkanSwapchain->CreateSwapchain();
+        }
 
         CreateSemaphores();
 
+        m_GpuProfiler = new Victory::VulkanGpuProfiler(m_VulkanDevice, m_MaxImageInFight);
+        m_Scene = new Victory::VulkanScene(m_VulkanDevice, m_MaxImageInFight, specification_.OcclusionCulling,
+            specification_.LodErrorPixels);
+        m_UniformRing = new Victory::VulkanUniformRing(m_VulkanDevice, m_MaxImageInFight, s_UniformRingFrameSize);
+        m_DeletionQueue = new Victory::VulkanDeletionQueue(m_MaxImageInFight);
+        m_RenderGraph = new Victory::VulkanRenderGraph(m_VulkanDevice, m_DeletionQueue);
+
         // TODO: Map where key is enum like Viewport, ImGui, etc.
-        Victory::ImGuiPipeline* ImGuiPipeline{ new Victory::ImGuiPipeline() };
-        Victory::ViewportPipeline* ViewportPipeline{ new Victory::ViewportPipeline() };
-        m_Pipelines["ImGui"] = ImGuiPipeline;
+        Victory::ViewportPipeline* ViewportPipeline{ new Victory::ViewportPipeline(m_Scene, m_UniformRing, 
+            m_DeletionQueue, m_RenderGraph, m_MaxImageInFight) };
         m_Pipelines["Viewport"] = ViewportPipeline;
 
-        for (auto&& pipeline : m_Pipelines)
+        if (m_Headless)
         {
-            pipeline.second->InitResources(m_VulkanSwapchain->GetSurfaceFormat().format, 
-                m_VulkanSwapchain->GetExtent(), m_VulkanSwapchain->GetImageCount());
+            // One offscreen image per frame in flight, nothing is presented
+            s_ViewportSize = { specification_.Width, specification_.Height };
+            ViewportPipeline->InitResources(s_HeadlessFormat, s_ViewportSize, m_MaxImageInFight);
+
+            m_HeadlessFrameCount = specification_.FrameCount;
+            if (specification_.OutputPath)
+            {
+                m_OutputPath = specification_.OutputPath;
+                CreateReadbackBuffer();
+            }
+
+            BuildRenderGraph();
+            ViewportPipeline->CreateTargets();
         }
+        else
+        {
+            Victory::ImGuiPipeline* ImGuiPipeline{ new Victory::ImGuiPipeline(m_GpuProfiler, m_DeletionQueue, &m_Latency) };
+            m_Pipelines["ImGui"] = ImGuiPipeline;
 
-        ImGuiPipeline->InitDescriptorSets(ViewportPipeline->GetImages(), true);
-
-        VkImageCreateInfo imageCI{};
-        imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-        imageCI.pNext = nullptr;
-        imageCI.flags = 0;
-        imageCI.imageType = VK_IMAGE_TYPE_2D;
-        imageCI.format = VK_FORMAT_R8G8B8A8_UNORM;
-        imageCI.extent.width;
-        imageCI.extent.height;
-        imageCI.extent.depth = 1;
-        imageCI.mipLevels = 1;
-        imageCI.arrayLayers = 1;
-        imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
-        imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-        imageCI.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-        imageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        // imageCI.queueFamilyIndexCount = 1;
-        // imageCI.pQueueFamilyIndices = &s_QueueIndex;
-        imageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            for (auto&& pipeline : m_Pipelines)
+            {
+                pipeline.second->InitResources(m_VulkanSwapchain->GetSurfaceFormat().format, 
+                    m_VulkanSwapchain->GetExtent(), m_VulkanSwapchain->GetImageCount());
+            }
+
+            BuildRenderGraph();
+            ViewportPipeline->CreateTargets();
+            ImGuiPipeline->InitDescriptorSets(ViewportPipeline->GetImages(), true);
+        }
 
         {
-            const std::string obj{ "viking_room.obj" };
-            const std::string png{ "viking_room.png" };
-            m_NewModel.LoadModel(obj);
-            m_NewModel.LoadTexture(png, imageCI);
+            const Victory::MeshHandle mesh{ m_Scene->LoadMesh("viking_room.obj", specification_.MeshLodCount) };
+            const Victory::MaterialHandle material{ m_Scene->LoadMaterial("viking_room.png") };
+            m_RoomObject = m_Scene->CreateObject(mesh, material);
         }
 
-        VkDescriptorBufferInfo bufferInfo{};
-        bufferInfo.buffer = ViewportPipeline->GetUniformBuffer();
-        bufferInfo.offset = 0;
-        bufferInfo.range = sizeof(UniformBufferObject);
-        m_NewModel.CreateDescriptors(ViewportPipeline->GetDescriptorSetLayout(), bufferInfo);
+        // Geometry, textures and mip generation go out as one batch
+        m_VulkanDevice->GetUploadContext()->Submit();
+
+        if (m_Headless)
+        {
+            // Every frame, the first included, renders the complete scene
+            m_VulkanDevice->GetUploadContext()->WaitIdle();
+            m_HeadlessStartTime = std::chrono::steady_clock::now();
+        }
 }
 
 bool VulkanRenderer::IsRunning() 
@@ -1214,16 +1516,48 @@ bool VulkanRenderer::IsRunning()
 
 void VulkanRenderer::PollEvents() 
 {
-    Victory::Window::PollEvents();
+    if (m_Pacing == FramePacing::eLowLatency)
+    {
+        // Nothing is queued when input is sampled, so it is shown as soon as possible
+        VICTORY_PROFILE_ZONE("WaitForPreviousFrame");
+
+        const uint32_t previousFrame{ (m_CurrentFrame + m_MaxImageInFight - 1) % m_MaxImageInFight };
+        vkWaitForFences(m_VulkanDevice->GetDevice(), 1, &m_QueueSubmitFence[previousFrame], VK_TRUE, UINT64_MAX);
+    }
+    CollectLatency();
+
+    if (!m_Headless)
+    {
+        Victory::Window::PollEvents();
+    }
+    m_InputTime = std::chrono::steady_clock::now();
 }
 
 bool VulkanRenderer::Resize() 
 {
+    VICTORY_PROFILE_ZONE("VulkanRenderer::Resize");
+
     VkDevice device{ m_VulkanDevice->GetDevice() };
-    vkWaitForFences(device, 1, &m_QueueSubmitFence[m_CurrentFrame], VK_TRUE, UINT64_MAX);
+    {
+        VICTORY_PROFILE_ZONE("WaitForFences");
+        vkWaitForFences(device, 1, &m_QueueSubmitFence[m_CurrentFrame], VK_TRUE, UINT64_MAX);
+    }
+    m_DeletionQueue->BeginFrame();
+    CollectLatency();
+
+    // The offscreen images never change size and are indexed by frame
+    if (m_Headless)
+    {
+        m_ImageIndex = m_CurrentFrame;
+        return false;
+    }
 
-    VkResult acquireResult = vkAcquireNextImageKHR(device, m_VulkanSwapchain->GetSwapchain(), UINT64_MAX, 
-        m_ImageAvailableSemaphore[m_CurrentFrame], VK_NULL_HANDLE, &m_ImageIndex);
+    VkResult acquireResult{ VK_SUCCESS };
+    {
+        VICTORY_PROFILE_ZONE("AcquireNextImage");
+        acquireResult = vkAcquireNextImageKHR(device, m_VulkanSwapchain->GetSwapchain(), UINT64_MAX, 
+            m_ImageAvailableSemaphore[m_CurrentFrame], VK_NULL_HANDLE, &m_ImageIndex);
+    }
 
     // TODO: Get rid of static cast
     Victory::ImGuiPipeline* ImGuiPipeline{ static_cast<Victory::ImGuiPipeline*>(m_Pipelines["ImGui"]) };
@@ -1237,7 +1571,15 @@ bool VulkanRenderer::Resize()
         {
             Victory::Window::WaitEvents();
         }
-        m_VulkanSwapchain->RecreateSwapchain();
+
+        // Nothing idles the device, everything replaced is retired until the frames
+        // in flight that may use it completed
+        const VkSwapchainKHR oldSwapchain{ m_VulkanSwapchain->RecreateSwapchain() };
+        m_DeletionQueue->Push([device, oldSwapchain]()
+        {
+            vkDestroySwapchainKHR(device, oldSwapchain, nullptr);
+        });
+
         for (auto&& pipeline : m_Pipelines)
         {
             pipeline.second->RecreateResources();
@@ -1246,7 +1588,12 @@ bool VulkanRenderer::Resize()
         ImGuiPipeline->SetNeedResize(false);
         ImGuiPipeline->InitDescriptorSets(ViewportPipeline->GetImages());
 
-        vkDestroySemaphore(device, m_ImageAvailableSemaphore[m_CurrentFrame], nullptr);
+        // A suboptimal acquire still signals the semaphore, it can not be reused before that
+        const VkSemaphore oldSemaphore{ m_ImageAvailableSemaphore[m_CurrentFrame] };
+        m_DeletionQueue->Push([device, oldSemaphore]()
+        {
+            vkDestroySemaphore(device, oldSemaphore, nullptr);
+        });
 
         VkSemaphoreCreateInfo semaphoreCI{};
         semaphoreCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -1256,7 +1603,6 @@ bool VulkanRenderer::Resize()
 
     if (ImGuiPipeline->GetNeedResize())
     {
-        vkDeviceWaitIdle(device);
         ViewportPipeline->RecreateResources();
         ImGuiPipeline->SetNeedResize(false);
         ImGuiPipeline->InitDescriptorSets(ViewportPipeline->GetImages());
@@ -1266,24 +1612,58 @@ bool VulkanRenderer::Resize()
 }
 
 void VulkanRenderer::BeginFrame() {
+    static auto startTime = std::chrono::high_resolution_clock::now();
+
+    auto currentTime = std::chrono::high_resolution_clock::now();
+    float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+
+    m_Scene->SetTransform(m_RoomObject, 
+        glm::rotate(glm::mat4(1.0f), time * glm::radians(10.0f), glm::vec3(0.f, 0.f, 1.f)));
 }
 
 void VulkanRenderer::RecordCommandBuffer() {
+    VICTORY_PROFILE_ZONE("VulkanRenderer::RecordCommandBuffer");
+
     vkResetFences(m_VulkanDevice->GetDevice(), 1, &m_QueueSubmitFence[m_CurrentFrame]);
 
-    m_CommandBuffers.clear();
-    m_CommandBuffers.reserve(m_Pipelines.size());
-    for (auto&& pipeline : m_Pipelines)
+    if (m_ReadbackBuffer && m_RenderedFrames + 1 == m_HeadlessFrameCount)
+    {
+        static_cast<Victory::ViewportPipeline*>(m_Pipelines["Viewport"])->SetReadbackBuffer(m_ReadbackBuffer);
+    }
+
+    // The fence of this frame was waited, so its timestamps are ready to collect
+    // and its uniform partition is free to overwrite
+    m_GpuProfiler->BeginFrame(m_CurrentFrame);
+    m_UniformRing->BeginFrame(m_CurrentFrame);
+
+    Victory::ViewportPipeline* ViewportPipeline{ static_cast<Victory::ViewportPipeline*>(m_Pipelines["Viewport"]) };
+    m_RenderGraph->SetImage(m_ViewportColorImage, ViewportPipeline->GetImages()[m_CurrentFrame].GetImage());
+    if (ViewportPipeline->IsOcclusionCulling())
+    {
+        m_RenderGraph->SetImage(m_DepthPyramidImage, ViewportPipeline->GetDepthPyramidImage());
+    }
+    if (!m_Headless)
     {
-        m_CommandBuffers.emplace_back(pipeline.second->BeginFrame(m_CurrentFrame));
-        pipeline.second->RecordBuffer(m_ImageIndex);
-        pipeline.second->EndFrame();
+        m_RenderGraph->SetImage(m_BackbufferImage, static_cast<Victory::ImGuiPipeline*>(
+            m_Pipelines["ImGui"])->GetImages()[m_ImageIndex].GetImage());
     }
+
+    m_CommandBuffers.clear();
+    m_RenderGraph->Execute(m_CurrentFrame, m_CommandBuffers);
 }
 
 void VulkanRenderer::EndFrame() 
 {
-    VkPipelineStageFlags waitFlag{ VK_PIPELINE_STAGE_TRANSFER_BIT };
+    VICTORY_PROFILE_ZONE("VulkanRenderer::EndFrame");
+
+    if (m_Headless)
+    {
+        EndHeadlessFrame();
+        return;
+    }
+
+    // Only the first write of the swapchain image has to wait for the acquire
+    VkPipelineStageFlags waitFlag{ s_AcquiredImageState.stages };
     VkSubmitInfo submitI{};
     submitI.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submitI.pNext = nullptr;
@@ -1297,7 +1677,10 @@ void VulkanRenderer::EndFrame()
 
     VkQueue queue;
     m_VulkanDevice->GetQueue(queue, Victory::QueueIndex::eGraphics);
-    vkQueueSubmit(queue, 1, &submitI, m_QueueSubmitFence[m_CurrentFrame]);
+    {
+        VICTORY_PROFILE_ZONE("QueueSubmit");
+        vkQueueSubmit(queue, 1, &submitI, m_QueueSubmitFence[m_CurrentFrame]);
+    }
 
     const std::vector<VkSwapchainKHR> swapOld{m_VulkanSwapchain->GetSwapchain()};
     VkPresentInfoKHR presentI{};
@@ -1310,7 +1693,12 @@ void VulkanRenderer::EndFrame()
     presentI.pImageIndices = &m_ImageIndex;
     presentI.pResults = nullptr;
 
-    vkQueuePresentKHR(queue, &presentI);
+    {
+        VICTORY_PROFILE_ZONE("QueuePresent");
+        vkQueuePresentKHR(queue, &presentI);
+    }
+    MarkFrameSubmitted();
+    m_DeletionQueue->EndFrame();
 
     m_CurrentFrame = (m_CurrentFrame + 1) % m_MaxImageInFight;
 }
@@ -1319,18 +1707,287 @@ void VulkanRenderer::Destroy()
 {
     vkDeviceWaitIdle(m_VulkanDevice->GetDevice());
 
+    // Retired resources may belong to the pipelines and the swapchain destroyed below
+    delete m_DeletionQueue;
+
     for (auto&& pipeline : m_Pipelines)
     {
         delete pipeline.second;
     }
 
+    // After the frame buffers, they hold views of its transient images
+    m_RenderGraph->PrintStats();
+    delete m_RenderGraph;
+
     CleanupSemaphores();
-    m_NewModel.CleanupAll();
+    m_Scene->CleanupAll();
+    delete m_Scene;
+    delete m_UniformRing;
+    delete m_GpuProfiler;
+
+    if (m_ReadbackBuffer)
+    {
+        m_VulkanDevice->GetAllocator()->DestroyBuffer(m_ReadbackBuffer, m_ReadbackMemory);
+    }
+
+    if (m_Headless)
+    {
+        Victory::VulkanDevice::Cleanup();
+        return;
+    }
+
     Victory::VulkanSwapchain::Cleanup();
     Victory::VulkanDevice::Cleanup();
     Victory::Window::Cleanup();
 }
 
+void VulkanRenderer::BuildRenderGraph() 
+{
+    Victory::ViewportPipeline* ViewportPipeline{ static_cast<Victory::ViewportPipeline*>(m_Pipelines["Viewport"]) };
+
+    m_ViewportColorImage = m_RenderGraph->ImportImage("ViewportColor", 
+        VK_IMAGE_ASPECT_COLOR_BIT, s_ViewportImageState);
+
+    const Victory::RenderGraphPass viewportPass{ m_RenderGraph->AddPass("Viewport", ViewportPipeline, 
+        [this, ViewportPipeline](VkCommandBuffer commandBuffer_)
+        {
+            m_GpuProfiler->BeginScope(commandBuffer_, "Viewport");
+            ViewportPipeline->RecordBuffer(m_ImageIndex);
+            m_GpuProfiler->EndScope(commandBuffer_);
+        }) };
+    m_RenderGraph->Write(viewportPass, ViewportPipeline->GetMsaaImage(), Victory::RenderGraphUsage::eColorAttachment);
+    m_RenderGraph->Write(viewportPass, ViewportPipeline->GetDepthImage(), Victory::RenderGraphUsage::eDepthAttachment);
+    m_RenderGraph->Write(viewportPass, m_ViewportColorImage, Victory::RenderGraphUsage::eColorAttachment);
+
+    if (ViewportPipeline->IsOcclusionCulling())
+    {
+        // The viewport pass culls against the pyramid of the last frame. The pyramid is rebuilt
+        // from what it drew and the late pass adds what the new pyramid shows of the rest
+        m_DepthPyramidImage = m_RenderGraph->ImportImage("DepthPyramid", 
+            VK_IMAGE_ASPECT_COLOR_BIT, s_DepthPyramidState, VK_IMAGE_LAYOUT_GENERAL);
+        m_RenderGraph->Read(viewportPass, m_DepthPyramidImage, Victory::RenderGraphUsage::eStorage);
+
+        const Victory::RenderGraphPass pyramidPass{ m_RenderGraph->AddPass("DepthPyramid", ViewportPipeline, 
+            [this, ViewportPipeline](VkCommandBuffer commandBuffer_)
+            {
+                m_GpuProfiler->BeginScope(commandBuffer_, "DepthPyramid");
+                ViewportPipeline->RecordDepthPyramid(commandBuffer_);
+                m_GpuProfiler->EndScope(commandBuffer_);
+            }) };
+        m_RenderGraph->Read(pyramidPass, ViewportPipeline->GetDepthImage(), Victory::RenderGraphUsage::eComputeSampled);
+        m_RenderGraph->Write(pyramidPass, m_DepthPyramidImage, Victory::RenderGraphUsage::eStorage);
+
+        const Victory::RenderGraphPass latePass{ m_RenderGraph->AddPass("ViewportLate", ViewportPipeline, 
+            [this, ViewportPipeline](VkCommandBuffer commandBuffer_)
+            {
+                m_GpuProfiler->BeginScope(commandBuffer_, "ViewportLate");
+                ViewportPipeline->RecordLate();
+                m_GpuProfiler->EndScope(commandBuffer_);
+            }) };
+        m_RenderGraph->Read(latePass, m_DepthPyramidImage, Victory::RenderGraphUsage::eStorage);
+        m_RenderGraph->Write(latePass, ViewportPipeline->GetMsaaImage(), Victory::RenderGraphUsage::eColorAttachment);
+        m_RenderGraph->Write(latePass, ViewportPipeline->GetDepthImage(), Victory::RenderGraphUsage::eDepthAttachment);
+        m_RenderGraph->Write(latePass, m_ViewportColorImage, Victory::RenderGraphUsage::eColorAttachment);
+    }
+
+    if (m_Headless)
+    {
+        m_RenderGraph->MarkOutput(m_ViewportColorImage);
+
+        if (m_ReadbackBuffer)
+        {
+            // Copies only in the frame the readback buffer was set for
+            const Victory::RenderGraphPass readbackPass{ m_RenderGraph->AddPass("Readback", ViewportPipeline, 
+                [ViewportPipeline](VkCommandBuffer commandBuffer_)
+                {
+                    ViewportPipeline->RecordReadback(commandBuffer_);
+                }) };
+            m_RenderGraph->Read(readbackPass, m_ViewportColorImage, Victory::RenderGraphUsage::eTransferSrc);
+            m_RenderGraph->MarkSideEffect(readbackPass);
+        }
+    }
+    else
+    {
+        Victory::VulkanGraphicsPipeline* ImGuiPipeline{ m_Pipelines["ImGui"] };
+
+        m_BackbufferImage = m_RenderGraph->ImportImage("Backbuffer", 
+            VK_IMAGE_ASPECT_COLOR_BIT, s_AcquiredImageState, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+        m_RenderGraph->MarkOutput(m_BackbufferImage);
+
+        const Victory::RenderGraphPass imguiPass{ m_RenderGraph->AddPass("ImGui", ImGuiPipeline, 
+            [this, ImGuiPipeline](VkCommandBuffer commandBuffer_)
+            {
+                m_GpuProfiler->BeginScope(commandBuffer_, "ImGui");
+                ImGuiPipeline->RecordBuffer(m_ImageIndex);
+                m_GpuProfiler->EndScope(commandBuffer_);
+            }) };
+        m_RenderGraph->Read(imguiPass, m_ViewportColorImage, Victory::RenderGraphUsage::eSampled);
+        m_RenderGraph->Write(imguiPass, m_BackbufferImage, Victory::RenderGraphUsage::eColorAttachment);
+    }
+
+    m_RenderGraph->Compile();
+}
+
+void VulkanRenderer::EndHeadlessFrame() 
+{
+    VkSubmitInfo submitI{};
+    submitI.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitI.pNext = nullptr;
+    submitI.waitSemaphoreCount = 0;
+    submitI.pWaitSemaphores = nullptr;
+    submitI.pWaitDstStageMask = nullptr;
+    submitI.commandBufferCount = static_cast<uint32_t>(m_CommandBuffers.size());
+    submitI.pCommandBuffers = m_CommandBuffers.data();
+    submitI.signalSemaphoreCount = 0;
+    submitI.pSignalSemaphores = nullptr;
+
+    VkQueue queue;
+    m_VulkanDevice->GetQueue(queue, Victory::QueueIndex::eGraphics);
+    {
+        VICTORY_PROFILE_ZONE("QueueSubmit");
+        vkQueueSubmit(queue, 1, &submitI, m_QueueSubmitFence[m_CurrentFrame]);
+    }
+
+    MarkFrameSubmitted();
+    m_DeletionQueue->EndFrame();
+
+    ++m_RenderedFrames;
+    if (m_RenderedFrames == m_HeadlessFrameCount)
+    {
+        // Also covers every earlier frame, they were submitted to the same queue before
+        vkWaitForFences(m_VulkanDevice->GetDevice(), 1, &m_QueueSubmitFence[m_CurrentFrame], VK_TRUE, UINT64_MAX);
+        CollectLatency();
+
+        const float milliseconds{ std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::steady_clock::now() - m_HeadlessStartTime).count() };
+        std::cout << "Headless: " << m_RenderedFrames << " frames of " 
+            << s_ViewportSize.width << "x" << s_ViewportSize.height << " in " << milliseconds << " ms, " 
+            << milliseconds / static_cast<float>(m_RenderedFrames) << " ms per frame" << std::endl;
+        std::cout << "Input to GPU complete: avg " << m_Latency.averageMs << " ms, max " 
+            << m_Latency.maxMs << " ms, " << m_MaxImageInFight << " frames in flight" << std::endl;
+        std::cout << "Frustum culling: " << m_Scene->GetVisibleObjectCount() << " of " 
+            << m_Scene->GetObjectCount() << " objects visible in the last frame" << std::endl;
+        if (m_Scene->IsOcclusionCulling())
+        {
+            const Victory::CullStats stats{ m_Scene->GetCullStats() };
+            std::cout << "Occlusion culling: " << stats.earlyVisible + stats.lateVisible << " visible (" 
+                << stats.earlyVisible << " early, " << stats.lateVisible << " late), " << stats.occluded 
+                << " occluded, " << stats.frustumCulled << " outside the frustum" << std::endl;
+        }
+        if (m_Scene->IsGpuDriven())
+        {
+            const Victory::CullStats stats{ m_Scene->GetCullStats() };
+            std::cout << "Cluster culling: " << stats.clustersVisible << " of " 
+                << stats.clustersVisible + stats.clustersCulled << " meshlets of LOD 0 draws visible" << std::endl;
+        }
+
+        // The last frame is complete now, fold its timestamps in as well
+        m_GpuProfiler->BeginFrame(m_CurrentFrame);
+        for (auto&& pass : m_GpuProfiler->GetStats())
+        {
+            std::cout << "GPU " << pass.name << ": avg " << pass.averageMs << " ms, p50 " << pass.p50Ms 
+                << " ms, p95 " << pass.p95Ms << " ms, p99 " << pass.p99Ms << " ms" << std::endl;
+        }
+
+        if (m_ReadbackBuffer)
+        {
+            Victory::SavePixels(m_OutputPath, static_cast<const unsigned char*>(m_ReadbackMemory.mapped), 
+                s_ViewportSize.width, s_ViewportSize.height);
+            std::cout << "Last frame written to " << m_OutputPath << std::endl;
+        }
+
+        m_IsRunning = false;
+    }
+
+    m_CurrentFrame = (m_CurrentFrame + 1) % m_MaxImageInFight;
+}
+
+void VulkanRenderer::ConfigurePacing(const RendererSpecification& specification_) 
+{
+    m_Pacing = specification_.Pacing;
+
+    uint32_t framesInFlight{ 2 };
+    uint32_t swapchainImageCount{ 0 };
+    switch (m_Pacing)
+    {
+    case FramePacing::eLowLatency:
+        // As few queued images as the surface allows
+        swapchainImageCount = 2;
+        break;
+    case FramePacing::eThroughput:
+        framesInFlight = 3;
+        swapchainImageCount = 3;
+        break;
+    default:
+        break;
+    }
+
+    m_MaxImageInFight = specification_.FramesInFlight ? specification_.FramesInFlight : framesInFlight;
+    m_SwapchainImageCount = specification_.SwapchainImageCount ? 
+        specification_.SwapchainImageCount : swapchainImageCount;
+
+    m_FrameInputTimes.resize(m_MaxImageInFight);
+    m_LatencyPending.assign(m_MaxImageInFight, false);
+    m_LatencyHistory.reserve(s_LatencyHistorySize);
+    m_Latency.framesInFlight = m_MaxImageInFight;
+}
+
+void VulkanRenderer::CollectLatency() 
+{
+    const auto now{ std::chrono::steady_clock::now() };
+    for (uint32_t i{ 0 }; i < m_MaxImageInFight; ++i)
+    {
+        if (!m_LatencyPending[i] || vkGetFenceStatus(m_VulkanDevice->GetDevice(), m_QueueSubmitFence[i]) != VK_SUCCESS)
+        {
+            continue;
+        }
+        m_LatencyPending[i] = false;
+
+        const float latency{ std::chrono::duration<float, std::chrono::milliseconds::period>(
+            now - m_FrameInputTimes[i]).count() };
+        if (m_LatencyHistory.size() < s_LatencyHistorySize)
+        {
+            m_LatencyHistory.push_back(latency);
+        }
+        else
+        {
+            m_LatencyHistory[m_LatencyNext] = latency;
+            m_LatencyNext = (m_LatencyNext + 1) % s_LatencyHistorySize;
+        }
+
+        float sum{ 0.f };
+        float maximum{ 0.f };
+        for (float sample : m_LatencyHistory)
+        {
+            sum += sample;
+            maximum = std::max(maximum, sample);
+        }
+
+        m_Latency.lastMs = latency;
+        m_Latency.averageMs = sum / static_cast<float>(m_LatencyHistory.size());
+        m_Latency.maxMs = maximum;
+    }
+}
+
+void VulkanRenderer::MarkFrameSubmitted() 
+{
+    m_FrameInputTimes[m_CurrentFrame] = m_InputTime;
+    m_LatencyPending[m_CurrentFrame] = true;
+}
+
+void VulkanRenderer::CreateReadbackBuffer() 
+{
+    VkBufferCreateInfo bufferCI{};
+    bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCI.size = static_cast<VkDeviceSize>(s_ViewportSize.width) * s_ViewportSize.height * 4;
+    bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    m_VulkanDevice->GetAllocator()->CreateBuffer(bufferCI,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        m_ReadbackBuffer, m_ReadbackMemory);
+}
+
 void VulkanRenderer::SetIsResized(bool isResized_) {
     m_IsResized = isResized_;
 }
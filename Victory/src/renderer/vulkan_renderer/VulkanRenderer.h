@@ -5,14 +5,31 @@
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <string>
+#include <chrono>
 #include <unordered_map>
 
+#include "VulkanScene.h"
+#include "VulkanRenderGraph.h"
+
 namespace Victory 
 {
     class VulkanDevice;
     class VulkanSwapchain;
     class VulkanGraphicsPipeline;
-    class VulkanModel;
+    class VulkanGpuProfiler;
+    class VulkanUniformRing;
+    class VulkanDeletionQueue;
+
+    // Input to GPU complete, from sampling input to seeing the fence of that frame
+    // signaled. Presentation happens some time after, it is not measured. Statistics
+    // over the last frames
+    struct FrameLatency
+    {
+        float lastMs{ 0.f };
+        float averageMs{ 0.f };
+        float maxMs{ 0.f };
+        uint32_t framesInFlight{ 0 };
+    };
 }
 
 struct GLFWwindow;
@@ -22,7 +39,7 @@ public:
 
     static Renderer* CreateRenderer();
 
-    virtual void Initialize(const char* applicationName_) override;
+    virtual void Initialize(const char* applicationName_, const RendererSpecification& specification_) override;
 
     virtual bool IsRunning() override;
     virtual void PollEvents() override;
@@ -49,24 +66,45 @@ private:
     void RecreateSwapchain();
     bool InitImGui();
 
+    void BuildRenderGraph();
+
+    void EndHeadlessFrame();
+    void CreateReadbackBuffer();
+
+    void ConfigurePacing(const RendererSpecification& specification_);
+    void CollectLatency();
+    void MarkFrameSubmitted();
+
     friend void OnWindowClose(GLFWwindow* window_);
     friend void OnWindowResize(GLFWwindow* window_, int width_, int height_);
 
 private: 
 
-    GLFWwindow* m_Window;
+    GLFWwindow* m_Window{ nullptr };
     int m_WindowWidth{ 0 };
     int m_WindowHeight{ 0 };
 
     Victory::VulkanDevice* m_VulkanDevice;
-    Victory::VulkanSwapchain* m_VulkanSwapchain;
+    Victory::VulkanSwapchain* m_VulkanSwapchain{ nullptr };
 
     bool m_IsRunning{ true };
     bool m_IsResized{ false };
 
     std::unordered_map<std::string, Victory::VulkanGraphicsPipeline*> m_Pipelines;
 
-    const uint32_t m_MaxImageInFight{ 2 };
+    Victory::VulkanScene* m_Scene{ nullptr };
+    Victory::VulkanGpuProfiler* m_GpuProfiler{ nullptr };
+    Victory::VulkanUniformRing* m_UniformRing{ nullptr };
+    Victory::VulkanDeletionQueue* m_DeletionQueue{ nullptr };
+    Victory::VulkanRenderGraph* m_RenderGraph{ nullptr };
+    Victory::RenderGraphResource m_ViewportColorImage{ 0 };
+    Victory::RenderGraphResource m_BackbufferImage{ 0 };
+    Victory::RenderGraphResource m_DepthPyramidImage{ 0 };
+    Victory::ObjectHandle m_RoomObject{};
+
+    FramePacing m_Pacing{ FramePacing::eBalanced };
+    uint32_t m_MaxImageInFight{ 2 };
+    uint32_t m_SwapchainImageCount{ 0 };
     uint32_t m_CurrentFrame{ 0 };
     uint32_t m_ImageIndex{ 0 };
 
@@ -75,4 +113,22 @@ private:
     std::vector<VkSemaphore> m_ImageAvailableSemaphore;
     std::vector<VkSemaphore> m_RenderingFinishedSemaphore;
     std::vector<VkFence> m_QueueSubmitFence;
+
+    // Input time of every frame slot until its fence is seen signaled
+    std::chrono::steady_clock::time_point m_InputTime{};
+    std::vector<std::chrono::steady_clock::time_point> m_FrameInputTimes;
+    std::vector<bool> m_LatencyPending;
+    std::vector<float> m_LatencyHistory;
+    uint32_t m_LatencyNext{ 0 };
+    Victory::FrameLatency m_Latency{};
+
+    // Headless mode, the viewport renders offscreen and nothing is presented
+    bool m_Headless{ false };
+    uint32_t m_HeadlessFrameCount{ 0 };
+    uint32_t m_RenderedFrames{ 0 };
+    std::chrono::steady_clock::time_point m_HeadlessStartTime{};
+
+    std::string m_OutputPath;
+    VkBuffer m_ReadbackBuffer{ VK_NULL_HANDLE };
+    Victory::VulkanAllocation m_ReadbackMemory{};
 };
\ No newline at end of file
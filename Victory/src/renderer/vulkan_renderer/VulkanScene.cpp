@@ -0,0 +1,1242 @@
+#include <vector>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vulkan/vulkan.h>
+
+#include <glm/vec2.hpp>
+#include <glm/matrix.hpp>
+#include <glm/geometric.hpp>
+
+#include "VulkanScene.h"
+
+#include "VulkanDevice.h"
+#include "VulkanUtils.h"
+#include "VertexQuantization.h"
+
+#include "../../Utils.h"
+
+namespace Victory
+{
+    const static uint32_t s_MaterialSetsPerPool{ 256 };
+    const static uint32_t s_MinInstanceCapacity{ 1024 };
+    const static uint32_t s_MinBucketCapacity{ 64 };
+
+    // 12 MiB of vertices and 16 MiB of indices
+    const static uint32_t s_GeometryPoolVertexCapacity{ 1u << 20 };
+    const static uint32_t s_GeometryPoolIndexCapacity{ 1u << 22 };
+
+    // local_size_x of cull.comp
+    const static uint32_t s_CullGroupSize{ 64 };
+
+    // The guaranteed minimum of maxComputeWorkGroupCount, the meshlet pass wraps its
+    // workgroups into rows of this many
+    const static uint32_t s_MaxCullGroupCount{ 65535 };
+
+    // Phases of cull.comp
+    const static uint32_t s_CullPhaseFrustum{ 0 };
+    const static uint32_t s_CullPhaseEarly{ 1 };
+    const static uint32_t s_CullPhaseLate{ 2 };
+
+    // Counted after the early and late bucket counts: frustum culled and occluded draws,
+    // early and late visible draws, visible and culled meshlets
+    const static uint32_t s_CullStatCount{ 6 };
+
+    struct CullConstants
+    {
+        glm::mat4 viewProjection;
+        glm::vec3 cameraPosition;
+        float lodScale;
+        glm::vec2 viewportSize;
+        uint32_t drawCount;
+        uint32_t phase;
+        uint32_t bucketCount;
+        uint32_t commandCount;
+        // 0 culls draws, 1 the meshlets of the draws it kept, one workgroup per draw
+        uint32_t clusterPass;
+    };
+
+    // pipeline | material slot | mesh slot, 16/24/24 bits
+    static uint64_t MakeSortKey(const SceneObject& object_)
+    {
+        return (static_cast<uint64_t>(object_.pipeline & 0xFFFF) << 48) |
+            (static_cast<uint64_t>(object_.material.index & 0xFFFFFF) << 24) |
+            static_cast<uint64_t>(object_.mesh.index & 0xFFFFFF);
+    }
+
+    // Coarsest LOD whose error in pixels stays within the threshold, errors grow with the LOD
+    static uint32_t SelectLod(const std::vector<MeshLod>& lods_, float distance_, float scale_, float lodScale_)
+    {
+        uint32_t lod{ 0 };
+        while (lod + 1 < lods_.size() && lods_[lod + 1].error * scale_ * lodScale_ <= distance_)
+        {
+            ++lod;
+        }
+        return lod;
+    }
+
+    VulkanScene::VulkanScene(VulkanDevice* vulkanDevice_, uint32_t framesInFlight_, bool occlusionCulling_,
+        float lodErrorPixels_)
+        : m_VulkanDevice{ vulkanDevice_ }, m_OcclusionCulling{ occlusionCulling_ }, m_LodErrorPixels{ lodErrorPixels_ }
+    {
+        m_GeometryPool = new VulkanGeometryPool(m_VulkanDevice,
+            s_GeometryPoolVertexCapacity, s_GeometryPoolIndexCapacity);
+
+        CreateInstanceBuffers(framesInFlight_);
+        CreateMaterialSetLayout();
+        CreateSampler();
+
+        if (m_VulkanDevice->SupportsDrawIndirectCount())
+        {
+            CreateCullPipeline(framesInFlight_);
+        }
+    }
+
+    MeshHandle VulkanScene::LoadMesh(const std::string& path_, uint32_t lodLimit_)
+    {
+        auto&& it{ m_MeshPaths.find(path_) };
+        if (it != m_MeshPaths.end())
+        {
+            return it->second;
+        }
+
+        VulkanModel mesh{};
+        mesh.LoadModel(path_, m_GeometryPool, lodLimit_);
+
+        MeshHandle handle{ m_Meshes.Insert(std::move(mesh)) };
+        m_MeshPaths.emplace(path_, handle);
+        return handle;
+    }
+
+    MaterialHandle VulkanScene::LoadMaterial(const std::string& texturePath_)
+    {
+        auto&& it{ m_MaterialPaths.find(texturePath_) };
+        if (it != m_MaterialPaths.end())
+        {
+            return it->second;
+        }
+
+        VkImageCreateInfo imageCI{};
+        imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCI.pNext = nullptr;
+        imageCI.flags = 0;
+        imageCI.imageType = VK_IMAGE_TYPE_2D;
+        imageCI.format = VK_FORMAT_R8G8B8A8_UNORM;
+        imageCI.extent.depth = 1;
+        imageCI.mipLevels = 1;
+        imageCI.arrayLayers = 1;
+        imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageCI.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        VulkanMaterial material{ m_VulkanDevice };
+        material.LoadTexture(texturePath_, imageCI);
+        material.WriteDescriptorSet(AllocateMaterialSet(), m_Sampler);
+
+        MaterialHandle handle{ m_Materials.Insert(std::move(material)) };
+        m_MaterialPaths.emplace(texturePath_, handle);
+        return handle;
+    }
+
+    ObjectHandle VulkanScene::CreateObject(MeshHandle mesh_, MaterialHandle material_,
+        const glm::mat4& transform_, uint32_t pipeline_)
+    {
+        if (!m_Meshes.Contains(mesh_) || !m_Materials.Contains(material_))
+        {
+            throw std::invalid_argument("Scene object references a missing mesh or material");
+        }
+
+        SceneObject object{};
+        object.mesh = mesh_;
+        object.material = material_;
+        object.pipeline = pipeline_;
+        object.transform = transform_;
+
+        m_DrawsDirty = true;
+        return m_Objects.Insert(std::move(object));
+    }
+
+    void VulkanScene::DestroyObject(ObjectHandle object_)
+    {
+        m_DrawsDirty |= m_Objects.Remove(object_);
+    }
+
+    void VulkanScene::SetTransform(ObjectHandle object_, const glm::mat4& transform_)
+    {
+        // Transforms are not part of the sort key, no resort needed
+        SceneObject* object{ m_Objects.Get(object_) };
+        if (!object)
+        {
+            return;
+        }
+        object->transform = transform_;
+
+        // A pending resort rewrites every draw anyway
+        if (!IsGpuDriven() || m_DrawsDirty)
+        {
+            return;
+        }
+
+        const uint32_t draw{ m_ObjectDraws[object_.index] };
+        for (auto&& cullBuffers : m_CullBuffers)
+        {
+            if (cullBuffers.dirtyDraws.size() < m_Draws.size())
+            {
+                cullBuffers.dirtyDraws.push_back(draw);
+            }
+            else
+            {
+                cullBuffers.rewrite = true;
+            }
+        }
+    }
+
+    void VulkanScene::PrepareDraws(uint32_t frameIndex_, const SceneView& view_)
+    {
+        m_PreparedFrame = frameIndex_;
+
+        const glm::mat4 viewProjection{ view_.proj * view_.view };
+        m_CameraPosition = glm::vec3{ glm::inverse(view_.view)[3] };
+
+        // The projection may flip y, only the focal length matters
+        m_LodScale = std::abs(view_.proj[1][1]) * 0.5f * static_cast<float>(view_.viewportHeight) / m_LodErrorPixels;
+
+        if (IsGpuDriven())
+        {
+            PrepareGpuDraws(frameIndex_, viewProjection);
+            return;
+        }
+
+        if (m_DrawsDirty)
+        {
+            SortDraws();
+        }
+        CullDraws(viewProjection);
+
+        InstanceBuffer& instanceBuffer{ m_InstanceBuffers[frameIndex_] };
+        ReserveInstances(instanceBuffer, m_Objects.GetCount());
+        InstanceData* instances{ static_cast<InstanceData*>(instanceBuffer.allocation.mapped) };
+        m_BatchInstanceSet = instanceBuffer.descriptorSet;
+
+        m_Batches.clear();
+        uint32_t instanceCount{ 0 };
+
+        size_t begin{ 0 };
+        while (begin < m_Draws.size())
+        {
+            // Equal keys mean equal pipeline, material and mesh, the run is one draw per LOD
+            size_t end{ begin + 1 };
+            while (end < m_Draws.size() && m_Draws[end].sortKey == m_Draws[begin].sortKey)
+            {
+                ++end;
+            }
+
+            const SceneObject& object{ m_Objects.At(m_Draws[begin].object) };
+            const VulkanModel* mesh{ m_Meshes.Get(object.mesh) };
+            const VulkanMaterial* material{ m_Materials.Get(object.material) };
+
+            // Skip until the upload batches of both completed
+            if (!mesh || !material || !mesh->IsReady() || !material->IsReady())
+            {
+                begin = end;
+                continue;
+            }
+
+            // firstInstance offsets gl_InstanceIndex into this run of the instance buffer,
+            // one batch per LOD in use
+            DrawBatch batch{};
+            batch.pipeline = object.pipeline;
+            batch.material = object.material.index;
+            batch.mesh = object.mesh.index;
+
+            for (batch.lod = 0; batch.lod < mesh->GetLods().size(); ++batch.lod)
+            {
+                batch.firstInstance = instanceCount;
+                for (size_t i{ begin }; i < end; ++i)
+                {
+                    if (m_DrawVisible[i] && m_DrawLods[i] == batch.lod)
+                    {
+                        WriteInstance(instances[instanceCount++], m_Draws[i].object);
+                    }
+                }
+
+                batch.instanceCount = instanceCount - batch.firstInstance;
+                if (batch.instanceCount)
+                {
+                    m_Batches.push_back(batch);
+                }
+            }
+
+            begin = end;
+        }
+    }
+
+    void VulkanScene::RecordCulling(VkCommandBuffer commandBuffer_, CullPhase phase_) const
+    {
+        if (!IsGpuDriven() || m_Draws.empty())
+        {
+            return;
+        }
+
+        const CullBuffers& cullBuffers{ m_CullBuffers[m_PreparedFrame] };
+        const uint32_t bucketCount{ static_cast<uint32_t>(m_Buckets.size()) };
+        const VkDeviceSize countSize{ sizeof(uint32_t) * (2 * static_cast<VkDeviceSize>(bucketCount) + s_CullStatCount) };
+        // Without occlusion culling there is no late phase
+        const bool lastPhase{ !IsOcclusionCulling() || phase_ == CullPhase::eLate };
+
+        VkBufferMemoryBarrier countBarrier{};
+        countBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        countBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        countBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        countBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        countBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        countBarrier.buffer = cullBuffers.countBuffer;
+        countBarrier.offset = 0;
+        countBarrier.size = countSize;
+
+        // Both phases count into the buffer cleared by the early one
+        if (phase_ == CullPhase::eEarly)
+        {
+            vkCmdFillBuffer(commandBuffer_, cullBuffers.countBuffer, 0, countSize, 0);
+            vkCmdPipelineBarrier(commandBuffer_, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                0, nullptr, 1, &countBarrier, 0, nullptr);
+        }
+
+        CullConstants constants{};
+        constants.viewProjection = m_CullViewProjection;
+        constants.cameraPosition = m_CameraPosition;
+        constants.lodScale = m_LodScale;
+        constants.viewportSize = glm::vec2{ static_cast<float>(m_DepthPyramidExtent.width),
+            static_cast<float>(m_DepthPyramidExtent.height) };
+        constants.drawCount = static_cast<uint32_t>(m_Draws.size());
+        constants.phase = !IsOcclusionCulling() ? s_CullPhaseFrustum :
+            phase_ == CullPhase::eEarly ? s_CullPhaseEarly : s_CullPhaseLate;
+        constants.bucketCount = bucketCount;
+        constants.commandCount = m_CommandCount;
+        constants.clusterPass = 0;
+
+        vkCmdBindPipeline(commandBuffer_, VK_PIPELINE_BIND_POINT_COMPUTE, m_CullPipeline);
+        vkCmdBindDescriptorSets(commandBuffer_, VK_PIPELINE_BIND_POINT_COMPUTE,
+            m_CullPipelineLayout, 0, 1, &cullBuffers.descriptorSet, 0, nullptr);
+        vkCmdPushConstants(commandBuffer_, m_CullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+            0, sizeof(constants), &constants);
+        vkCmdDispatch(commandBuffer_, (constants.drawCount + s_CullGroupSize - 1) / s_CullGroupSize, 1, 1);
+
+        // The meshlet pass reads which draws the draw pass handed over and keeps counting
+        if (!m_ClusterInfos.empty())
+        {
+            VkMemoryBarrier clusterBarrier{};
+            clusterBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            clusterBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            clusterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+            vkCmdPipelineBarrier(commandBuffer_, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                1, &clusterBarrier, 0, nullptr, 0, nullptr);
+
+            const uint32_t groupCountX{ std::min(constants.drawCount, s_MaxCullGroupCount) };
+            const uint32_t groupCountY{ (constants.drawCount + groupCountX - 1) / groupCountX };
+
+            constants.clusterPass = 1;
+            vkCmdPushConstants(commandBuffer_, m_CullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+                0, sizeof(constants), &constants);
+            vkCmdDispatch(commandBuffer_, groupCountX, groupCountY, 1);
+        }
+
+        // Commands and counts are read as indirect arguments, the counts also by the statistics copy.
+        // Before the late phase, it reads the occluded flags and keeps counting
+        std::array<VkBufferMemoryBarrier, 3> indirectBarriers{ countBarrier, countBarrier, countBarrier };
+        indirectBarriers[0].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        indirectBarriers[0].dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        indirectBarriers[0].buffer = cullBuffers.commandBuffer;
+        indirectBarriers[0].size = VK_WHOLE_SIZE;
+        indirectBarriers[1].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        indirectBarriers[1].dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+        indirectBarriers[2].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        indirectBarriers[2].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        indirectBarriers[2].buffer = cullBuffers.occludedBuffer;
+        indirectBarriers[2].size = VK_WHOLE_SIZE;
+
+        VkPipelineStageFlags dstStages{ VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT };
+        uint32_t barrierCount{ 2 };
+        if (!lastPhase)
+        {
+            indirectBarriers[1].dstAccessMask |= VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            dstStages |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            barrierCount = 3;
+        }
+
+        vkCmdPipelineBarrier(commandBuffer_, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, dstStages, 0,
+            0, nullptr, barrierCount, indirectBarriers.data(), 0, nullptr);
+
+        if (!lastPhase)
+        {
+            return;
+        }
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = 0;
+        copyRegion.dstOffset = 0;
+        copyRegion.size = countSize;
+
+        vkCmdCopyBuffer(commandBuffer_, cullBuffers.countBuffer, cullBuffers.countReadbackBuffer, 1, &copyRegion);
+
+        countBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        countBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        countBarrier.buffer = cullBuffers.countReadbackBuffer;
+
+        vkCmdPipelineBarrier(commandBuffer_, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+            0, nullptr, 1, &countBarrier, 0, nullptr);
+    }
+
+    void VulkanScene::RecordBatches(VkCommandBuffer commandBuffer_, VkPipelineLayout pipelineLayout_,
+        std::span<const VkPipeline> pipelines_, uint32_t begin_, uint32_t end_, CullPhase phase_) const
+    {
+        vkCmdBindDescriptorSets(commandBuffer_, VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineLayout_, 1, 1, &m_BatchInstanceSet, 0, nullptr);
+
+        // Every mesh lives in the pool, geometry is bound once
+        m_GeometryPool->Bind(commandBuffer_);
+
+        VkPipeline boundPipeline{ VK_NULL_HANDLE };
+        uint32_t boundMaterial{ UINT32_MAX };
+
+        auto&& bindState{ [&](uint32_t pipelineIndex_, uint32_t material_)
+        {
+            const VkPipeline pipeline{ pipelines_[pipelineIndex_] };
+            if (pipeline != boundPipeline)
+            {
+                vkCmdBindPipeline(commandBuffer_, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+                boundPipeline = pipeline;
+            }
+
+            if (material_ != boundMaterial)
+            {
+                VkDescriptorSet descriptorSet{ m_Materials.At(material_).GetDescriptorSet() };
+                vkCmdBindDescriptorSets(commandBuffer_, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    pipelineLayout_, 2, 1, &descriptorSet, 0, nullptr);
+                boundMaterial = material_;
+            }
+        } };
+
+        if (IsGpuDriven())
+        {
+            const CullBuffers& cullBuffers{ m_CullBuffers[m_PreparedFrame] };
+            // Late commands and counts follow the early ones
+            const bool late{ phase_ == CullPhase::eLate };
+            const VkDeviceSize firstCommand{ late ? m_CommandCount : 0 };
+            const VkDeviceSize firstCount{ late ? m_Buckets.size() : 0 };
+            for (uint32_t i{ begin_ }; i < end_; ++i)
+            {
+                const DrawBucket& bucket{ m_Buckets[i] };
+                bindState(bucket.pipeline, bucket.material);
+
+                vkCmdDrawIndexedIndirectCount(commandBuffer_, 
+                    cullBuffers.commandBuffer, sizeof(VkDrawIndexedIndirectCommand) * (firstCommand + bucket.firstCommand),
+                    cullBuffers.countBuffer, sizeof(uint32_t) * (firstCount + i),
+                    bucket.commandCount, sizeof(VkDrawIndexedIndirectCommand));
+            }
+            return;
+        }
+
+        for (uint32_t i{ begin_ }; i < end_; ++i)
+        {
+            const DrawBatch& batch{ m_Batches[i] };
+            bindState(batch.pipeline, batch.material);
+
+            const VulkanModel& mesh{ m_Meshes.At(batch.mesh) };
+            const GeometryRange& geometry{ mesh.GetGeometry() };
+            const MeshLod& lod{ mesh.GetLods()[batch.lod] };
+            vkCmdDrawIndexed(commandBuffer_, lod.indexCount, batch.instanceCount,
+                geometry.firstIndex + lod.firstIndex, geometry.vertexOffset, batch.firstInstance);
+        }
+    }
+
+    void VulkanScene::SetDepthPyramid(VkImageView view_, VkSampler sampler_, VkExtent2D viewportExtent_)
+    {
+        m_DepthPyramidView = view_;
+        m_DepthPyramidSampler = sampler_;
+        m_DepthPyramidExtent = viewportExtent_;
+        ++m_DepthPyramidGeneration;
+    }
+
+    uint32_t VulkanScene::GetVisibleObjectCount() const
+    {
+        if (!IsGpuDriven())
+        {
+            return m_VisibleObjectCount;
+        }
+
+        const CullStats stats{ GetCullStats() };
+        return stats.earlyVisible + stats.lateVisible;
+    }
+
+    CullStats VulkanScene::GetCullStats() const
+    {
+        CullStats stats{};
+        if (!IsGpuDriven())
+        {
+            stats.earlyVisible = m_VisibleObjectCount;
+            stats.frustumCulled = static_cast<uint32_t>(m_Draws.size()) - m_VisibleObjectCount;
+            return stats;
+        }
+
+        const CullBuffers& cullBuffers{ m_CullBuffers[m_PreparedFrame] };
+        const uint32_t* counts{ static_cast<const uint32_t*>(cullBuffers.countReadbackAllocation.mapped) };
+        const size_t bucketCount{ std::min(m_Buckets.size(), static_cast<size_t>(cullBuffers.bucketCapacity)) };
+
+        // Bucket counts are commands, meshlets included, the draws are counted apart
+        const uint32_t* statistics{ counts + 2 * bucketCount };
+        stats.frustumCulled = statistics[0];
+        stats.occluded = statistics[1];
+        stats.earlyVisible = statistics[2];
+        stats.lateVisible = statistics[3];
+        stats.clustersVisible = statistics[4];
+        stats.clustersCulled = statistics[5];
+        return stats;
+    }
+
+    void VulkanScene::CleanupAll()
+    {
+        VkDevice device{ m_VulkanDevice->GetDevice() };
+
+        m_Materials.ForEach([](MaterialHandle, VulkanMaterial& material_) { material_.CleanupAll(); });
+
+        m_Meshes.Clear();
+        m_Materials.Clear();
+        m_Objects.Clear();
+        m_MeshPaths.clear();
+        m_MaterialPaths.clear();
+        m_Draws.clear();
+        m_Batches.clear();
+        m_Buckets.clear();
+        m_DrawInfos.clear();
+        m_ClusterInfos.clear();
+        m_CommandCount = 0;
+        m_ReadyAssetCount = 0;
+
+        delete m_GeometryPool;
+        m_GeometryPool = nullptr;
+
+        for (auto&& cullBuffers : m_CullBuffers)
+        {
+            DestroyCullBuffers(cullBuffers);
+        }
+        m_CullBuffers.clear();
+        vkDestroyPipeline(device, m_CullPipeline, nullptr);
+        vkDestroyPipelineLayout(device, m_CullPipelineLayout, nullptr);
+        vkDestroyDescriptorPool(device, m_CullPool, nullptr);
+        vkDestroyDescriptorSetLayout(device, m_CullSetLayout, nullptr);
+        m_CullPipeline = VK_NULL_HANDLE;
+
+        for (auto&& pool : m_MaterialPools)
+        {
+            vkDestroyDescriptorPool(device, pool, nullptr);
+        }
+        m_MaterialPools.clear();
+
+        for (auto&& instanceBuffer : m_InstanceBuffers)
+        {
+            m_VulkanDevice->GetAllocator()->DestroyBuffer(instanceBuffer.buffer, instanceBuffer.allocation);
+        }
+        m_InstanceBuffers.clear();
+        vkDestroyDescriptorPool(device, m_InstancePool, nullptr);
+        vkDestroyDescriptorSetLayout(device, m_InstanceSetLayout, nullptr);
+
+        vkDestroySampler(device, m_Sampler, nullptr);
+        vkDestroyDescriptorSetLayout(device, m_MaterialSetLayout, nullptr);
+    }
+
+    void VulkanScene::CreateInstanceBuffers(uint32_t framesInFlight_)
+    {
+        VkDevice device{ m_VulkanDevice->GetDevice() };
+
+        VkDescriptorSetLayoutBinding instanceLayoutBinding{};
+        instanceLayoutBinding.binding = 0;
+        instanceLayoutBinding.descriptorCount = 1;
+        instanceLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        instanceLayoutBinding.pImmutableSamplers = nullptr;
+        instanceLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCI{};
+        descriptorSetLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        descriptorSetLayoutCI.bindingCount = 1;
+        descriptorSetLayoutCI.pBindings = &instanceLayoutBinding;
+
+        CheckVulkanResult(
+            vkCreateDescriptorSetLayout(device, &descriptorSetLayoutCI, nullptr, &m_InstanceSetLayout),
+            "Instance Descriptor Set Layout was not created");
+
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSize.descriptorCount = framesInFlight_;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = 0;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        poolInfo.maxSets = framesInFlight_;
+
+        CheckVulkanResult(
+            vkCreateDescriptorPool(device, &poolInfo, nullptr, &m_InstancePool),
+            "Instance Descriptor Pool was not created");
+
+        const std::vector<VkDescriptorSetLayout> layouts(framesInFlight_, m_InstanceSetLayout);
+        std::vector<VkDescriptorSet> descriptorSets(framesInFlight_);
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = m_InstancePool;
+        allocInfo.descriptorSetCount = framesInFlight_;
+        allocInfo.pSetLayouts = layouts.data();
+
+        CheckVulkanResult(
+            vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()),
+            "Instance Descriptor Sets were not allocated");
+
+        m_InstanceBuffers.resize(framesInFlight_);
+        for (uint32_t i{ 0 }; i < framesInFlight_; ++i)
+        {
+            m_InstanceBuffers[i].descriptorSet = descriptorSets[i];
+            ReserveInstances(m_InstanceBuffers[i], s_MinInstanceCapacity);
+        }
+    }
+
+    bool VulkanScene::ReserveInstances(InstanceBuffer& instanceBuffer_, uint32_t count_)
+    {
+        if (count_ <= instanceBuffer_.capacity)
+        {
+            return false;
+        }
+
+        // The frame owning the buffer already waited for its fence, nothing reads it anymore
+        VulkanAllocator* allocator{ m_VulkanDevice->GetAllocator() };
+        if (instanceBuffer_.buffer)
+        {
+            allocator->DestroyBuffer(instanceBuffer_.buffer, instanceBuffer_.allocation);
+        }
+
+        instanceBuffer_.capacity = std::max(std::bit_ceil(count_), s_MinInstanceCapacity);
+
+        VkBufferCreateInfo bufferCI{};
+        bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCI.size = sizeof(InstanceData) * instanceBuffer_.capacity;
+        bufferCI.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        allocator->CreateBuffer(bufferCI,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            instanceBuffer_.buffer, instanceBuffer_.allocation);
+
+        VkDescriptorBufferInfo bufferInfo{};
+        bufferInfo.buffer = instanceBuffer_.buffer;
+        bufferInfo.offset = 0;
+        bufferInfo.range = VK_WHOLE_SIZE;
+
+        VkWriteDescriptorSet descriptorWrite{};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = instanceBuffer_.descriptorSet;
+        descriptorWrite.dstBinding = 0;
+        descriptorWrite.dstArrayElement = 0;
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.pBufferInfo = &bufferInfo;
+
+        vkUpdateDescriptorSets(m_VulkanDevice->GetDevice(), 1, &descriptorWrite, 0, nullptr);
+        return true;
+    }
+
+    void VulkanScene::CreateCullPipeline(uint32_t framesInFlight_)
+    {
+        VkDevice device{ m_VulkanDevice->GetDevice() };
+
+        // Instances, draw infos, commands, counts, the depth pyramid, the occluded flags,
+        // the draws handed to the meshlet pass and the meshlets
+        std::array<VkDescriptorSetLayoutBinding, 8> layoutBindings{};
+        for (uint32_t i{ 0 }; i < layoutBindings.size(); ++i)
+        {
+            layoutBindings[i].binding = i;
+            layoutBindings[i].descriptorCount = 1;
+            layoutBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            layoutBindings[i].pImmutableSamplers = nullptr;
+            layoutBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+        layoutBindings[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCI{};
+        descriptorSetLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        descriptorSetLayoutCI.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+        descriptorSetLayoutCI.pBindings = layoutBindings.data();
+
+        CheckVulkanResult(
+            vkCreateDescriptorSetLayout(device, &descriptorSetLayoutCI, nullptr, &m_CullSetLayout),
+            "Cull Descriptor Set Layout was not created");
+
+        std::array<VkDescriptorPoolSize, 2> poolSizes{};
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSizes[0].descriptorCount = framesInFlight_ * static_cast<uint32_t>(layoutBindings.size() - 1);
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSizes[1].descriptorCount = framesInFlight_;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = 0;
+        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        poolInfo.maxSets = framesInFlight_;
+
+        CheckVulkanResult(
+            vkCreateDescriptorPool(device, &poolInfo, nullptr, &m_CullPool),
+            "Cull Descriptor Pool was not created");
+
+        const std::vector<VkDescriptorSetLayout> layouts(framesInFlight_, m_CullSetLayout);
+        std::vector<VkDescriptorSet> descriptorSets(framesInFlight_);
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = m_CullPool;
+        allocInfo.descriptorSetCount = framesInFlight_;
+        allocInfo.pSetLayouts = layouts.data();
+
+        CheckVulkanResult(
+            vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()),
+            "Cull Descriptor Sets were not allocated");
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(CullConstants);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutCI{};
+        pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCI.setLayoutCount = 1;
+        pipelineLayoutCI.pSetLayouts = &m_CullSetLayout;
+        pipelineLayoutCI.pushConstantRangeCount = 1;
+        pipelineLayoutCI.pPushConstantRanges = &pushConstantRange;
+
+        CheckVulkanResult(
+            vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &m_CullPipelineLayout),
+            "Cull Pipeline Layout was not created");
+
+        const std::vector<char> csBuffer = Utils::ReadFile("cull.comp.spv");
+
+        VkShaderModule CS{ VK_NULL_HANDLE };
+        CreateShaderModule(device, csBuffer, &CS);
+
+        VkComputePipelineCreateInfo pipelineCI{};
+        pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineCI.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineCI.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineCI.stage.module = CS;
+        pipelineCI.stage.pName = "main";
+        pipelineCI.layout = m_CullPipelineLayout;
+
+        CheckVulkanResult(
+            vkCreateComputePipelines(device, m_VulkanDevice->GetPipelineCache(), 1, &pipelineCI, nullptr, &m_CullPipeline),
+            "Cull Pipeline was not created");
+
+        vkDestroyShaderModule(device, CS, nullptr);
+
+        m_CullBuffers.resize(framesInFlight_);
+        for (uint32_t i{ 0 }; i < framesInFlight_; ++i)
+        {
+            m_CullBuffers[i].descriptorSet = descriptorSets[i];
+            ReserveCullBuffers(m_CullBuffers[i], s_MinInstanceCapacity, s_MinInstanceCapacity,
+                s_MinInstanceCapacity, s_MinBucketCapacity);
+            WriteCullDescriptorSet(m_InstanceBuffers[i], m_CullBuffers[i]);
+        }
+    }
+
+    bool VulkanScene::ReserveCullBuffers(CullBuffers& cullBuffers_, uint32_t drawCount_, uint32_t commandCount_,
+        uint32_t clusterCount_, uint32_t bucketCount_)
+    {
+        VulkanAllocator* allocator{ m_VulkanDevice->GetAllocator() };
+        bool replaced{ false };
+
+        VkBufferCreateInfo bufferCI{};
+        bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        // As with the instances, the frame owning these already waited for its fence
+        if (drawCount_ > cullBuffers_.drawCapacity)
+        {
+            if (cullBuffers_.drawInfoBuffer)
+            {
+                allocator->DestroyBuffer(cullBuffers_.drawInfoBuffer, cullBuffers_.drawInfoAllocation);
+                allocator->DestroyBuffer(cullBuffers_.occludedBuffer, cullBuffers_.occludedAllocation);
+                allocator->DestroyBuffer(cullBuffers_.clusterPhaseBuffer, cullBuffers_.clusterPhaseAllocation);
+            }
+
+            cullBuffers_.drawCapacity = std::max(std::bit_ceil(drawCount_), s_MinInstanceCapacity);
+
+            bufferCI.size = sizeof(GpuDrawInfo) * cullBuffers_.drawCapacity;
+            bufferCI.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            allocator->CreateBuffer(bufferCI,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                cullBuffers_.drawInfoBuffer, cullBuffers_.drawInfoAllocation);
+
+            bufferCI.size = sizeof(uint32_t) * cullBuffers_.drawCapacity;
+            bufferCI.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            allocator->CreateBuffer(bufferCI, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                cullBuffers_.occludedBuffer, cullBuffers_.occludedAllocation);
+            allocator->CreateBuffer(bufferCI, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                cullBuffers_.clusterPhaseBuffer, cullBuffers_.clusterPhaseAllocation);
+
+            replaced = true;
+        }
+
+        if (commandCount_ > cullBuffers_.commandCapacity)
+        {
+            if (cullBuffers_.commandBuffer)
+            {
+                allocator->DestroyBuffer(cullBuffers_.commandBuffer, cullBuffers_.commandAllocation);
+            }
+
+            cullBuffers_.commandCapacity = std::max(std::bit_ceil(commandCount_), s_MinInstanceCapacity);
+
+            // Room for an early and a late command per slot
+            bufferCI.size = sizeof(VkDrawIndexedIndirectCommand) * 2 * cullBuffers_.commandCapacity;
+            bufferCI.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+            allocator->CreateBuffer(bufferCI, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                cullBuffers_.commandBuffer, cullBuffers_.commandAllocation);
+
+            replaced = true;
+        }
+
+        if (clusterCount_ > cullBuffers_.clusterCapacity)
+        {
+            if (cullBuffers_.clusterInfoBuffer)
+            {
+                allocator->DestroyBuffer(cullBuffers_.clusterInfoBuffer, cullBuffers_.clusterInfoAllocation);
+            }
+
+            cullBuffers_.clusterCapacity = std::max(std::bit_ceil(clusterCount_), s_MinInstanceCapacity);
+
+            bufferCI.size = sizeof(GpuClusterInfo) * cullBuffers_.clusterCapacity;
+            bufferCI.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            allocator->CreateBuffer(bufferCI,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                cullBuffers_.clusterInfoBuffer, cullBuffers_.clusterInfoAllocation);
+
+            replaced = true;
+        }
+
+        if (bucketCount_ > cullBuffers_.bucketCapacity)
+        {
+            if (cullBuffers_.countBuffer)
+            {
+                allocator->DestroyBuffer(cullBuffers_.countBuffer, cullBuffers_.countAllocation);
+                allocator->DestroyBuffer(cullBuffers_.countReadbackBuffer, cullBuffers_.countReadbackAllocation);
+            }
+
+            cullBuffers_.bucketCapacity = std::max(std::bit_ceil(bucketCount_), s_MinBucketCapacity);
+
+            bufferCI.size = sizeof(uint32_t) * (2 * static_cast<VkDeviceSize>(cullBuffers_.bucketCapacity) + s_CullStatCount);
+            bufferCI.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            allocator->CreateBuffer(bufferCI, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                cullBuffers_.countBuffer, cullBuffers_.countAllocation);
+
+            bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            allocator->CreateBuffer(bufferCI,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                cullBuffers_.countReadbackBuffer, cullBuffers_.countReadbackAllocation);
+            memset(cullBuffers_.countReadbackAllocation.mapped, 0, static_cast<size_t>(bufferCI.size));
+
+            replaced = true;
+        }
+
+        return replaced;
+    }
+
+    void VulkanScene::WriteCullDescriptorSet(const InstanceBuffer& instanceBuffer_, const CullBuffers& cullBuffers_)
+    {
+        // Binding 4 is the depth pyramid, see WriteDepthPyramidDescriptor
+        const std::array<VkBuffer, 7> buffers{ instanceBuffer_.buffer, cullBuffers_.drawInfoBuffer,
+            cullBuffers_.commandBuffer, cullBuffers_.countBuffer, cullBuffers_.occludedBuffer,
+            cullBuffers_.clusterPhaseBuffer, cullBuffers_.clusterInfoBuffer };
+        const std::array<uint32_t, 7> bindings{ 0, 1, 2, 3, 5, 6, 7 };
+
+        std::array<VkDescriptorBufferInfo, 7> bufferInfos{};
+        std::array<VkWriteDescriptorSet, 7> descriptorWrites{};
+        for (uint32_t i{ 0 }; i < buffers.size(); ++i)
+        {
+            bufferInfos[i].buffer = buffers[i];
+            bufferInfos[i].offset = 0;
+            bufferInfos[i].range = VK_WHOLE_SIZE;
+
+            descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[i].dstSet = cullBuffers_.descriptorSet;
+            descriptorWrites[i].dstBinding = bindings[i];
+            descriptorWrites[i].dstArrayElement = 0;
+            descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptorWrites[i].descriptorCount = 1;
+            descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+        }
+
+        vkUpdateDescriptorSets(m_VulkanDevice->GetDevice(),
+            static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    }
+
+    void VulkanScene::WriteDepthPyramidDescriptor(CullBuffers& cullBuffers_)
+    {
+        if (cullBuffers_.depthPyramidGeneration == m_DepthPyramidGeneration)
+        {
+            return;
+        }
+
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.sampler = m_DepthPyramidSampler;
+        imageInfo.imageView = m_DepthPyramidView;
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        VkWriteDescriptorSet descriptorWrite{};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = cullBuffers_.descriptorSet;
+        descriptorWrite.dstBinding = 4;
+        descriptorWrite.dstArrayElement = 0;
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.pImageInfo = &imageInfo;
+
+        vkUpdateDescriptorSets(m_VulkanDevice->GetDevice(), 1, &descriptorWrite, 0, nullptr);
+        cullBuffers_.depthPyramidGeneration = m_DepthPyramidGeneration;
+    }
+
+    void VulkanScene::DestroyCullBuffers(CullBuffers& cullBuffers_)
+    {
+        VulkanAllocator* allocator{ m_VulkanDevice->GetAllocator() };
+
+        allocator->DestroyBuffer(cullBuffers_.drawInfoBuffer, cullBuffers_.drawInfoAllocation);
+        allocator->DestroyBuffer(cullBuffers_.commandBuffer, cullBuffers_.commandAllocation);
+        allocator->DestroyBuffer(cullBuffers_.occludedBuffer, cullBuffers_.occludedAllocation);
+        allocator->DestroyBuffer(cullBuffers_.clusterPhaseBuffer, cullBuffers_.clusterPhaseAllocation);
+        allocator->DestroyBuffer(cullBuffers_.clusterInfoBuffer, cullBuffers_.clusterInfoAllocation);
+        allocator->DestroyBuffer(cullBuffers_.countBuffer, cullBuffers_.countAllocation);
+        allocator->DestroyBuffer(cullBuffers_.countReadbackBuffer, cullBuffers_.countReadbackAllocation);
+    }
+
+    void VulkanScene::CreateMaterialSetLayout()
+    {
+        VkDescriptorSetLayoutBinding samplerLayoutBinding{};
+        samplerLayoutBinding.binding = 0;
+        samplerLayoutBinding.descriptorCount = 1;
+        samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        samplerLayoutBinding.pImmutableSamplers = nullptr;
+        samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCI{};
+        descriptorSetLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        descriptorSetLayoutCI.bindingCount = 1;
+        descriptorSetLayoutCI.pBindings = &samplerLayoutBinding;
+
+        CheckVulkanResult(
+            vkCreateDescriptorSetLayout(m_VulkanDevice->GetDevice(),
+                &descriptorSetLayoutCI, nullptr, &m_MaterialSetLayout),
+            "Material Descriptor Set Layout was not created");
+    }
+
+    void VulkanScene::CreateSampler()
+    {
+        VkPhysicalDeviceProperties properties{};
+        vkGetPhysicalDeviceProperties(m_VulkanDevice->GetPhysicalDevice(), &properties);
+
+        // One sampler is shared by every material
+        VkSamplerCreateInfo samplerCI{};
+        samplerCI.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerCI.magFilter = VK_FILTER_LINEAR;
+        samplerCI.minFilter = VK_FILTER_LINEAR;
+        samplerCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerCI.anisotropyEnable = VK_TRUE;
+        samplerCI.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
+        samplerCI.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+        samplerCI.unnormalizedCoordinates = VK_FALSE;
+        samplerCI.compareEnable = VK_FALSE;
+        samplerCI.compareOp = VK_COMPARE_OP_ALWAYS;
+        samplerCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        samplerCI.minLod = 0.f;
+        samplerCI.maxLod = VK_LOD_CLAMP_NONE;
+        samplerCI.mipLodBias = 0.f;
+
+        CheckVulkanResult(
+            vkCreateSampler(m_VulkanDevice->GetDevice(), &samplerCI, nullptr, &m_Sampler),
+            "Material Sampler was not created");
+    }
+
+    VkDescriptorSet VulkanScene::AllocateMaterialSet()
+    {
+        VkDevice device{ m_VulkanDevice->GetDevice() };
+
+        if (m_MaterialPools.empty() || m_MaterialPoolUsage == s_MaterialSetsPerPool)
+        {
+            VkDescriptorPoolSize poolSize{};
+            poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            poolSize.descriptorCount = s_MaterialSetsPerPool;
+
+            VkDescriptorPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            poolInfo.flags = 0;
+            poolInfo.poolSizeCount = 1;
+            poolInfo.pPoolSizes = &poolSize;
+            poolInfo.maxSets = s_MaterialSetsPerPool;
+
+            VkDescriptorPool pool{ VK_NULL_HANDLE };
+            CheckVulkanResult(
+                vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool),
+                "Material Descriptor Pool was not created");
+
+            m_MaterialPools.push_back(pool);
+            m_MaterialPoolUsage = 0;
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = m_MaterialPools.back();
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &m_MaterialSetLayout;
+
+        VkDescriptorSet descriptorSet{ VK_NULL_HANDLE };
+        CheckVulkanResult(
+            vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet),
+            "Material Descriptor Set was not allocated");
+
+        ++m_MaterialPoolUsage;
+        return descriptorSet;
+    }
+
+    void VulkanScene::SortDraws()
+    {
+        m_Draws.clear();
+        m_Draws.reserve(m_Objects.GetCount());
+
+        for (uint32_t i{ 0 }; i < m_Objects.GetCapacity(); ++i)
+        {
+            if (m_Objects.IsAlive(i))
+            {
+                m_Draws.push_back(DrawItem{ MakeSortKey(m_Objects.At(i)), i });
+            }
+        }
+
+        std::sort(m_Draws.begin(), m_Draws.end(),
+            [](const DrawItem& a_, const DrawItem& b_) { return a_.sortKey < b_.sortKey; });
+
+        m_ObjectDraws.resize(m_Objects.GetCapacity());
+        for (uint32_t i{ 0 }; i < m_Draws.size(); ++i)
+        {
+            m_ObjectDraws[m_Draws[i].object] = i;
+        }
+
+        m_DrawsDirty = false;
+    }
+
+    void VulkanScene::CullDraws(const glm::mat4& viewProjection_)
+    {
+        m_DrawSpheres.Clear();
+        m_DrawLods.assign(m_Draws.size(), 0);
+        for (size_t i{ 0 }; i < m_Draws.size(); ++i)
+        {
+            const SceneObject& object{ m_Objects.At(m_Draws[i].object) };
+            const VulkanModel* mesh{ m_Meshes.Get(object.mesh) };
+            if (!mesh)
+            {
+                // Keeps the entries aligned with the draws, the batch loop skips it anyway
+                m_DrawSpheres.Push(glm::vec3{ 0.f }, 0.f);
+                continue;
+            }
+
+            // The radius grows with the largest axis scale of the transform
+            const MeshBounds& bounds{ mesh->GetBounds() };
+            const glm::mat4& transform{ object.transform };
+            float scaleSquared{ 0.f };
+            for (int axis{ 0 }; axis < 3; ++axis)
+            {
+                const glm::vec4& column{ transform[axis] };
+                scaleSquared = std::max(scaleSquared, column.x * column.x + column.y * column.y + column.z * column.z);
+            }
+
+            const float scale{ std::sqrt(scaleSquared) };
+            const glm::vec3 center{ transform * glm::vec4{ bounds.center, 1.f } };
+            m_DrawSpheres.Push(center, bounds.radius * scale);
+
+            // Distance to the nearest point of the sphere, inside it the finest LOD is used
+            const float distance{ std::max(glm::length(center - m_CameraPosition) - bounds.radius * scale, 0.f) };
+            m_DrawLods[i] = static_cast<uint8_t>(SelectLod(mesh->GetLods(), distance, scale, m_LodScale));
+        }
+
+        m_DrawSpheres.Cull(ExtractFrustum(viewProjection_), m_DrawVisible);
+
+        m_VisibleObjectCount = 0;
+        for (size_t i{ 0 }; i < m_Draws.size(); ++i)
+        {
+            m_VisibleObjectCount += m_DrawVisible[i];
+        }
+    }
+
+    void VulkanScene::WriteInstance(InstanceData& instance_, uint32_t object_) const
+    {
+        const SceneObject& object{ m_Objects.At(object_) };
+        instance_.model = object.transform;
+
+        // Bounds are known as soon as the mesh is loaded, before its upload completed
+        const VulkanModel* mesh{ m_Meshes.Get(object.mesh) };
+        if (mesh)
+        {
+            const VertexDequantization dequantization{ GetDequantization(mesh->GetBounds()) };
+            instance_.positionOffset = dequantization.offset;
+            instance_.positionScale = dequantization.scale;
+        }
+    }
+
+    void VulkanScene::PrepareGpuDraws(uint32_t frameIndex_, const glm::mat4& viewProjection_)
+    {
+        bool rebuild{ m_DrawsDirty };
+        if (m_DrawsDirty)
+        {
+            SortDraws();
+        }
+
+        // Polled only while uploads are outstanding
+        if (m_ReadyAssetCount != m_Meshes.GetCount() + m_Materials.GetCount())
+        {
+            const uint32_t readyAssetCount{ CountReadyAssets() };
+            rebuild |= readyAssetCount != m_ReadyAssetCount;
+            m_ReadyAssetCount = readyAssetCount;
+        }
+
+        if (rebuild)
+        {
+            BuildDrawInfos();
+        }
+
+        const uint32_t drawCount{ static_cast<uint32_t>(m_Draws.size()) };
+        InstanceBuffer& instanceBuffer{ m_InstanceBuffers[frameIndex_] };
+        CullBuffers& cullBuffers{ m_CullBuffers[frameIndex_] };
+
+        const bool instancesReplaced{ ReserveInstances(instanceBuffer, drawCount) };
+        if (ReserveCullBuffers(cullBuffers, drawCount, m_CommandCount, static_cast<uint32_t>(m_ClusterInfos.size()),
+            static_cast<uint32_t>(m_Buckets.size())) || instancesReplaced)
+        {
+            WriteCullDescriptorSet(instanceBuffer, cullBuffers);
+            cullBuffers.rewrite = true;
+        }
+        WriteDepthPyramidDescriptor(cullBuffers);
+
+        // Instances are indexed by sorted draw, cull.comp passes the index on as firstInstance
+        InstanceData* instances{ static_cast<InstanceData*>(instanceBuffer.allocation.mapped) };
+        if (cullBuffers.rewrite)
+        {
+            for (uint32_t i{ 0 }; i < drawCount; ++i)
+            {
+                WriteInstance(instances[i], m_Draws[i].object);
+            }
+            memcpy(cullBuffers.drawInfoAllocation.mapped, m_DrawInfos.data(), sizeof(GpuDrawInfo) * m_DrawInfos.size());
+            memcpy(cullBuffers.clusterInfoAllocation.mapped, m_ClusterInfos.data(),
+                sizeof(GpuClusterInfo) * m_ClusterInfos.size());
+            cullBuffers.rewrite = false;
+        }
+        else
+        {
+            for (auto&& draw : cullBuffers.dirtyDraws)
+            {
+                WriteInstance(instances[draw], m_Draws[draw].object);
+            }
+        }
+        cullBuffers.dirtyDraws.clear();
+
+        m_BatchInstanceSet = instanceBuffer.descriptorSet;
+        m_CullViewProjection = viewProjection_;
+    }
+
+    void VulkanScene::BuildDrawInfos()
+    {
+        m_DrawInfos.assign(m_Draws.size(), GpuDrawInfo{});
+        m_Buckets.clear();
+        m_ClusterInfos.clear();
+        m_CommandCount = 0;
+
+        // First meshlet of every mesh slot already added
+        std::unordered_map<uint32_t, uint32_t> meshClusters;
+
+        uint64_t bucketKey{ UINT64_MAX };
+        for (uint32_t i{ 0 }; i < m_Draws.size(); ++i)
+        {
+            const SceneObject& object{ m_Objects.At(m_Draws[i].object) };
+
+            // Pipeline and material are the upper bits of the sort key
+            if (m_Draws[i].sortKey >> 24 != bucketKey)
+            {
+                bucketKey = m_Draws[i].sortKey >> 24;
+                m_Buckets.push_back(DrawBucket{ object.pipeline, object.material.index, m_CommandCount, 0 });
+            }
+
+            DrawBucket& bucket{ m_Buckets.back() };
+
+            GpuDrawInfo& drawInfo{ m_DrawInfos[i] };
+            drawInfo.bucket = static_cast<uint32_t>(m_Buckets.size() - 1);
+            drawInfo.firstCommand = bucket.firstCommand;
+
+            const VulkanModel* mesh{ m_Meshes.Get(object.mesh) };
+            const VulkanMaterial* material{ m_Materials.Get(object.material) };
+            if (!mesh || !material || !mesh->IsReady() || !material->IsReady())
+            {
+                ++bucket.commandCount;
+                ++m_CommandCount;
+                continue;
+            }
+
+            const MeshBounds& bounds{ mesh->GetBounds() };
+            const GeometryRange& geometry{ mesh->GetGeometry() };
+            drawInfo.sphere = glm::vec4{ bounds.center, bounds.radius };
+            drawInfo.vertexOffset = geometry.vertexOffset;
+            drawInfo.lodCount = static_cast<uint32_t>(mesh->GetLods().size());
+            for (uint32_t lod{ 0 }; lod < drawInfo.lodCount; ++lod)
+            {
+                drawInfo.lods[lod] = mesh->GetLods()[lod];
+                drawInfo.lods[lod].firstIndex += geometry.firstIndex;
+            }
+
+            // A single meshlet culls no better than the whole draw
+            const std::vector<Meshlet>& meshlets{ mesh->GetMeshlets() };
+            if (meshlets.size() > 1)
+            {
+                auto&& [cluster, added]{ meshClusters.try_emplace(object.mesh.index,
+                    static_cast<uint32_t>(m_ClusterInfos.size())) };
+                if (added)
+                {
+                    for (auto&& meshlet : meshlets)
+                    {
+                        m_ClusterInfos.push_back(GpuClusterInfo{ meshlet.sphere, meshlet.cone,
+                            geometry.firstIndex + meshlet.firstIndex, meshlet.indexCount, {} });
+                    }
+                }
+
+                drawInfo.firstCluster = cluster->second;
+                drawInfo.clusterCount = static_cast<uint32_t>(meshlets.size());
+            }
+
+            const uint32_t commandCount{ std::max(drawInfo.clusterCount, 1u) };
+            bucket.commandCount += commandCount;
+            m_CommandCount += commandCount;
+        }
+
+        for (auto&& cullBuffers : m_CullBuffers)
+        {
+            cullBuffers.rewrite = true;
+        }
+    }
+
+    uint32_t VulkanScene::CountReadyAssets()
+    {
+        uint32_t readyAssetCount{ 0 };
+        m_Meshes.ForEach([&](MeshHandle, VulkanModel& mesh_) { readyAssetCount += mesh_.IsReady(); });
+        m_Materials.ForEach([&](MaterialHandle, VulkanMaterial& material_) { readyAssetCount += material_.IsReady(); });
+        return readyAssetCount;
+    }
+}
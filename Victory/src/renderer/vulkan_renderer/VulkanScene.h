@@ -0,0 +1,364 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <glm/mat4x4.hpp>
+
+#include "SlotMap.h"
+#include "VulkanModel.h"
+#include "VulkanMaterial.h"
+#include "FrustumCulling.h"
+
+namespace Victory
+{
+    class VulkanDevice;
+
+    struct MeshTag {};
+    struct MaterialTag {};
+    struct ObjectTag {};
+
+    using MeshHandle = Handle<MeshTag>;
+    using MaterialHandle = Handle<MaterialTag>;
+    using ObjectHandle = Handle<ObjectTag>;
+
+    // Per instance data read by graphics.vert through gl_InstanceIndex, std430 layout.
+    // Vertex positions are dequantized with the offset and scale of the mesh
+    struct InstanceData
+    {
+        glm::mat4 model;
+        glm::vec4 positionOffset;
+        glm::vec4 positionScale;
+    };
+
+    // Per draw data read by cull.comp, std430 layout. The object space bounding sphere and
+    // the draw arguments of every LOD of the mesh, lodCount stays 0 until mesh and material
+    // are ready. LOD index ranges are absolute in the geometry pool.
+    // [firstCluster, firstCluster + clusterCount) are the meshlets of LOD 0, none when the
+    // mesh has a single one
+    struct GpuDrawInfo
+    {
+        glm::vec4 sphere;
+        int32_t vertexOffset;
+        uint32_t bucket;
+        uint32_t firstCommand;
+        uint32_t lodCount;
+        MeshLod lods[s_MaxMeshLodCount];
+        uint32_t firstCluster;
+        uint32_t clusterCount;
+        uint32_t padding[2];
+    };
+
+    // A meshlet as cull.comp reads it, std430 layout. Stored once per mesh and shared by
+    // every draw of it, the index range is absolute in the geometry pool
+    struct GpuClusterInfo
+    {
+        glm::vec4 sphere;
+        glm::vec4 cone;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        uint32_t padding[2];
+    };
+
+    // Camera of a frame as graphics.vert sees it in its UniformBufferObject.
+    // The viewport height turns LOD errors into pixels
+    struct SceneView
+    {
+        glm::mat4 view;
+        glm::mat4 proj;
+        uint32_t viewportHeight;
+    };
+
+    // Occlusion culling draws in two phases. Early are the draws visible against the depth
+    // pyramid of the last frame, late the ones it hid that the pyramid of this frame shows
+    enum class CullPhase
+    {
+        eEarly,
+        eLate
+    };
+
+    // GPU driven, read back from the last completed frame
+    struct CullStats
+    {
+        uint32_t earlyVisible{ 0 };
+        uint32_t lateVisible{ 0 };
+        uint32_t frustumCulled{ 0 };
+        uint32_t occluded{ 0 };
+        // Meshlets of visible draws drawn at LOD 0
+        uint32_t clustersVisible{ 0 };
+        uint32_t clustersCulled{ 0 };
+    };
+
+    struct SceneObject
+    {
+        MeshHandle mesh{};
+        MaterialHandle material{};
+        // Index into the pipelines handed to RecordDraws
+        uint32_t pipeline{ 0 };
+        glm::mat4 transform{ 1.f };
+    };
+
+    // Owns meshes, material instances and the objects that place them. Everything is
+    // addressed by handles that stay valid while other entries come and go.
+    // Meshes and textures are loaded once per path and shared by every object using them.
+    //
+    // With indirect count draws the scene is GPU driven: cull.comp tests every draw against
+    // the frustum and writes the draw commands of the visible ones, one indirect count draw
+    // per pipeline and material consumes them. Per frame the CPU only rewrites the transforms
+    // that changed, so its cost does not grow with the object count.
+    //
+    // With occlusion culling the draws are also tested against a depth pyramid, see CullPhase.
+    // Visible draws at LOD 0 are split further, each of their meshlets is tested against the
+    // frustum and its normal cone and gets a draw command of its own
+    class VulkanScene
+    {
+    public:
+
+        // Draws use the coarsest LOD whose error projects to at most lodErrorPixels_
+        VulkanScene(VulkanDevice* vulkanDevice_, uint32_t framesInFlight_, bool occlusionCulling_ = false,
+            float lodErrorPixels_ = 1.f);
+
+        // A path loaded before keeps the LODs it was loaded with
+        MeshHandle LoadMesh(const std::string& path_, uint32_t lodLimit_);
+        MaterialHandle LoadMaterial(const std::string& texturePath_);
+
+        ObjectHandle CreateObject(MeshHandle mesh_, MaterialHandle material_,
+            const glm::mat4& transform_ = glm::mat4{ 1.f }, uint32_t pipeline_ = 0);
+        void DestroyObject(ObjectHandle object_);
+
+        void SetTransform(ObjectHandle object_, const glm::mat4& transform_);
+
+        // Turns every object whose uploads completed and whose bounding sphere intersects
+        // the view frustum into draw batches. Objects are sorted by pipeline, material and
+        // mesh, so each of them is bound only when it changes, and objects sharing all three
+        // and the LOD picked for them go out as one instanced draw. GPU driven, a batch is
+        // every draw of a pipeline and material and culling is left to RecordCulling.
+        // Writes the buffers of frameIndex_, runs on the recording thread only
+        void PrepareDraws(uint32_t frameIndex_, const SceneView& view_);
+
+        // Records the culling dispatches of the last PrepareDraws, draws then their meshlets,
+        // outside of a render pass and before the batches of the phase are recorded.
+        // Does nothing when the CPU culls.
+        // The early phase reads the depth pyramid as the last frame left it, the late
+        // phase the one built from the early draws
+        void RecordCulling(VkCommandBuffer commandBuffer_, CullPhase phase_ = CullPhase::eEarly) const;
+
+        // Records batches [begin_, end_) of the last PrepareDraws. Safe to call from
+        // several threads at once for disjoint ranges and command buffers.
+        // Set 0 is left to the caller, the instance buffer is bound at set 1 and
+        // materials at set 2
+        void RecordBatches(VkCommandBuffer commandBuffer_, VkPipelineLayout pipelineLayout_,
+            std::span<const VkPipeline> pipelines_, uint32_t begin_, uint32_t end_,
+            CullPhase phase_ = CullPhase::eEarly) const;
+
+        // GPU driven only, the pyramid in general layout and the viewport it covers.
+        // Frames pick it up once their own culling set is free again
+        void SetDepthPyramid(VkImageView view_, VkSampler sampler_, VkExtent2D viewportExtent_);
+
+        inline uint32_t GetBatchCount() const
+        {
+            return static_cast<uint32_t>(IsGpuDriven() ? m_Buckets.size() : m_Batches.size());
+        }
+
+        inline bool IsGpuDriven() const
+        {
+            return m_CullPipeline != VK_NULL_HANDLE;
+        }
+
+        // Requested and GPU driven
+        inline bool IsOcclusionCulling() const
+        {
+            return m_OcclusionCulling && IsGpuDriven();
+        }
+
+        void CleanupAll();
+
+        inline VkDescriptorSetLayout GetInstanceSetLayout() const
+        {
+            return m_InstanceSetLayout;
+        }
+
+        inline VkDescriptorSetLayout GetMaterialSetLayout() const
+        {
+            return m_MaterialSetLayout;
+        }
+
+        inline uint32_t GetObjectCount() const
+        {
+            return m_Objects.GetCount();
+        }
+
+        // Objects that passed culling in the last PrepareDraws. GPU driven, the count is read
+        // back from the GPU and only valid once the frame of that PrepareDraws completed
+        uint32_t GetVisibleObjectCount() const;
+        CullStats GetCullStats() const;
+
+    private:
+
+        struct DrawItem
+        {
+            uint64_t sortKey;
+            uint32_t object;
+        };
+
+        // One instanced draw, resources are referenced by slot
+        struct DrawBatch
+        {
+            uint32_t pipeline;
+            uint32_t material;
+            uint32_t mesh;
+            uint32_t lod;
+            uint32_t firstInstance;
+            uint32_t instanceCount;
+        };
+
+        // Consecutive sorted draws sharing pipeline and material. Commands of its visible
+        // draws are written to [firstCommand, firstCommand + commandCount), their number
+        // to the slot of the bucket in the count buffer. A draw takes one command, or one
+        // per meshlet when it has them
+        struct DrawBucket
+        {
+            uint32_t pipeline;
+            uint32_t material;
+            uint32_t firstCommand;
+            uint32_t commandCount;
+        };
+
+        // Host visible, one per frame in flight so the CPU never writes what the GPU reads
+        struct InstanceBuffer
+        {
+            VkBuffer buffer{ VK_NULL_HANDLE };
+            VulkanAllocation allocation{};
+            uint32_t capacity{ 0 };
+            VkDescriptorSet descriptorSet{ VK_NULL_HANDLE };
+        };
+
+        // GPU driven only, one per frame in flight as well. Draw infos are host visible,
+        // commands and counts stay on the GPU and the counts are copied back for statistics.
+        // Commands and counts have an early and a late half, see CullPhase
+        struct CullBuffers
+        {
+            VkBuffer drawInfoBuffer{ VK_NULL_HANDLE };
+            VulkanAllocation drawInfoAllocation{};
+            VkBuffer occludedBuffer{ VK_NULL_HANDLE };
+            VulkanAllocation occludedAllocation{};
+            VkBuffer clusterPhaseBuffer{ VK_NULL_HANDLE };
+            VulkanAllocation clusterPhaseAllocation{};
+            uint32_t drawCapacity{ 0 };
+
+            VkBuffer commandBuffer{ VK_NULL_HANDLE };
+            VulkanAllocation commandAllocation{};
+            uint32_t commandCapacity{ 0 };
+
+            VkBuffer clusterInfoBuffer{ VK_NULL_HANDLE };
+            VulkanAllocation clusterInfoAllocation{};
+            uint32_t clusterCapacity{ 0 };
+
+            VkBuffer countBuffer{ VK_NULL_HANDLE };
+            VulkanAllocation countAllocation{};
+            VkBuffer countReadbackBuffer{ VK_NULL_HANDLE };
+            VulkanAllocation countReadbackAllocation{};
+            uint32_t bucketCapacity{ 0 };
+
+            VkDescriptorSet descriptorSet{ VK_NULL_HANDLE };
+            uint32_t depthPyramidGeneration{ 0 };
+
+            // Draws whose transform changed since the frame last wrote its instances
+            std::vector<uint32_t> dirtyDraws;
+            bool rewrite{ true };
+        };
+
+        void CreateInstanceBuffers(uint32_t framesInFlight_);
+        // True if the buffer was replaced, its contents are gone then
+        bool ReserveInstances(InstanceBuffer& instanceBuffer_, uint32_t count_);
+
+        void CreateCullPipeline(uint32_t framesInFlight_);
+        bool ReserveCullBuffers(CullBuffers& cullBuffers_, uint32_t drawCount_, uint32_t commandCount_,
+            uint32_t clusterCount_, uint32_t bucketCount_);
+        void WriteCullDescriptorSet(const InstanceBuffer& instanceBuffer_, const CullBuffers& cullBuffers_);
+        void WriteDepthPyramidDescriptor(CullBuffers& cullBuffers_);
+        void DestroyCullBuffers(CullBuffers& cullBuffers_);
+
+        void CreateMaterialSetLayout();
+        void CreateSampler();
+        VkDescriptorSet AllocateMaterialSet();
+
+        void SortDraws();
+        void CullDraws(const glm::mat4& viewProjection_);
+
+        void WriteInstance(InstanceData& instance_, uint32_t object_) const;
+        void PrepareGpuDraws(uint32_t frameIndex_, const glm::mat4& viewProjection_);
+        void BuildDrawInfos();
+        uint32_t CountReadyAssets();
+
+    private:
+
+        VulkanDevice* m_VulkanDevice;
+
+        VulkanGeometryPool* m_GeometryPool{ nullptr };
+
+        SlotMap<VulkanModel, MeshTag> m_Meshes;
+        SlotMap<VulkanMaterial, MaterialTag> m_Materials;
+        SlotMap<SceneObject, ObjectTag> m_Objects;
+
+        std::unordered_map<std::string, MeshHandle> m_MeshPaths;
+        std::unordered_map<std::string, MaterialHandle> m_MaterialPaths;
+
+        VkDescriptorSetLayout m_InstanceSetLayout{ VK_NULL_HANDLE };
+        VkDescriptorPool m_InstancePool{ VK_NULL_HANDLE };
+        std::vector<InstanceBuffer> m_InstanceBuffers;
+
+        VkDescriptorSetLayout m_MaterialSetLayout{ VK_NULL_HANDLE };
+        VkSampler m_Sampler{ VK_NULL_HANDLE };
+
+        // Material sets come from fixed size pools, a new pool is added once the last is full
+        std::vector<VkDescriptorPool> m_MaterialPools;
+        uint32_t m_MaterialPoolUsage{ 0 };
+
+        std::vector<DrawItem> m_Draws;
+        std::vector<DrawBatch> m_Batches;
+        // Sorted draw of every object slot
+        std::vector<uint32_t> m_ObjectDraws;
+        uint32_t m_PreparedFrame{ 0 };
+
+        // One entry per sorted draw
+        BoundingSphereArray m_DrawSpheres;
+        std::vector<uint8_t> m_DrawVisible;
+        std::vector<uint8_t> m_DrawLods;
+        uint32_t m_VisibleObjectCount{ 0 };
+        VkDescriptorSet m_BatchInstanceSet{ VK_NULL_HANDLE };
+        bool m_DrawsDirty{ true };
+
+        // GPU driven path, m_CullPipeline stays null without indirect count draws
+        VkDescriptorSetLayout m_CullSetLayout{ VK_NULL_HANDLE };
+        VkDescriptorPool m_CullPool{ VK_NULL_HANDLE };
+        VkPipelineLayout m_CullPipelineLayout{ VK_NULL_HANDLE };
+        VkPipeline m_CullPipeline{ VK_NULL_HANDLE };
+        std::vector<CullBuffers> m_CullBuffers;
+        bool m_OcclusionCulling{ false };
+
+        // Bumped by SetDepthPyramid, culling sets still pointing at an older one are rewritten
+        VkImageView m_DepthPyramidView{ VK_NULL_HANDLE };
+        VkSampler m_DepthPyramidSampler{ VK_NULL_HANDLE };
+        VkExtent2D m_DepthPyramidExtent{ 0, 0 };
+        uint32_t m_DepthPyramidGeneration{ 0 };
+
+        // One entry per sorted draw
+        std::vector<GpuDrawInfo> m_DrawInfos;
+        std::vector<DrawBucket> m_Buckets;
+        // Meshlets of every ready mesh, draws of a mesh share its range
+        std::vector<GpuClusterInfo> m_ClusterInfos;
+        // Command slots of all buckets, the late commands start here
+        uint32_t m_CommandCount{ 0 };
+        glm::mat4 m_CullViewProjection{ 1.f };
+
+        // Camera of the last PrepareDraws, a LOD error times the scale is pixels at distance 1
+        float m_LodErrorPixels{ 1.f };
+        glm::vec3 m_CameraPosition{ 0.f };
+        float m_LodScale{ 0.f };
+        // Meshes and materials found ready, draw infos are rebuilt when it changes
+        uint32_t m_ReadyAssetCount{ 0 };
+    };
+}
@@ -54,7 +54,7 @@ namespace Victory{
         }
     }
 
-    void VulkanSwapchain::CreateSwapchain() {
+    void VulkanSwapchain::CreateSwapchain(VkSwapchainKHR oldSwapchain_) {
         VkSurfaceCapabilitiesKHR capabilities;
         vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_VulkanDevice->GetPhysicalDevice(), m_Surface, &capabilities);
 
@@ -62,7 +62,8 @@ namespace Victory{
         ChooseSwapchainSurfaceFormat();
         ChoosePresentationModeFormat();
 
-        m_ImageCount = capabilities.minImageCount + 1;
+        m_ImageCount = m_RequestedImageCount ? 
+            std::max(m_RequestedImageCount, capabilities.minImageCount) : capabilities.minImageCount + 1;
         if (capabilities.maxImageCount > 0 && m_ImageCount > capabilities.maxImageCount) {
             m_ImageCount = capabilities.maxImageCount;
         }
@@ -98,17 +99,17 @@ namespace Victory{
         swapchainCI.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
         swapchainCI.presentMode = m_PresentMode;
         swapchainCI.clipped = VK_TRUE;
-        swapchainCI.oldSwapchain = VK_NULL_HANDLE;
+        swapchainCI.oldSwapchain = oldSwapchain_;
 
         CheckVulkanResult(vkCreateSwapchainKHR(m_VulkanDevice->GetDevice(), &swapchainCI, nullptr, &m_Swapchain),
             "Swapchain was not created");
     }
 
-    void VulkanSwapchain::RecreateSwapchain() {
-        VkDevice device = m_VulkanDevice->GetDevice();
-        vkDeviceWaitIdle(device);
-        vkDestroySwapchainKHR(device, m_Swapchain, nullptr);
-        CreateSwapchain();
+    VkSwapchainKHR VulkanSwapchain::RecreateSwapchain() {
+        VkSwapchainKHR oldSwapchain{ m_Swapchain };
+        CreateSwapchain(oldSwapchain);
+
+        return oldSwapchain;
     }
 
     void VulkanSwapchain::ChooseSwapchainExtent(VkSurfaceCapabilitiesKHR capabilities_) {
@@ -14,9 +14,16 @@ namespace Victory {
         static void Cleanup();
 
         void CreateSurface();
-        void CreateSwapchain();
+        void CreateSwapchain(VkSwapchainKHR oldSwapchain_ = VK_NULL_HANDLE);
 
-        void RecreateSwapchain();
+        // Images asked for by the next CreateSwapchain, 0 is minImageCount + 1
+        inline void SetRequestedImageCount(uint32_t imageCount_) {
+            m_RequestedImageCount = imageCount_;
+        }
+
+        // Hands the old swapchain to the new one without idling the device. Frames in
+        // flight may still present its images, the caller destroys it once they completed
+        VkSwapchainKHR RecreateSwapchain();
 
         inline VkSurfaceKHR GetSurface() const {
             return m_Surface;
@@ -64,5 +71,6 @@ namespace Victory {
         VkPresentModeKHR m_PresentMode;
 
         uint32_t m_ImageCount;
+        uint32_t m_RequestedImageCount{ 0 };
     };
 }
\ No newline at end of file
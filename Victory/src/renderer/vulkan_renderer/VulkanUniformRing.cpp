@@ -0,0 +1,64 @@
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "VulkanUniformRing.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "VulkanDevice.h"
+
+namespace Victory
+{
+    VulkanUniformRing::VulkanUniformRing(VulkanDevice* vulkanDevice_,
+        uint32_t framesInFlight_, VkDeviceSize frameSize_)
+        : m_VulkanDevice{ vulkanDevice_ }
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(m_VulkanDevice->GetPhysicalDevice(), &properties);
+
+        // Both limits are powers of two, so the larger one satisfies both
+        m_Alignment = std::max(properties.limits.minUniformBufferOffsetAlignment,
+            properties.limits.minStorageBufferOffsetAlignment);
+        m_FrameSize = (frameSize_ + m_Alignment - 1) & ~(m_Alignment - 1);
+
+        VkBufferCreateInfo bufferCI{};
+        bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCI.size = m_FrameSize * framesInFlight_;
+        bufferCI.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        // Coherent, so writes need no flush before the submit
+        m_VulkanDevice->GetAllocator()->CreateBuffer(bufferCI,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            m_Buffer, m_Allocation);
+    }
+
+    VulkanUniformRing::~VulkanUniformRing()
+    {
+        m_VulkanDevice->GetAllocator()->DestroyBuffer(m_Buffer, m_Allocation);
+    }
+
+    void VulkanUniformRing::BeginFrame(uint32_t frameIndex_)
+    {
+        m_FrameBegin = m_FrameSize * frameIndex_;
+        m_Head.store(m_FrameBegin, std::memory_order_relaxed);
+    }
+
+    UniformRingAllocation VulkanUniformRing::Allocate(VkDeviceSize size_)
+    {
+        const VkDeviceSize alignedSize{ (size_ + m_Alignment - 1) & ~(m_Alignment - 1) };
+        const VkDeviceSize offset{ m_Head.fetch_add(alignedSize, std::memory_order_relaxed) };
+
+        if (offset + alignedSize > m_FrameBegin + m_FrameSize)
+        {
+            throw std::runtime_error("Uniform ring frame partition is full");
+        }
+
+        UniformRingAllocation allocation{};
+        allocation.mapped = static_cast<char*>(m_Allocation.mapped) + offset;
+        allocation.offset = static_cast<uint32_t>(offset);
+
+        return allocation;
+    }
+}
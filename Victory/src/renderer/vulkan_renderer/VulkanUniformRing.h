@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include "VulkanAllocator.h"
+
+namespace Victory
+{
+    class VulkanDevice;
+
+    struct UniformRingAllocation
+    {
+        void* mapped{ nullptr };
+        // Dynamic offset to bind the ring buffer descriptor with
+        uint32_t offset{ 0 };
+    };
+
+    // One persistently mapped buffer split into a partition per frame in flight.
+    // Allocations bump through the partition of the current frame, so the CPU never
+    // writes memory the GPU may still read, and nothing is allocated per frame.
+    // Descriptors point at the buffer once and select data with dynamic offsets
+    class VulkanUniformRing
+    {
+    public:
+
+        VulkanUniformRing(VulkanDevice* vulkanDevice_, uint32_t framesInFlight_, VkDeviceSize frameSize_);
+        ~VulkanUniformRing();
+
+        // Rewinds the partition of frameIndex_, the fence of that frame must have signaled
+        void BeginFrame(uint32_t frameIndex_);
+
+        // Thread safe, the offset is aligned for both uniform and storage buffers
+        UniformRingAllocation Allocate(VkDeviceSize size_);
+
+        template<typename T>
+        uint32_t Push(const T& data_)
+        {
+            const UniformRingAllocation allocation{ Allocate(sizeof(T)) };
+            memcpy(allocation.mapped, &data_, sizeof(T));
+            return allocation.offset;
+        }
+
+        inline VkBuffer GetBuffer() const
+        {
+            return m_Buffer;
+        }
+
+        // Bytes the current frame allocated so far
+        inline VkDeviceSize GetFrameUsage() const
+        {
+            return m_Head.load(std::memory_order_relaxed) - m_FrameBegin;
+        }
+
+    private:
+
+        VulkanDevice* m_VulkanDevice{ nullptr };
+
+        VkBuffer m_Buffer{ VK_NULL_HANDLE };
+        VulkanAllocation m_Allocation{};
+
+        VkDeviceSize m_Alignment{ 0 };
+        VkDeviceSize m_FrameSize{ 0 };
+
+        VkDeviceSize m_FrameBegin{ 0 };
+        std::atomic<VkDeviceSize> m_Head{ 0 };
+    };
+}
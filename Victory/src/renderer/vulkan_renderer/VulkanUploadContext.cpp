@@ -0,0 +1,396 @@
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "VulkanUploadContext.h"
+
+#include <cstring>
+
+#include "VulkanDevice.h"
+#include "VulkanUtils.h"
+
+namespace Victory
+{
+    static VkCommandPool CreateUploadCommandPool(VkDevice device_, uint32_t queueFamily_)
+    {
+        VkCommandPoolCreateInfo commandPoolCI{};
+        commandPoolCI.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        commandPoolCI.pNext = nullptr;
+        commandPoolCI.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT |
+            VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        commandPoolCI.queueFamilyIndex = queueFamily_;
+
+        VkCommandPool commandPool{ VK_NULL_HANDLE };
+        CheckVulkanResult(
+            vkCreateCommandPool(device_, &commandPoolCI, nullptr, &commandPool),
+            "Upload command pool was not created");
+
+        return commandPool;
+    }
+
+    static VkCommandBuffer AllocateUploadCommandBuffer(VkDevice device_, VkCommandPool commandPool_)
+    {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = commandPool_;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer{ VK_NULL_HANDLE };
+        CheckVulkanResult(
+            vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer),
+            "Upload command buffer was not allocated");
+
+        return commandBuffer;
+    }
+
+    VulkanUploadContext::VulkanUploadContext(VulkanDevice* vulkanDevice_)
+        : m_VulkanDevice{ vulkanDevice_ }
+    {
+        VkDevice device{ m_VulkanDevice->GetDevice() };
+
+        m_GraphicsFamily = m_VulkanDevice->GetQueueIndex(QueueIndex::eGraphics);
+        m_TransferFamily = m_VulkanDevice->GetQueueIndex(QueueIndex::eTransfer);
+
+        m_VulkanDevice->GetQueue(m_GraphicsQueue, QueueIndex::eGraphics);
+        m_GraphicsCommandPool = CreateUploadCommandPool(device, m_GraphicsFamily);
+
+        if (HasDedicatedTransferQueue())
+        {
+            m_VulkanDevice->GetQueue(m_TransferQueue, QueueIndex::eTransfer);
+            m_TransferCommandPool = CreateUploadCommandPool(device, m_TransferFamily);
+        }
+        else
+        {
+            m_TransferQueue = m_GraphicsQueue;
+            m_TransferCommandPool = m_GraphicsCommandPool;
+        }
+    }
+
+    VulkanUploadContext::~VulkanUploadContext()
+    {
+        if (m_HasOpenBatch)
+        {
+            Submit();
+        }
+        WaitIdle();
+
+        VkDevice device{ m_VulkanDevice->GetDevice() };
+        for (auto&& batch : m_FreeBatches)
+        {
+            vkDestroySemaphore(device, batch.transferFinished, nullptr);
+            vkDestroyFence(device, batch.fence, nullptr);
+        }
+
+        if (HasDedicatedTransferQueue())
+        {
+            vkDestroyCommandPool(device, m_TransferCommandPool, nullptr);
+        }
+        vkDestroyCommandPool(device, m_GraphicsCommandPool, nullptr);
+    }
+
+    VkCommandBuffer VulkanUploadContext::GetTransferCommandBuffer()
+    {
+        if (!m_HasOpenBatch)
+        {
+            BeginBatch();
+        }
+        return m_OpenBatch.transferCommandBuffer;
+    }
+
+    VkCommandBuffer VulkanUploadContext::GetGraphicsCommandBuffer()
+    {
+        if (!m_HasOpenBatch)
+        {
+            BeginBatch();
+        }
+        return m_OpenBatch.graphicsCommandBuffer;
+    }
+
+    VkBuffer VulkanUploadContext::Stage(const void* data_, VkDeviceSize size_)
+    {
+        VkBufferCreateInfo bufferCI{};
+        bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCI.size = size_;
+        bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VulkanStagingBuffer staging{};
+        m_VulkanDevice->GetAllocator()->CreateBuffer(bufferCI,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            staging.buffer, staging.allocation, AllocationStrategy::eLinear);
+
+        memcpy(staging.allocation.mapped, data_, static_cast<size_t>(size_));
+
+        // Make sure the buffer is owned by a batch before anything records a copy from it
+        if (!m_HasOpenBatch)
+        {
+            BeginBatch();
+        }
+        m_OpenBatch.stagingBuffers.emplace_back(staging);
+
+        return staging.buffer;
+    }
+
+    void VulkanUploadContext::UploadBuffer(const void* data_, VkDeviceSize size_,
+        VkBuffer dstBuffer_, VkDeviceSize dstOffset_)
+    {
+        VkBuffer stagingBuffer{ Stage(data_, size_) };
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = 0;
+        copyRegion.dstOffset = dstOffset_;
+        copyRegion.size = size_;
+
+        vkCmdCopyBuffer(GetTransferCommandBuffer(), stagingBuffer, dstBuffer_, 1, &copyRegion);
+
+        TransferOwnership(dstBuffer_, dstOffset_, size_);
+    }
+
+    void VulkanUploadContext::TransferOwnership(VkBuffer buffer_, VkDeviceSize offset_, VkDeviceSize size_)
+    {
+        if (!HasDedicatedTransferQueue())
+        {
+            return;
+        }
+
+        // Release and acquire are recorded right away, so the acquire precedes any
+        // graphics work that is recorded for this resource later on
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.srcQueueFamilyIndex = m_TransferFamily;
+        barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+        barrier.buffer = buffer_;
+        barrier.offset = offset_;
+        barrier.size = size_;
+
+        vkCmdPipelineBarrier(GetTransferCommandBuffer(),
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+            VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(GetGraphicsCommandBuffer(),
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+
+    void VulkanUploadContext::TransferOwnership(VkImage image_,
+        const VkImageSubresourceRange& range_, VkImageLayout layout_)
+    {
+        if (!HasDedicatedTransferQueue())
+        {
+            return;
+        }
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.oldLayout = layout_;
+        barrier.newLayout = layout_;
+        barrier.srcQueueFamilyIndex = m_TransferFamily;
+        barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+        barrier.image = image_;
+        barrier.subresourceRange = range_;
+
+        vkCmdPipelineBarrier(GetTransferCommandBuffer(),
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        // The graphics side may keep blitting into the image (mips), so acquire for transfer too
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT |
+            VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(GetGraphicsCommandBuffer(),
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    UploadTicket VulkanUploadContext::Submit()
+    {
+        if (!m_HasOpenBatch)
+        {
+            return m_LastSubmitted;
+        }
+
+        // Uploads are consumed by later submissions on the graphics queue, make the writes
+        // visible to every stage that reads geometry, uniforms or textures
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+            VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(m_OpenBatch.graphicsCommandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+
+        const VkPipelineStageFlags waitStage{ VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+        if (HasDedicatedTransferQueue())
+        {
+            vkEndCommandBuffer(m_OpenBatch.transferCommandBuffer);
+
+            submitInfo.pCommandBuffers = &m_OpenBatch.transferCommandBuffer;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &m_OpenBatch.transferFinished;
+
+            CheckVulkanResult(
+                vkQueueSubmit(m_TransferQueue, 1, &submitInfo, VK_NULL_HANDLE),
+                "Upload transfer batch was not submitted");
+
+            submitInfo.signalSemaphoreCount = 0;
+            submitInfo.pSignalSemaphores = nullptr;
+            submitInfo.waitSemaphoreCount = 1;
+            submitInfo.pWaitSemaphores = &m_OpenBatch.transferFinished;
+            submitInfo.pWaitDstStageMask = &waitStage;
+        }
+
+        vkEndCommandBuffer(m_OpenBatch.graphicsCommandBuffer);
+        submitInfo.pCommandBuffers = &m_OpenBatch.graphicsCommandBuffer;
+
+        CheckVulkanResult(
+            vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, m_OpenBatch.fence),
+            "Upload batch was not submitted");
+
+        m_OpenBatch.ticket = ++m_LastSubmitted;
+        m_InFlightBatches.emplace_back(std::move(m_OpenBatch));
+        m_OpenBatch = UploadBatch{};
+        m_HasOpenBatch = false;
+
+        return m_LastSubmitted;
+    }
+
+    bool VulkanUploadContext::IsComplete(UploadTicket ticket_)
+    {
+        if (ticket_ <= m_LastCompleted)
+        {
+            return true;
+        }
+
+        RetireCompleted();
+        return ticket_ <= m_LastCompleted;
+    }
+
+    void VulkanUploadContext::Wait(UploadTicket ticket_)
+    {
+        if (ticket_ > m_LastSubmitted)
+        {
+            Submit();
+        }
+
+        VkDevice device{ m_VulkanDevice->GetDevice() };
+        for (auto&& batch : m_InFlightBatches)
+        {
+            if (batch.ticket > ticket_)
+            {
+                break;
+            }
+            vkWaitForFences(device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+        }
+
+        RetireCompleted();
+    }
+
+    void VulkanUploadContext::WaitIdle()
+    {
+        Wait(m_LastSubmitted);
+    }
+
+    void VulkanUploadContext::BeginBatch()
+    {
+        RetireCompleted();
+
+        if (m_FreeBatches.empty())
+        {
+            VkDevice device{ m_VulkanDevice->GetDevice() };
+
+            UploadBatch batch{};
+            batch.graphicsCommandBuffer = AllocateUploadCommandBuffer(device, m_GraphicsCommandPool);
+            batch.transferCommandBuffer = batch.graphicsCommandBuffer;
+
+            if (HasDedicatedTransferQueue())
+            {
+                batch.transferCommandBuffer = AllocateUploadCommandBuffer(device, m_TransferCommandPool);
+
+                VkSemaphoreCreateInfo semaphoreCI{};
+                semaphoreCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+                CheckVulkanResult(
+                    vkCreateSemaphore(device, &semaphoreCI, nullptr, &batch.transferFinished),
+                    "Upload semaphore was not created");
+            }
+
+            VkFenceCreateInfo fenceCI{};
+            fenceCI.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+            CheckVulkanResult(
+                vkCreateFence(device, &fenceCI, nullptr, &batch.fence),
+                "Upload fence was not created");
+
+            m_FreeBatches.emplace_back(std::move(batch));
+        }
+
+        m_OpenBatch = std::move(m_FreeBatches.back());
+        m_FreeBatches.pop_back();
+        m_HasOpenBatch = true;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkBeginCommandBuffer(m_OpenBatch.graphicsCommandBuffer, &beginInfo);
+        if (HasDedicatedTransferQueue())
+        {
+            vkBeginCommandBuffer(m_OpenBatch.transferCommandBuffer, &beginInfo);
+        }
+    }
+
+    void VulkanUploadContext::RetireCompleted()
+    {
+        VkDevice device{ m_VulkanDevice->GetDevice() };
+
+        size_t retired{ 0 };
+        while (retired < m_InFlightBatches.size() &&
+            vkGetFenceStatus(device, m_InFlightBatches[retired].fence) == VK_SUCCESS)
+        {
+            Retire(m_InFlightBatches[retired]);
+            ++retired;
+        }
+
+        m_InFlightBatches.erase(m_InFlightBatches.begin(), m_InFlightBatches.begin() + retired);
+    }
+
+    void VulkanUploadContext::Retire(UploadBatch& batch_)
+    {
+        VulkanAllocator* allocator{ m_VulkanDevice->GetAllocator() };
+        for (auto&& staging : batch_.stagingBuffers)
+        {
+            allocator->DestroyBuffer(staging.buffer, staging.allocation);
+        }
+        batch_.stagingBuffers.clear();
+
+        vkResetFences(m_VulkanDevice->GetDevice(), 1, &batch_.fence);
+        vkResetCommandBuffer(batch_.graphicsCommandBuffer, 0);
+        if (HasDedicatedTransferQueue())
+        {
+            vkResetCommandBuffer(batch_.transferCommandBuffer, 0);
+        }
+
+        m_LastCompleted = batch_.ticket;
+        m_FreeBatches.emplace_back(std::move(batch_));
+    }
+}
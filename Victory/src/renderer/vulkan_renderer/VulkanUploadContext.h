@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+
+#include "VulkanAllocator.h"
+
+namespace Victory
+{
+    class VulkanDevice;
+
+    // Monotonic id of a submitted batch, a ticket is complete once its fence signaled
+    using UploadTicket = uint64_t;
+
+    struct VulkanStagingBuffer
+    {
+        VkBuffer buffer{ VK_NULL_HANDLE };
+        VulkanAllocation allocation{};
+    };
+
+    // Records transfers of many resources into one command buffer and submits them
+    // together. Completion is tracked with a fence per batch, so nothing idles the queue,
+    // and staging memory of a batch is released once its fence signaled.
+    //
+    // With a dedicated transfer queue every batch is split in two: copies run on the
+    // transfer queue and release the resources, the graphics part acquires them and
+    // does the work only graphics can do (blits). The graphics part waits on a semaphore,
+    // so streaming overlaps rendering. With a single queue family both parts are the
+    // same command buffer and no ownership transfer happens
+    class VulkanUploadContext
+    {
+    public:
+
+        explicit VulkanUploadContext(VulkanDevice* vulkanDevice_);
+        ~VulkanUploadContext();
+
+        // Command buffers of the open batch, a new batch is begun if there is none
+        VkCommandBuffer GetTransferCommandBuffer();
+        VkCommandBuffer GetGraphicsCommandBuffer();
+
+        // Copies data_ into staging memory that lives until the batch completes
+        VkBuffer Stage(const void* data_, VkDeviceSize size_);
+        void UploadBuffer(const void* data_, VkDeviceSize size_,
+            VkBuffer dstBuffer_, VkDeviceSize dstOffset_ = 0);
+
+        // Hands a resource written on the transfer command buffer over to the graphics one.
+        // The image keeps layout_, it has to be the layout the transfer part left it in.
+        // Buffers change owner per range, so pooled buffers hand over only what was written
+        void TransferOwnership(VkBuffer buffer_, VkDeviceSize offset_ = 0, VkDeviceSize size_ = VK_WHOLE_SIZE);
+        void TransferOwnership(VkImage image_, const VkImageSubresourceRange& range_, VkImageLayout layout_);
+
+        UploadTicket Submit();
+
+        bool IsComplete(UploadTicket ticket_);
+        void Wait(UploadTicket ticket_);
+        void WaitIdle();
+
+        // Ticket the open batch gets once it is submitted
+        inline UploadTicket GetPendingTicket() const
+        {
+            return m_LastSubmitted + 1;
+        }
+
+        inline bool HasDedicatedTransferQueue() const
+        {
+            return m_TransferFamily != m_GraphicsFamily;
+        }
+
+    private:
+
+        struct UploadBatch
+        {
+            VkCommandBuffer transferCommandBuffer{ VK_NULL_HANDLE };
+            VkCommandBuffer graphicsCommandBuffer{ VK_NULL_HANDLE };
+            VkSemaphore transferFinished{ VK_NULL_HANDLE };
+            VkFence fence{ VK_NULL_HANDLE };
+            UploadTicket ticket{ 0 };
+            std::vector<VulkanStagingBuffer> stagingBuffers;
+        };
+
+        void BeginBatch();
+        void RetireCompleted();
+        void Retire(UploadBatch& batch_);
+
+    private:
+
+        VulkanDevice* m_VulkanDevice{ nullptr };
+
+        uint32_t m_TransferFamily{ 0 };
+        uint32_t m_GraphicsFamily{ 0 };
+
+        VkCommandPool m_TransferCommandPool{ VK_NULL_HANDLE };
+        VkCommandPool m_GraphicsCommandPool{ VK_NULL_HANDLE };
+        VkQueue m_TransferQueue{ VK_NULL_HANDLE };
+        VkQueue m_GraphicsQueue{ VK_NULL_HANDLE };
+
+        bool m_HasOpenBatch{ false };
+        UploadBatch m_OpenBatch{};
+
+        // Submitted batches in ticket order
+        std::vector<UploadBatch> m_InFlightBatches;
+        std::vector<UploadBatch> m_FreeBatches;
+
+        UploadTicket m_LastSubmitted{ 0 };
+        UploadTicket m_LastCompleted{ 0 };
+    };
+}
@@ -3,38 +3,54 @@
 #include <vulkan/vulkan.h>
 #include <iostream>
 #include <array>
+#include <vector>
+#include <cstddef>
 
 #include "VertexData.h"
 
 namespace Victory 
 {
-    static VkVertexInputBindingDescription GetBindingDescription() 
+    struct VertexAttributeLayout
+    {
+        VkFormat format;
+        uint32_t offset;
+    };
+
+    // Interleaved vertices in binding 0, attribute i is read from location i
+    struct VertexLayout
+    {
+        uint32_t stride;
+        std::vector<VertexAttributeLayout> attributes;
+    };
+
+    // Vertex shaders dequantize, see VertexQuantization.h
+    inline VertexLayout GetPackedVertexLayout()
+    {
+        return VertexLayout{ sizeof(PackedVertex), {
+            { VK_FORMAT_R16G16B16A16_UNORM, offsetof(PackedVertex, position) },
+            { VK_FORMAT_R16G16_SFLOAT, offsetof(PackedVertex, texCoord) } } };
+    }
+
+    inline VkVertexInputBindingDescription GetBindingDescription(const VertexLayout& layout_) 
     {
         VkVertexInputBindingDescription bindingDescription{};
         bindingDescription.binding = 0;
-        bindingDescription.stride = sizeof(VertexData);
+        bindingDescription.stride = layout_.stride;
         bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
         return bindingDescription;
     }
 
-    static std::array<VkVertexInputAttributeDescription, 3> GetAttributeDescriptions() 
+    inline std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions(const VertexLayout& layout_) 
     {
-        std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
-        attributeDescriptions[0].binding = 0;
-        attributeDescriptions[0].location = 0;
-        attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[0].offset = 0;
-
-        attributeDescriptions[1].binding = 0;
-        attributeDescriptions[1].location = 1;
-        attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[1].offset = sizeof(float) * 3;
-
-        attributeDescriptions[2].binding = 0;
-        attributeDescriptions[2].location = 2;
-        attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-        attributeDescriptions[2].offset = sizeof(float) * 6;
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(layout_.attributes.size());
+        for (uint32_t i{ 0 }; i < attributeDescriptions.size(); ++i)
+        {
+            attributeDescriptions[i].binding = 0;
+            attributeDescriptions[i].location = i;
+            attributeDescriptions[i].format = layout_.attributes[i].format;
+            attributeDescriptions[i].offset = layout_.attributes[i].offset;
+        }
 
         return attributeDescriptions;
     }
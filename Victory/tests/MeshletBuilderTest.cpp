@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "MeshletBuilder.h"
+#include "VertexData.h"
+
+using namespace Victory;
+
+// Every face of the cube is a grid of s_GridSize x s_GridSize quads, edges share their vertices
+constexpr int s_GridSize{ 32 };
+
+static int s_Failures{ 0 };
+
+static void Check(bool condition_, const char* message_)
+{
+    if (!condition_)
+    {
+        std::cerr << "FAILED: " << message_ << std::endl;
+        ++s_Failures;
+    }
+}
+
+static void BuildCube(std::vector<VertexData>& vertices_, std::vector<uint32_t>& indices_)
+{
+    std::map<std::array<int, 3>, uint32_t> vertexMap;
+    const auto getVertex = [&](const std::array<int, 3>& point_)
+    {
+        const auto [it, inserted] { vertexMap.try_emplace(point_, static_cast<uint32_t>(vertices_.size())) };
+        if (inserted)
+        {
+            VertexData vertex{};
+            for (int axis{ 0 }; axis < 3; ++axis)
+            {
+                vertex.position[axis] = static_cast<float>(point_[axis]) / s_GridSize - 0.5f;
+            }
+            vertices_.push_back(vertex);
+        }
+        return it->second;
+    };
+
+    // Axis the face is perpendicular to and the side, corners wind counter clockwise from outside
+    for (int axis{ 0 }; axis < 3; ++axis)
+    {
+        for (int side{ 0 }; side < 2; ++side)
+        {
+            const int u{ (axis + (side ? 1 : 2)) % 3 };
+            const int v{ (axis + (side ? 2 : 1)) % 3 };
+            for (int y{ 0 }; y < s_GridSize; ++y)
+            {
+                for (int x{ 0 }; x < s_GridSize; ++x)
+                {
+                    std::array<uint32_t, 4> corners{};
+                    for (int corner{ 0 }; corner < 4; ++corner)
+                    {
+                        std::array<int, 3> point{};
+                        point[axis] = side * s_GridSize;
+                        point[u] = x + (corner == 1 || corner == 2);
+                        point[v] = y + (corner >= 2);
+                        corners[corner] = getVertex(point);
+                    }
+                    indices_.insert(indices_.end(), { corners[0], corners[1], corners[2], corners[0], corners[2], corners[3] });
+                }
+            }
+        }
+    }
+}
+
+static std::multiset<std::array<uint32_t, 3>> GetTriangles(const std::vector<uint32_t>& indices_)
+{
+    std::multiset<std::array<uint32_t, 3>> triangles;
+    for (size_t i{ 0 }; i < indices_.size(); i += 3)
+    {
+        triangles.insert({ indices_[i], indices_[i + 1], indices_[i + 2] });
+    }
+    return triangles;
+}
+
+int main()
+{
+    std::vector<VertexData> vertices;
+    std::vector<uint32_t> indices;
+    BuildCube(vertices, indices);
+
+    // Shuffled triangles leave nothing for a builder that follows the index order
+    std::vector<std::array<uint32_t, 3>> shuffled;
+    for (size_t i{ 0 }; i < indices.size(); i += 3)
+    {
+        shuffled.push_back({ indices[i], indices[i + 1], indices[i + 2] });
+    }
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937{ 1 });
+    indices.clear();
+    for (auto&& triangle : shuffled)
+    {
+        indices.insert(indices.end(), triangle.begin(), triangle.end());
+    }
+
+    const std::multiset<std::array<uint32_t, 3>> originalTriangles{ GetTriangles(indices) };
+
+    std::vector<Meshlet> meshlets;
+    BuildMeshlets(vertices, indices, 0, static_cast<uint32_t>(indices.size()), meshlets);
+
+    Check(GetTriangles(indices) == originalTriangles, "every triangle is kept exactly once");
+
+    uint32_t nextIndex{ 0 };
+    uint32_t conedMeshlets{ 0 };
+    float cutoffSum{ 0.f };
+    for (auto&& meshlet : meshlets)
+    {
+        Check(meshlet.firstIndex == nextIndex, "meshlets cover the range back to back");
+        Check(meshlet.indexCount > 0 && meshlet.indexCount % 3 == 0, "meshlets hold whole triangles");
+        Check(meshlet.indexCount / 3 <= s_MeshletMaxTriangles, "meshlets respect the triangle limit");
+        nextIndex = meshlet.firstIndex + meshlet.indexCount;
+
+        const std::set<uint32_t> meshletVertices(indices.begin() + meshlet.firstIndex, indices.begin() + nextIndex);
+        Check(meshletVertices.size() <= s_MeshletMaxVertices, "meshlets respect the vertex limit");
+
+        conedMeshlets += meshlet.cone.w < 1.f;
+        cutoffSum += meshlet.cone.w;
+    }
+    Check(nextIndex == indices.size(), "meshlets cover the whole range");
+
+    // Most meshlets stay on one face, their normals agree and the cutoff is near zero
+    const float meshletCount{ static_cast<float>(meshlets.size()) };
+    const float averageCutoff{ cutoffSum / meshletCount };
+    std::cout << meshlets.size() << " meshlets, " << conedMeshlets << " with a cone, average cutoff "
+        << averageCutoff << std::endl;
+    Check(static_cast<float>(conedMeshlets) >= meshletCount * 0.9f, "at least 90% of the meshlets have a cone");
+    Check(averageCutoff <= 0.25f, "the average cone cutoff is at most 0.25");
+    Check(meshletCount <= static_cast<float>(shuffled.size()) / s_MeshletMaxTriangles * 1.5f, "meshlets are reasonably full");
+
+    return s_Failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}